@@ -0,0 +1,35 @@
+#ifndef CELL_LOD_GLSL
+#define CELL_LOD_GLSL
+
+// Cell draw detail levels, nearest first; mirrors World::cell_lod_count. CellCull.comp picks
+// one per visible cell and each level is its own indirect draw with its own shape.
+const uint CELL_LOD_MESH = 0u;       // World::_cube
+const uint CELL_LOD_BOX = 1u;        // World::_cell_box, 12 triangles
+const uint CELL_LOD_BILLBOARD = 2u;  // World::_cell_billboard, camera-facing quad
+const uint CELL_LOD_COUNT = 3u;
+
+// Projected radius (NDC, vertical) below which a cell drops to the next level.
+const float CELL_LOD_BOX_BELOW = 0.020f;
+const float CELL_LOD_BILLBOARD_BELOW = 0.006f;
+
+// Needs ParameterUBO.glsl. Detail level for a bounding sphere in model space.
+uint cell_lod(vec3 center, float radius) {
+    float depth = max(-(ubo.view * ubo.model * vec4(center, 1.0f)).z, 1e-3f);
+    float projected = radius * abs(ubo.projection[1][1]) / depth;
+    if (projected < CELL_LOD_BILLBOARD_BELOW) {
+        return CELL_LOD_BILLBOARD;
+    }
+    return projected < CELL_LOD_BOX_BELOW ? CELL_LOD_BOX : CELL_LOD_MESH;
+}
+
+// Model-space offset of a billboard corner (xy of the quad, +-0.5) facing the camera, and
+// the normal it is lit with.
+vec3 cell_billboard_offset(vec2 corner, out vec3 normal) {
+    mat3 modelView = mat3(ubo.view * ubo.model);
+    vec3 right = vec3(modelView[0][0], modelView[1][0], modelView[2][0]);
+    vec3 up = vec3(modelView[0][1], modelView[1][1], modelView[2][1]);
+    normal = vec3(modelView[0][2], modelView[1][2], modelView[2][2]);
+    return right * corner.x + up * corner.y;
+}
+
+#endif
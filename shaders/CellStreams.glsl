@@ -0,0 +1,44 @@
+#ifndef CELL_STREAMS_GLSL
+#define CELL_STREAMS_GLSL
+
+#extension GL_EXT_shader_8bit_storage : require
+
+// Structure-of-arrays cell storage; mirrors World::CellStreams.
+// Each stream has an in/out binding pair that swaps every frame:
+//   position (xyz, w = size) 1/2, color 6/7, states 8/9, alive 10/11.
+// The alive stream is one byte per cell: 0 = dead, otherwise 1 + target code, where the
+// code is (dy + 4) * 9 + (dx + 4) for a target within radius 4, or 81 for no target.
+
+const uint CELL_ALIVE_DEAD = 0u;
+const int CELL_TARGET_RADIUS = 4;
+const uint CELL_NO_TARGET = 81u;
+
+uint cell_alive_code(bool isAlive, int targetIndex, uint selfIndex, uint gridWidth) {
+    if (!isAlive) {
+        return CELL_ALIVE_DEAD;
+    }
+    if (targetIndex < 0) {
+        return CELL_NO_TARGET + 1u;
+    }
+
+    ivec2 offset = ivec2(uint(targetIndex) % gridWidth, uint(targetIndex) / gridWidth) -
+                   ivec2(selfIndex % gridWidth, selfIndex / gridWidth);
+    if (any(greaterThan(abs(offset), ivec2(CELL_TARGET_RADIUS)))) {
+        return CELL_NO_TARGET + 1u;
+    }
+    ivec2 biased = offset + ivec2(CELL_TARGET_RADIUS);
+    return uint(biased.y * (2 * CELL_TARGET_RADIUS + 1) + biased.x) + 1u;
+}
+
+bool cell_target_offset(uint aliveCode, out ivec2 offset) {
+    offset = ivec2(0);
+    if (aliveCode == CELL_ALIVE_DEAD || aliveCode - 1u == CELL_NO_TARGET) {
+        return false;
+    }
+    uint code = aliveCode - 1u;
+    uint span = uint(2 * CELL_TARGET_RADIUS + 1);
+    offset = ivec2(int(code % span), int(code / span)) - ivec2(CELL_TARGET_RADIUS);
+    return true;
+}
+
+#endif
@@ -5,11 +5,13 @@ layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec3 inVertex;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec4 inColor;
-layout(location = 4) in ivec4 inStates;
+layout(location = 4) in uint inCellIndex;   // grid index of this visible cell, see VisibleCells.glsl
+layout(location = 5) in uint inLod;         // detail level the shape was drawn for, see CellLod.glsl
 
 #define UBO_LIGHT_NAME light
 #include "ParameterUBO.glsl"
-#include "TerrainField.glsl"
+#include "TerrainSurface.glsl"
+#include "CellLod.glsl"
 
 layout(location = 0) out vec4 fragColor;
 
@@ -39,30 +41,24 @@ vec2 grid_base_position(uint cellIndex) {
 }
 
 void main() {
-    bool aliveCell = (inStates.x == 1);
-    if (!aliveCell) {
-        fragColor = vec4(0.0f);
-        gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
-        return;
-    }
-
+    // Only alive cells on dry land reach here: CellCull.comp compacts the instance list.
     // Static cells: anchored to grid position, size from SSBO (grows/shrinks)
-    vec2 anchoredXY = grid_base_position(gl_InstanceIndex);
-
-    if (terrain_height(anchoredXY) <= ubo.waterThreshold + ubo.waterRules.x) {
-        fragColor = vec4(0.0f);
-        gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
-        return;
-    }
+    vec2 anchoredXY = grid_base_position(inCellIndex);
 
     vec3 cellBase = vec3(anchoredXY, inPosition.z);
     float cellScale = max(inPosition.w * 1.20f, ubo.cellSize * 0.85f);
     float lift = max(cellScale * 0.52f, 0.08f);
-    cellBase.z += terrain_height(anchoredXY) + lift;
+    cellBase.z += terrain_surface_at(anchoredXY).w + lift;
 
-    vec4 position = vec4(cellBase + (inVertex.xyz * cellScale), 1.0f);
+    // Far cells are a quad turned to the camera; its xy are the corners.
+    vec3 normal = inNormal;
+    vec3 offset = inVertex.xyz;
+    if (inLod == CELL_LOD_BILLBOARD) {
+        offset = cell_billboard_offset(inVertex.xy, normal);
+    }
+    vec4 position = vec4(cellBase + (offset * cellScale), 1.0f);
 #ifdef CE_DEBUG_ENABLE_CELL_INSTANCE_VERTEX_SANITIZATION_GUARDS
-    if (bad_vec3(cellBase) || bad_vec3(inVertex) || bad_vec4(position) || bad_vec3(inNormal)) {
+    if (bad_vec3(cellBase) || bad_vec3(inVertex) || bad_vec4(position) || bad_vec3(normal)) {
         fragColor = vec4(0.0f);
         gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
         return;
@@ -78,7 +74,7 @@ void main() {
 #endif
 
     vec4 viewPosition = ubo.view * worldPosition;
-    vec3 worldNormal = safe_normalize(mat3(ubo.model) * inNormal.xyz, vec3(0.0f, 0.0f, 1.0f));
+    vec3 worldNormal = safe_normalize(mat3(ubo.model) * normal, vec3(0.0f, 0.0f, 1.0f));
 
     vec3 lightDirection = safe_normalize(ubo.light.rgb - worldPosition.xyz, vec3(0.0f, 0.0f, 1.0f));
     float diffuse = max(dot(worldNormal, lightDirection), 0.0f);
@@ -5,11 +5,12 @@ layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec3 inVertex;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec4 inColor;
-layout(location = 4) in ivec4 inStates;
+layout(location = 5) in uint inLod;   // detail level the shape was drawn for, see CellLod.glsl
 
 #define UBO_LIGHT_NAME light
 #include "ParameterUBO.glsl"
-#include "TerrainField.glsl"
+#include "TerrainSurface.glsl"
+#include "CellLod.glsl"
 
 layout(location = 0) out vec4 fragColor;
 
@@ -32,14 +33,9 @@ bool bad_vec4(vec4 v) {
 }
 
 void main() {
-    bool aliveCell = (inStates.x == 1);
-    if (!aliveCell) {
-        fragColor = vec4(0.0f);
-        gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
-        return;
-    }
-
-    if (terrain_height(inPosition.xy) <= ubo.waterThreshold + ubo.waterRules.x) {
+    // Dead cells never reach here (CellCull.comp); the follower can still stray over water.
+    float terrainHeight = terrain_surface_height(inPosition.xy);
+    if (terrainHeight <= ubo.waterThreshold + ubo.waterRules.x) {
         fragColor = vec4(0.0f);
         gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
         return;
@@ -51,11 +47,17 @@ void main() {
 
     float cellLift = max(followerScale * 0.52f, 0.08f);
     float followerCenterLift = cellLift;
-    followerBase.z += terrain_height(inPosition.xy) + followerCenterLift;
+    followerBase.z += terrainHeight + followerCenterLift;
 
-    vec4 position = vec4(followerBase + (inVertex.xyz * followerScale), 1.0f);
+    // Far cells are a quad turned to the camera; its xy are the corners.
+    vec3 normal = inNormal;
+    vec3 offset = inVertex.xyz;
+    if (inLod == CELL_LOD_BILLBOARD) {
+        offset = cell_billboard_offset(inVertex.xy, normal);
+    }
+    vec4 position = vec4(followerBase + (offset * followerScale), 1.0f);
 #ifdef CE_DEBUG_ENABLE_CELL_INSTANCE_VERTEX_SANITIZATION_GUARDS
-    if (bad_vec3(followerBase) || bad_vec3(inVertex) || bad_vec4(position) || bad_vec3(inNormal)) {
+    if (bad_vec3(followerBase) || bad_vec3(inVertex) || bad_vec4(position) || bad_vec3(normal)) {
         fragColor = vec4(0.0f);
         gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
         return;
@@ -73,7 +75,7 @@ void main() {
 
     vec4 viewPosition = ubo.view * worldPosition;
 
-    vec3 localNormal = safe_normalize(inNormal.xyz, vec3(0.0f, 0.0f, 1.0f));
+    vec3 localNormal = safe_normalize(normal, vec3(0.0f, 0.0f, 1.0f));
     vec3 fixedLightDir = safe_normalize(vec3(0.35f, 0.45f, 0.82f), vec3(0.0f, 0.0f, 1.0f));
     float ndotl = max(dot(localNormal, fixedLightDir), 0.0f);
     float stableShade = 0.28f + ndotl * 0.72f;
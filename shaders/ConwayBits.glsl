@@ -0,0 +1,23 @@
+#ifndef CONWAY_BITS_GLSL
+#define CONWAY_BITS_GLSL
+
+// Bit-packed occupancy grid for the Conway pipelines, 32 cells per word along x.
+// Bit b of word (wx, y) is cell (wx * 32 + b, y). The buffer holds two grids back to back:
+// ConwayPack fills the first, Conway steps it into the second, ConwayUnpack expands that.
+
+layout(std430, binding = 12) buffer ConwayBitsSSBO { uint conwayBits[]; };
+
+uint conway_row_words(uint gridWidth) {
+    return (gridWidth + 31u) / 32u;
+}
+
+// Valid-cell mask for a word; zero padding bits must stay zero so they never count as neighbours.
+uint conway_word_mask(uint wordX, uint gridWidth) {
+    uint first = wordX * 32u;
+    if (first + 32u <= gridWidth) {
+        return 0xffffffffu;
+    }
+    return first >= gridWidth ? 0u : (1u << (gridWidth - first)) - 1u;
+}
+
+#endif
@@ -1,86 +1,17 @@
 #version 450
+#extension GL_GOOGLE_include_directive : enable
 
 layout(location = 0) in vec3 inPosition;
 
-layout (binding = 0) uniform ParameterUBO {
-    vec4 light;
-    ivec2 gridXY;
-    float waterThreshold;
-    float cellSize;
-    vec4 waterRules;
-    mat4 model;
-    mat4 view;
-    mat4 projection;
-} ubo;
-
-float hash21(vec2 p) {
-    return fract(sin(dot(p, vec2(127.1f, 311.7f))) * 43758.5453f);
-}
-
-float noise2(vec2 p) {
-    vec2 i = floor(p);
-    vec2 f = fract(p);
-    float a = hash21(i);
-    float b = hash21(i + vec2(1.0f, 0.0f));
-    float c = hash21(i + vec2(0.0f, 1.0f));
-    float d = hash21(i + vec2(1.0f, 1.0f));
-    vec2 u = f * f * (3.0f - 2.0f * f);
-    return mix(mix(a, b, u.x), mix(c, d, u.x), u.y);
-}
-
-float fbm(vec2 p) {
-    float value = 0.0f;
-    float amplitude = 0.5f;
-    for (int i = 0; i < 5; ++i) {
-        value += amplitude * noise2(p);
-        p = p * 2.02f + vec2(11.5f, 7.2f);
-        amplitude *= 0.5f;
-    }
-    return value;
-}
-
-float ridged_fbm(vec2 p) {
-    float value = 0.0f;
-    float amplitude = 0.5f;
-    for (int i = 0; i < 5; ++i) {
-        float n = noise2(p);
-        float ridge = 1.0f - abs(2.0f * n - 1.0f);
-        value += ridge * amplitude;
-        p = p * 2.1f + vec2(9.2f, 3.4f);
-        amplitude *= 0.5f;
-    }
-    return value;
-}
-
-float terrain_height(vec2 p) {
-    mat2 rot = mat2(0.866f, -0.5f, 0.5f, 0.866f);
-    vec2 pr = rot * p;
-    vec2 q = pr * 0.065f;
-    vec2 warp = vec2(
-        fbm(q * 1.15f + vec2(4.0f, 1.7f)),
-        fbm(q * 1.15f + vec2(7.2f, 3.5f)));
-    q += warp * 0.75f;
-
-    float broad = fbm(q * 0.62f) * 3.6f;
-    float base = fbm(q * 1.05f) * 2.2f;
-    float ridge = ridged_fbm(q * 2.0f) * 4.2f;
-    float crags = pow(max(ridged_fbm(q * 4.7f), 0.0f), 1.8f) * 1.15f;
-    float macro = (sin(pr.x * 0.028f) + sin(pr.y * 0.024f)) * 0.85f;
-    float detail = fbm(q * 7.6f) * 0.26f;
-
-    float mountainMask = smoothstep(0.52f, 0.80f, ridged_fbm(q * 0.95f));
-    float habitableLowlands = broad + base + macro;
-    float mountainRelief = ridge + crags + detail;
-    float lowlandBias = -0.55f * (1.0f - mountainMask);
-
-    return habitableLowlands + mountainRelief * mountainMask + lowlandBias + 1.35f;
-}
+#define UBO_LIGHT_NAME light
+#include "ParameterUBO.glsl"
+#include "TerrainSurface.glsl"
 
 layout(location = 0) out vec3 outWorldPos;
 
 void main() {
-    vec2 p = inPosition.xy;
-    float height = terrain_height(p);
+    // The top ring is the landscape mesh's boundary, so it sits on the baked lattice.
+    float height = terrain_surface_at(inPosition.xy).w;
 
     float baseSurfaceZ = ubo.waterRules.w;
      float surfaceEpsilon = max(ubo.cellSize * 0.25f, 0.001f);
@@ -0,0 +1,24 @@
+#ifndef TERRAIN_FIELD_BUFFER_GLSL
+#define TERRAIN_FIELD_BUFFER_GLSL
+
+// Per-cell terrain data baked once at startup by TerrainBake.comp and TerrainJumpFlood.comp.
+// Terrain and water rules are static, so the simulation reads this instead of evaluating FBM.
+// The buffer holds two grids back to back; jump flood passes ping-pong between them and
+// always finish in the first one, which is what the simulation reads.
+struct TerrainSample {
+    float height;
+    uint flags;
+    int nearestShore;   // grid index of the closest shoreline cell, -1 if none exists
+    int nearestLand;    // grid index of the closest dry cell, -1 if none exists
+};
+
+const uint TERRAIN_UNDERWATER = 1u;
+const uint TERRAIN_SHORELINE  = 2u;
+
+#ifndef TERRAIN_FIELD_ACCESS
+#define TERRAIN_FIELD_ACCESS readonly
+#endif
+
+layout(std430, binding = 5) TERRAIN_FIELD_ACCESS buffer TerrainFieldSSBO { TerrainSample terrainField[]; };
+
+#endif
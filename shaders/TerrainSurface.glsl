@@ -0,0 +1,45 @@
+#ifndef TERRAIN_SURFACE_GLSL
+#define TERRAIN_SURFACE_GLSL
+
+// Terrain height and normal at every vertex of the landscape mesh (the grid refined by
+// terrain_render_subdivisions), baked once at startup by TerrainSurfaceBake.comp. Terrain is
+// static, so vertex shaders read this instead of evaluating terrain_height() per vertex.
+// Needs ParameterUBO.glsl.
+
+#ifndef TERRAIN_SURFACE_ACCESS
+#define TERRAIN_SURFACE_ACCESS readonly
+#endif
+
+layout(std430, binding = 14) TERRAIN_SURFACE_ACCESS buffer TerrainSurfaceSSBO {
+    uvec4 terrainSurfaceInfo;   // x = subdivisions per grid cell, yz = lattice width/height
+    vec4 terrainSurface[];      // xyz = normal, w = height; row-major over the lattice
+};
+
+// Lattice coordinates of a model-space xy, clamped to the terrain.
+vec2 terrain_surface_lattice(vec2 p) {
+    vec2 gridMin = (vec2(ubo.gridXY) - vec2(1.0f)) * -0.5f;
+    vec2 lastPoint = vec2(terrainSurfaceInfo.yz - uvec2(1u));
+    return clamp((p - gridMin) * float(terrainSurfaceInfo.x), vec2(0.0f), lastPoint);
+}
+
+// Mesh vertices and grid cells sit on the lattice: a single fetch.
+vec4 terrain_surface_at(vec2 p) {
+    uvec2 point = uvec2(terrain_surface_lattice(p) + vec2(0.5f));
+    return terrainSurface[point.y * terrainSurfaceInfo.y + point.x];
+}
+
+// Anywhere else: bilinear between the four surrounding lattice points.
+float terrain_surface_height(vec2 p) {
+    vec2 lattice = terrain_surface_lattice(p);
+    uvec2 p0 = uvec2(lattice);
+    uvec2 p1 = min(p0 + uvec2(1u), terrainSurfaceInfo.yz - uvec2(1u));
+    vec2 f = lattice - vec2(p0);
+    uint width = terrainSurfaceInfo.y;
+    float h00 = terrainSurface[p0.y * width + p0.x].w;
+    float h10 = terrainSurface[p0.y * width + p1.x].w;
+    float h01 = terrainSurface[p1.y * width + p0.x].w;
+    float h11 = terrainSurface[p1.y * width + p1.x].w;
+    return mix(mix(h00, h10, f.x), mix(h01, h11, f.x), f.y);
+}
+
+#endif
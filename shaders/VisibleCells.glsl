@@ -0,0 +1,30 @@
+#ifndef VISIBLE_CELLS_GLSL
+#define VISIBLE_CELLS_GLSL
+
+#include "CellLod.glsl"
+
+// Compacted cell draw list, rebuilt every frame by CellCull.comp; mirrors World::VisibleCell
+// and VulkanResources::VisibleCellsBuffer. The head holds one VkDrawIndirectCommand per
+// detail level; the entries of level N start at lodDraws[N].firstInstance.
+struct VisibleCell {
+    vec4 position;
+    vec4 color;
+    uint cellIndex;
+    uint lod;
+};
+
+struct DrawIndirectCommand {
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+layout(std430, binding = 13) buffer VisibleCellsSSBO {
+    DrawIndirectCommand lodDraws[CELL_LOD_COUNT];
+    // Entries per level, counted by the first cull pass; padded to 16 bytes.
+    uint lodTotals[4];
+    VisibleCell visibleCells[];
+};
+
+#endif
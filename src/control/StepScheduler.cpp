@@ -0,0 +1,79 @@
+#include "StepScheduler.h"
+#include "Timer.h"
+#include "engine/Log.h"
+#include "world/RuntimeConfig.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+StepScheduler::StepScheduler(const bool headless)
+    : max_steps_per_frame_(std::max(CE::Runtime::env_uint(CE::Runtime::kEnvMaxStepsPerFrame,
+                                                          CE::Runtime::kDefaultMaxStepsPerFrame),
+                                    1u)) {
+  // Step hashes are only comparable between runs that step every hour regardless of wall
+  // time; real-time mode drops hours whenever a frame runs late.
+  const char *verify_hashes = std::getenv(CE::Runtime::kEnvVerifyHashes);
+  const bool deterministic = verify_hashes && *verify_hashes != '\0';
+  if (headless) {
+    mode_ = Mode::Manual;
+  } else if (CE::Runtime::env_flag_enabled(CE::Runtime::kEnvFastForward)) {
+    mode_ = Mode::FastForward;
+  } else if (deterministic) {
+    mode_ = Mode::FastForward;
+    Log::text("{ SIM }", "CE_VERIFY_HASHES set: fast-forward instead of real-time stepping");
+  }
+
+  Log::text("{ SIM }",
+            "Step scheduler",
+            mode_ == Mode::FastForward ? "fast-forward"
+            : mode_ == Mode::Manual    ? "manual"
+                                       : "real-time",
+            "max steps/frame",
+            mode_ == Mode::FastForward ? fast_forward_limit : max_steps_per_frame_);
+}
+
+StepScheduler::Batch StepScheduler::next_batch(Timer &time) {
+  if (mode_ == Mode::FastForward) {
+    const uint64_t first_hour = time.passed_hours + 1;
+    time.advance_hours(steps_per_frame_);
+    time.take_pending_hours();
+    return Batch{.first_hour = first_hour, .count = steps_per_frame_};
+  }
+
+  if (mode_ == Mode::RealTime) {
+    time.run();
+  }
+
+  const uint64_t pending = time.take_pending_hours();
+  if (pending == 0) {
+    return Batch{};
+  }
+
+  // Past the cap the oldest hours are skipped rather than queued, so a slow frame never
+  // snowballs into ever larger batches. Engine.comp tolerates hour gaps.
+  uint64_t count = pending;
+  if (mode_ == Mode::RealTime && count > max_steps_per_frame_) {
+    const uint64_t dropped = count - max_steps_per_frame_;
+    if (dropped_hours_ == 0) {
+      Log::text("{ SIM }", "Simulation behind real time, skipping", dropped, "hours");
+    }
+    dropped_hours_ += dropped;
+    count = max_steps_per_frame_;
+  }
+
+  steps_per_frame_ = static_cast<uint32_t>(count);
+  return Batch{.first_hour = time.passed_hours - count + 1, .count = steps_per_frame_};
+}
+
+void StepScheduler::report_compute_wait(const double wait_ms) {
+  if (mode_ != Mode::FastForward) {
+    return;
+  }
+
+  // Additive increase while the GPU idles, multiplicative decrease once the CPU stalls on it.
+  if (wait_ms > back_pressure_ms) {
+    steps_per_frame_ = std::max(1u, steps_per_frame_ - steps_per_frame_ / 4);
+  } else if (wait_ms < idle_ms) {
+    steps_per_frame_ = std::min(fast_forward_limit, steps_per_frame_ + std::max(1u, steps_per_frame_ / 8));
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Fixed-timestep simulation scheduler layered on Timer.
+// Exists to decouple how many simulation steps a compute submission records from the frame rate.
+#include <cstdint>
+
+class Timer;
+
+class StepScheduler {
+public:
+  enum class Mode : uint8_t {
+    // One step per simulated hour of wall time, capped per frame.
+    RealTime,
+    // As many steps per frame as the GPU sustains; adapts to compute back-pressure.
+    FastForward,
+    // The caller advances Timer (headless runs); every accrued hour is stepped.
+    Manual,
+  };
+
+  struct Batch {
+    uint64_t first_hour{0};
+    uint32_t count{0};
+  };
+
+  explicit StepScheduler(bool headless);
+  StepScheduler(const StepScheduler &) = delete;
+  StepScheduler &operator=(const StepScheduler &) = delete;
+  StepScheduler(StepScheduler &&) = delete;
+  StepScheduler &operator=(StepScheduler &&) = delete;
+
+  // Advances the timer as the mode requires and returns the steps for the next submission.
+  Batch next_batch(Timer &time);
+  // CPU time spent waiting on the previous compute submission of the same frame slot.
+  void report_compute_wait(double wait_ms);
+
+  Mode mode() const {
+    return mode_;
+  }
+  uint32_t steps_per_frame() const {
+    return steps_per_frame_;
+  }
+
+private:
+  static constexpr uint32_t fast_forward_limit = 4096;
+  // Waits above this mean the GPU is behind; below the lower bound it is idle between frames.
+  static constexpr double back_pressure_ms = 0.5;
+  static constexpr double idle_ms = 0.05;
+
+  Mode mode_{Mode::RealTime};
+  uint32_t max_steps_per_frame_{8};
+  uint32_t steps_per_frame_{1};
+  uint64_t dropped_hours_{0};
+};
@@ -35,3 +35,38 @@ void Timer::run() {
   const float total_hours = static_cast<float>(passed_hours % hours_per_day) + hour_accumulator;
   day_fraction = total_hours / static_cast<float>(hours_per_day);
 }
+
+void Timer::advance_hours(const uint64_t hours) {
+  passed_hours += hours;
+
+  const float total_hours = static_cast<float>(passed_hours % hours_per_day) + hour_accumulator;
+  day_fraction = total_hours / static_cast<float>(hours_per_day);
+}
+
+uint64_t Timer::take_pending_hours() {
+  const uint64_t pending = passed_hours - taken_hours;
+  taken_hours = passed_hours;
+  return pending;
+}
+
+float Timer::day_fraction_at(const uint64_t hour) const {
+  const float total_hours = static_cast<float>(hour % hours_per_day) + hour_accumulator;
+  return total_hours / static_cast<float>(hours_per_day);
+}
+
+float Timer::whole_hour_day_fraction(const uint64_t hour) const {
+  return static_cast<float>(hour % hours_per_day) / static_cast<float>(hours_per_day);
+}
+
+float Timer::get_hour_accumulator() const {
+  return hour_accumulator;
+}
+
+void Timer::restore(const uint64_t hours, const float accumulator) {
+  passed_hours = hours;
+  taken_hours = hours;
+  hour_accumulator = accumulator;
+
+  const float total_hours = static_cast<float>(passed_hours % hours_per_day) + hour_accumulator;
+  day_fraction = total_hours / static_cast<float>(hours_per_day);
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 // Frame/runtime time utility used by simulation and shader push constants.
 // Exists to centralize time-scale and day-cycle progression semantics.
 #include <cstdint>
@@ -11,13 +13,26 @@ public:
   uint64_t passed_hours{0};
 
   void run();
+  // Advances simulated time by whole hours, independent of wall time.
+  void advance_hours(uint64_t hours);
+  // Hours accrued since the previous call; each one is one simulation step.
+  uint64_t take_pending_hours();
   float get_day_fraction() const;
+  // Day fraction as it reads at the given hour, with the current sub-hour remainder.
+  float day_fraction_at(uint64_t hour) const;
+  // Day fraction at the start of the given hour; depends on the hour alone.
+  float whole_hour_day_fraction(uint64_t hour) const;
+  // Sub-hour remainder not yet turned into a step.
+  float get_hour_accumulator() const;
+  // Resumes at a checkpointed time; hours up to passed_hours count as already stepped.
+  void restore(uint64_t hours, float accumulator);
 
 private:
   float speed{1.0f};
   float day_fraction{0.0f};
   static constexpr int hours_per_day{24};
   float hour_accumulator{0.0f};
+  uint64_t taken_hours{0};
   bool initialized{false};
   std::chrono::steady_clock::time_point last_update_time{};
 };
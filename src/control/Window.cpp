@@ -1,12 +1,15 @@
 #include "Window.h"
 
 #include "engine/Log.h"
+#include "world/RuntimeConfig.h"
 
 #include <array>
 #include <unordered_map>
 #include <vector>
 
-Window::Window() : framebuffer_resized{false}, window{nullptr} {
+Window::Window()
+    : framebuffer_resized{false}, window{nullptr},
+      headless{CE::Runtime::env_flag_enabled(CE::Runtime::kEnvHeadless)} {
   Log::log_title();
   Log::text("{ [-] }", "constructing Window");
   init_window();
@@ -16,11 +19,18 @@ Window::~Window() {
   Log::text("{ [-] }", "destructing Window");
   Log::log_footer();
 
+  if (headless) {
+    return;
+  }
   glfwDestroyWindow(window);
   glfwTerminate();
 }
 
 void Window::init_window() {
+  if (headless) {
+    Log::text("{ [*] }", "Headless mode, no window", display.width, "*", display.height);
+    return;
+  }
   glfwInit();
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
   window =
@@ -39,6 +49,9 @@ void Window::window_resize(GLFWwindow *win, int width, int height) {
 }
 
 void Window::poll_input() {
+  if (headless) {
+    return;
+  }
   glfwPollEvents();
   set_mouse();
 
@@ -55,11 +55,16 @@ public:
   bool is_escape_pressed() const {
     return escape_pressed;
   }
+  // Headless runs (CE_HEADLESS) never create a GLFW window; `window` stays null.
+  bool is_headless() const {
+    return headless;
+  }
   bool consume_screenshot_pressed();
   bool consume_left_click(glm::vec2 &normalized_position);
 
 private:
   void set_mouse();
+  bool headless{false};
   bool escape_pressed{false};
   bool screenshot_key_down{false};
   bool screenshot_pressed{false};
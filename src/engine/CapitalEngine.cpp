@@ -1,33 +1,39 @@
 #include "CapitalEngine.h"
 #include "engine/Log.h"
+#include "engine/Trace.h"
 #include "world/RuntimeConfig.h"
-#include "library/Screenshot.h"
 #include "control/Window.h"
 #include "control/gui.h"
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 
 CapitalEngine::CapitalEngine() {
+  Trace::set_thread_name("main");
   const CE::Runtime::TerrainSettings &terrain_settings = CE::Runtime::get_terrain_settings();
   resources = std::make_unique<VulkanResources>(mechanics, terrain_settings);
   pipelines = std::make_unique<Pipelines>(mechanics, *resources);
   frame_context = std::make_unique<FrameContext>(mechanics, *resources, *pipelines);
+  mechanics.main_device.allocator().log_statistics();
   
   Log::text(Log::Style::header_guard);
   Log::text("| CAPITAL Engine");
 }
 
 CapitalEngine::~CapitalEngine() {
+  Trace::finish();
   Log::text(Log::Style::header_guard);
   Log::text("| CAPITAL Engine");
   Log::text(Log::Style::header_guard);
 }
 
 void CapitalEngine::recreate_swapchain() {
+  Trace::Scope scope("swapchain recreate");
   mechanics.swapchain.recreate(mechanics.init_vulkan.surface,
                                mechanics.queues,
                                mechanics.sync_objects,
@@ -40,6 +46,13 @@ void CapitalEngine::main_loop() {
   Log::text("{ Main Loop }");
   Log::measure_elapsed_time();
 
+  if (Window::get().is_headless()) {
+    run_headless();
+    Log::measure_elapsed_time();
+    Log::text(Log::Style::header_guard);
+    return;
+  }
+
   auto frame_start = std::chrono::high_resolution_clock::now();
 
   CE::RenderGUI::log_stage_strip_tiles();
@@ -139,7 +152,7 @@ void CapitalEngine::main_loop() {
       }
     }
 
-    resources->world._time.run();
+    // Simulated time advances inside draw_frame via the StepScheduler.
     mechanics.main_device.maybe_log_gpu_runtime_sample();
 
     draw_frame();
@@ -157,6 +170,10 @@ void CapitalEngine::main_loop() {
         std::ostringstream title_stream;
         title_stream << base_window_title << " | FPS " << std::fixed << std::setprecision(1)
                      << fps << " | " << std::setprecision(2) << frame_ms << " ms";
+        const StepScheduler &scheduler = frame_context->scheduler();
+        if (scheduler.mode() == StepScheduler::Mode::FastForward) {
+          title_stream << " | " << scheduler.steps_per_frame() << " steps/frame";
+        }
         glfwSetWindowTitle(main_window.window, title_stream.str().c_str());
       }
 
@@ -209,12 +226,90 @@ void CapitalEngine::main_loop() {
     }
   }
   glfwSetWindowTitle(main_window.window, base_window_title.c_str());
+  if (resources->commands.checkpoints.enabled()) {
+    // One more frame carries the exit checkpoint of the newest state.
+    resources->commands.checkpoints.request();
+    draw_frame();
+  }
   vkDeviceWaitIdle(mechanics.main_device.logical_device);
+  resources->commands.screenshots.flush();
+  resources->commands.checkpoints.flush();
+  resources->commands.deltas.flush();
+  resources->commands.hashes.flush();
+  if (resources->commands.hashes.diverged()) {
+    throw std::runtime_error("\n!ERROR! Cell state diverged from step hashes in " +
+                             resources->commands.hashes.path());
+  }
 
   Log::measure_elapsed_time();
   Log::text(Log::Style::header_guard);
 }
 
+void CapitalEngine::run_headless() {
+  const uint32_t steps = CE::Runtime::env_uint(CE::Runtime::kEnvHeadlessSteps,
+                                               CE::Runtime::kDefaultHeadlessSteps);
+  const uint32_t steps_per_frame =
+      std::max(CE::Runtime::env_uint(CE::Runtime::kEnvHeadlessStepsPerFrame, 1), 1u);
+  Log::text("{ >>> }",
+            "Headless run",
+            steps,
+            "steps",
+            steps_per_frame,
+            "per frame",
+            mechanics.swapchain.extent.width,
+            "x",
+            mechanics.swapchain.extent.height);
+
+  // Whole simulated hours per frame regardless of wall time; the StepScheduler records one
+  // Engine step per hour, so larger batches trade rendered frames for simulation throughput.
+  // The screenshot and checkpoint are captured by the last frame itself, so the run ends on
+  // the state it rendered.
+  const bool final_screenshot =
+      steps > 0 && CE::Runtime::env_flag_enabled(CE::Runtime::kEnvStartupScreenshot);
+  const auto run_start = std::chrono::steady_clock::now();
+  uint32_t frames = 0;
+  for (uint32_t step = 0; step < steps; step += steps_per_frame) {
+    resources->world._time.advance_hours(std::min(steps_per_frame, steps - step));
+    mechanics.main_device.maybe_log_gpu_runtime_sample();
+    if (steps - step <= steps_per_frame) {
+      if (final_screenshot) {
+        take_screenshot("headless");
+      }
+      resources->commands.checkpoints.request();
+    }
+    draw_frame();
+    ++frames;
+  }
+  vkDeviceWaitIdle(mechanics.main_device.logical_device);
+  const double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - run_start)
+                                .count();
+
+  const double steps_per_second =
+      elapsed_ms > 0.0 ? static_cast<double>(steps) * 1000.0 / elapsed_ms : 0.0;
+  Log::text("{ PERF }",
+            "Headless",
+            steps,
+            "steps in",
+            elapsed_ms,
+            "ms",
+            steps_per_second,
+            "steps/s",
+            "frames",
+            frames,
+            "passed_hours",
+            resources->world._time.passed_hours);
+
+  resources->commands.screenshots.flush();
+  resources->commands.checkpoints.flush();
+  resources->commands.deltas.flush();
+  resources->commands.hashes.flush();
+  if (resources->commands.hashes.diverged()) {
+    throw std::runtime_error("\n!ERROR! Cell state diverged from step hashes in " +
+                             resources->commands.hashes.path());
+  }
+}
+
 void CapitalEngine::draw_frame() {
   frame_context->draw_frame(last_presented_image_index,
                             last_submitted_frame_index,
@@ -222,12 +317,6 @@ void CapitalEngine::draw_frame() {
 }
 
 void CapitalEngine::take_screenshot(const std::string &tag) {
-  vkWaitForFences(mechanics.main_device.logical_device,
-                  1,
-                  &mechanics.sync_objects.graphics_in_flight_fences[last_submitted_frame_index],
-                  VK_TRUE,
-                  UINT64_MAX);
-
   std::filesystem::path output_root = std::filesystem::current_path();
   if (!std::filesystem::exists(output_root / "CMakeLists.txt") &&
       std::filesystem::exists(output_root.parent_path() / "CMakeLists.txt")) {
@@ -259,10 +348,6 @@ void CapitalEngine::take_screenshot(const std::string &tag) {
   nameBuilder << ".png";
   const std::string filename = (screenshot_dir / nameBuilder.str()).string();
 
-  CE::Screenshot::capture(mechanics.swapchain.images[last_presented_image_index].image,
-                          mechanics.swapchain.extent,
-                          mechanics.swapchain.image_format,
-                          resources->commands.pool,
-                          mechanics.queues.graphics_queue,
-                          filename);
+  // Copied at the end of the next frame and encoded off-thread; never waits here.
+  resources->commands.screenshots.request(filename);
 }
@@ -32,5 +32,7 @@ private:
 
   void recreate_swapchain();
   void draw_frame();
+  void run_headless();
+  // Queues a capture of the next rendered frame.
   void take_screenshot(const std::string &tag = "");
 };
@@ -0,0 +1,269 @@
+#include "Trace.h"
+#include "Log.h"
+#include "world/RuntimeConfig.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t name_capacity = 48;
+// Per-thread ring; the writer drains every flush_period, so this only has to cover the
+// events of one period plus scheduling slack.
+constexpr uint64_t buffer_events = 8192;
+constexpr auto flush_period = std::chrono::milliseconds(50);
+constexpr uint32_t cpu_pid = 1;
+constexpr uint32_t gpu_pid = 2;
+
+struct Event {
+  double begin_us{0.0};
+  double duration_us{0.0};
+  Trace::Track track{Trace::Track::Thread};
+  uint8_t name_size{0};
+  std::array<char, name_capacity> name{};
+};
+
+// Single producer (the owning thread) and single consumer (the writer thread), so head and
+// tail are the only shared state.
+struct ThreadBuffer {
+  uint32_t tid{0};
+  std::string name{};
+  std::array<Event, buffer_events> events{};
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> tail{0};
+};
+
+class Writer {
+public:
+  Writer() {
+    const char *path = std::getenv(CE::Runtime::kEnvTraceFile);
+    if (!path || *path == '\0') {
+      return;
+    }
+    file_.open(path, std::ios::trunc);
+    if (!file_) {
+      Log::text("{ !!! }", "Trace: cannot write", path);
+      return;
+    }
+    // Microsecond timestamps with nanosecond fraction; default precision loses it after seconds.
+    file_ << std::fixed << std::setprecision(3);
+    file_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    write_metadata("process_name", cpu_pid, 0, "CPU");
+    write_metadata("process_name", gpu_pid, 0, "GPU");
+    write_metadata("thread_name", gpu_pid, static_cast<uint32_t>(Trace::Track::GpuCompute),
+                   "compute queue");
+    write_metadata("thread_name", gpu_pid, static_cast<uint32_t>(Trace::Track::GpuGraphics),
+                   "graphics queue");
+
+    epoch_ = Trace::Clock::now();
+    accepting_.store(true, std::memory_order_release);
+    thread_ = std::thread([this]() { run(); });
+    Log::text("{ PROF }", "Trace", path);
+  }
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+  Writer(Writer &&) = delete;
+  Writer &operator=(Writer &&) = delete;
+  ~Writer() {
+    finish();
+  }
+
+  bool accepting() const {
+    return accepting_.load(std::memory_order_acquire);
+  }
+  Trace::Clock::time_point epoch() const {
+    return epoch_;
+  }
+
+  // Registration is the only locked step, once per thread.
+  ThreadBuffer &local() {
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (!buffer) {
+      std::lock_guard<std::mutex> lock(registry_mutex_);
+      buffers_.push_back(std::make_unique<ThreadBuffer>());
+      buffer = buffers_.back().get();
+      buffer->tid = static_cast<uint32_t>(buffers_.size());
+    }
+    return *buffer;
+  }
+
+  void push(const Event &event) {
+    ThreadBuffer &buffer = local();
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= buffer_events) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    buffer.events[head % buffer_events] = event;
+    buffer.head.store(head + 1, std::memory_order_release);
+  }
+
+  void set_thread_name(std::string_view name) {
+    ThreadBuffer &buffer = local();
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    buffer.name = name;
+  }
+
+  void finish() {
+    if (!accepting_.exchange(false, std::memory_order_acq_rel)) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    drain();
+    for (const std::unique_ptr<ThreadBuffer> &buffer : buffers_) {
+      write_metadata("thread_name",
+                     cpu_pid,
+                     buffer->tid,
+                     buffer->name.empty() ? "thread " + std::to_string(buffer->tid)
+                                          : buffer->name);
+    }
+    file_ << "\n],\"otherData\":{\"dropped_events\":\""
+          << dropped_.load(std::memory_order_relaxed) << "\"}}\n";
+    file_.close();
+  }
+
+private:
+  std::ofstream file_{};
+  Trace::Clock::time_point epoch_{};
+  std::atomic<bool> accepting_{false};
+  std::atomic<uint64_t> dropped_{0};
+  bool first_event_{true};
+
+  std::mutex registry_mutex_{};
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_{};
+
+  std::mutex wake_mutex_{};
+  std::condition_variable wake_{};
+  bool stop_{false};
+  std::thread thread_{};
+
+  void run() {
+    std::unique_lock<std::mutex> wake_lock(wake_mutex_);
+    while (!stop_) {
+      wake_.wait_for(wake_lock, flush_period, [this]() { return stop_; });
+      std::lock_guard<std::mutex> lock(registry_mutex_);
+      drain();
+      file_.flush();
+    }
+  }
+
+  // Caller holds registry_mutex_.
+  void drain() {
+    for (const std::unique_ptr<ThreadBuffer> &buffer : buffers_) {
+      const uint64_t head = buffer->head.load(std::memory_order_acquire);
+      uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+      for (; tail < head; ++tail) {
+        write_event(buffer->events[tail % buffer_events], buffer->tid);
+      }
+      buffer->tail.store(tail, std::memory_order_release);
+    }
+  }
+
+  void separator() {
+    if (!first_event_) {
+      file_ << ",\n";
+    }
+    first_event_ = false;
+  }
+
+  void write_name(std::string_view name) {
+    file_ << '"';
+    for (const char c : name) {
+      if (c == '"' || c == '\\') {
+        file_ << '\\';
+      }
+      file_ << (static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+    }
+    file_ << '"';
+  }
+
+  void write_event(const Event &event, const uint32_t tid) {
+    const bool gpu = event.track != Trace::Track::Thread;
+    separator();
+    file_ << "{\"ph\":\"X\",\"cat\":\"" << (gpu ? "gpu" : "cpu") << "\",\"name\":";
+    write_name(std::string_view(event.name.data(), event.name_size));
+    file_ << ",\"pid\":" << (gpu ? gpu_pid : cpu_pid)
+          << ",\"tid\":" << (gpu ? static_cast<uint32_t>(event.track) : tid)
+          << ",\"ts\":" << event.begin_us << ",\"dur\":" << event.duration_us << '}';
+  }
+
+  void write_metadata(const char *kind,
+                      const uint32_t pid,
+                      const uint32_t tid,
+                      const std::string &name) {
+    separator();
+    file_ << "{\"ph\":\"M\",\"name\":\"" << kind << "\",\"pid\":" << pid << ",\"tid\":" << tid
+          << ",\"args\":{\"name\":";
+    write_name(name);
+    file_ << "}}";
+  }
+};
+
+Writer &writer() {
+  static Writer instance{};
+  return instance;
+}
+
+} // namespace
+
+bool Trace::enabled() {
+  return writer().accepting();
+}
+
+double Trace::to_us(const Clock::time_point &time) {
+  return std::chrono::duration<double, std::micro>(time - writer().epoch()).count();
+}
+
+double Trace::now_us() {
+  return to_us(Clock::now());
+}
+
+void Trace::complete(std::string_view name, const Clock::time_point &begin, const Clock::time_point &end) {
+  if (!enabled()) {
+    return;
+  }
+  complete(name, to_us(begin), std::chrono::duration<double, std::micro>(end - begin).count());
+}
+
+void Trace::complete(std::string_view name,
+                     const double begin_us,
+                     const double duration_us,
+                     const Track track) {
+  Writer &trace = writer();
+  if (!trace.accepting()) {
+    return;
+  }
+  Event event{.begin_us = begin_us, .duration_us = std::max(duration_us, 0.0), .track = track};
+  event.name_size = static_cast<uint8_t>(std::min(name.size(), name_capacity));
+  std::memcpy(event.name.data(), name.data(), event.name_size);
+  trace.push(event);
+}
+
+void Trace::set_thread_name(std::string_view name) {
+  Writer &trace = writer();
+  if (trace.accepting()) {
+    trace.set_thread_name(name);
+  }
+}
+
+void Trace::finish() {
+  writer().finish();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Chrome trace-event recorder for CPU scopes and GPU timestamp ranges (CE_TRACE_FILE).
+// Exists so frame timelines can be inspected in chrome://tracing or Perfetto without a capture tool.
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace Trace {
+using Clock = std::chrono::steady_clock;
+
+// Where an event is drawn: the recording CPU thread, or one of the GPU queue tracks.
+enum class Track : uint8_t { Thread = 0, GpuCompute = 1, GpuGraphics = 2 };
+
+bool enabled();
+// Microseconds on the trace clock.
+double to_us(const Clock::time_point &time);
+double now_us();
+
+// Appends to the calling thread's buffer without locking; drops the event if it is full.
+// Names longer than the event slot are truncated.
+void complete(std::string_view name, const Clock::time_point &begin, const Clock::time_point &end);
+void complete(std::string_view name,
+              const double begin_us,
+              const double duration_us,
+              const Track track = Track::Thread);
+void set_thread_name(std::string_view name);
+// Writes the remaining events and closes the JSON; runs at exit if not called earlier.
+void finish();
+
+// Records its own lifetime; name must outlive the scope.
+class Scope {
+public:
+  explicit Scope(std::string_view name)
+      : name_(name), begin_(enabled() ? Clock::now() : Clock::time_point{}) {}
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+  Scope(Scope &&) = delete;
+  Scope &operator=(Scope &&) = delete;
+  ~Scope() {
+    if (begin_ != Clock::time_point{}) {
+      complete(name_, begin_, Clock::now());
+    }
+  }
+
+private:
+  std::string_view name_;
+  Clock::time_point begin_;
+};
+
+} // namespace Trace
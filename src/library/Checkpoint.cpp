@@ -0,0 +1,318 @@
+#include "Checkpoint.h"
+
+#include "engine/Log.h"
+#include "engine/Trace.h"
+#include "world/RuntimeConfig.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace {
+
+static_assert(sizeof(CE::Checkpoint::Header) % 64 == 0);
+static_assert(std::is_trivially_copyable_v<CE::Checkpoint::Header>);
+
+template <typename T>
+void fnv1a(uint64_t &hash, const T value) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+  for (size_t i = 0; i < sizeof(value); ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+}
+
+// Only what the simulation sees of the terrain: the grid TerrainBake samples the height field
+// on, the cell size Engine.comp sizes cells with, and the height offset folded into the water
+// rules. Render-only settings (mesh subdivisions, box depth) may change between runs.
+uint64_t terrain_hash(const CE::Runtime::TerrainSettings &settings) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  fnv1a(hash, settings.grid_width);
+  fnv1a(hash, settings.grid_height);
+  fnv1a(hash, settings.cell_size);
+  fnv1a(hash, settings.absolute_height);
+  return hash;
+}
+
+} // namespace
+
+CE::Checkpoint::Checkpoint() {
+  const char *path = std::getenv(CE::Runtime::kEnvCheckpoint);
+  if (!path || *path == '\0') {
+    return;
+  }
+  path_ = path;
+  every_ = CE::Runtime::env_uint(CE::Runtime::kEnvCheckpointEvery, 0);
+  if (every_ > 0) {
+    Log::text("{ >>> }", "Checkpoint", path_, "every", every_, "hours and on exit");
+  } else {
+    Log::text("{ >>> }", "Checkpoint", path_, "on exit");
+  }
+}
+
+CE::Checkpoint::~Checkpoint() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+}
+
+bool CE::Checkpoint::restore_cells(const World::CellStreams &streams, void *destination) {
+  const char *path = std::getenv(CE::Runtime::kEnvCheckpointRestore);
+  if (!path || *path == '\0') {
+    return false;
+  }
+  const auto start = std::chrono::steady_clock::now();
+
+  std::ifstream file(path, std::ios::binary);
+  Header header{};
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    Log::text("{ !!! }", "Checkpoint restore: cannot read", path, "- seeding instead");
+    return false;
+  }
+
+  const CE::Runtime::TerrainSettings &terrain = CE::Runtime::get_terrain_settings();
+  const char *mismatch = nullptr;
+  if (header.magic != file_magic) {
+    mismatch = "not a checkpoint";
+  } else if (header.version != version || header.data_offset != sizeof(Header)) {
+    mismatch = "unsupported version";
+  } else if (header.cell_count != streams.cell_count ||
+             header.streams_size != streams.size ||
+             header.position_offset != streams.position_offset ||
+             header.color_offset != streams.color_offset ||
+             header.states_offset != streams.states_offset ||
+             header.alive_offset != streams.alive_offset) {
+    mismatch = "different grid size";
+  } else if (header.terrain_hash != terrain_hash(terrain)) {
+    mismatch = "different terrain settings";
+  }
+  if (mismatch) {
+    Log::text("{ !!! }", "Checkpoint restore:", path, mismatch, "- seeding instead");
+    return false;
+  }
+
+  file.seekg(static_cast<std::streamoff>(header.data_offset));
+  if (!file.read(static_cast<char *>(destination), static_cast<std::streamsize>(streams.size))) {
+    Log::text("{ !!! }", "Checkpoint restore:", path, "truncated - seeding instead");
+    return false;
+  }
+
+  restored_header_ = header;
+  restored_ = true;
+  Log::text("{ PERF }",
+            "Checkpoint restored",
+            path,
+            "hour",
+            header.passed_hours,
+            streams.size,
+            "bytes in",
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count(),
+            "ms");
+  return true;
+}
+
+void CE::Checkpoint::start_writer() {
+  if (!writer_.joinable()) {
+    stop_ = false;
+    writer_ = std::thread([this]() { run(); });
+  }
+}
+
+void CE::Checkpoint::request() {
+  if (enabled()) {
+    requested_ = true;
+  }
+}
+
+void CE::Checkpoint::record(VkCommandBuffer command_buffer,
+                            const uint32_t frame_index,
+                            const VkBuffer newest,
+                            const World::CellStreams &streams,
+                            const World &world) {
+  if (!enabled()) {
+    return;
+  }
+  const uint64_t hours = world._time.passed_hours;
+  if (every_ > 0) {
+    // The first call only arms the schedule; a run never checkpoints the state it began with.
+    const uint64_t mark = hours / every_;
+    if (periodic_mark_ != UINT64_MAX && mark > periodic_mark_) {
+      requested_ = true;
+    }
+    periodic_mark_ = mark;
+  }
+  // A request finding the previous checkpoint still being written waits for a later frame.
+  if (!requested_ || readback_.state.load(std::memory_order_acquire) != SlotState::Free) {
+    return;
+  }
+
+  if (readback_.capacity < streams.size) {
+    readback_.buffer = std::make_unique<BaseBuffer>();
+    BaseBuffer::create(streams.size,
+                       VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       *readback_.buffer);
+    readback_.buffer->map();
+    readback_.capacity = streams.size;
+  }
+
+  // The newest side was last written by an Engine step, SeedCells or the startup upload.
+  VkMemoryBarrier entry_barrier{};
+  entry_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  entry_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  entry_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       1,
+                       &entry_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+
+  const VkBufferCopy region{.srcOffset = 0, .dstOffset = 0, .size = streams.size};
+  vkCmdCopyBuffer(command_buffer, newest, readback_.buffer->buffer, 1, &region);
+
+  // Visible to the host once the submission's timeline value is reached; the next step's
+  // writes to the side wait for the copy's reads.
+  VkBufferMemoryBarrier host_barrier{};
+  host_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  host_barrier.buffer = readback_.buffer->buffer;
+  host_barrier.offset = 0;
+  host_barrier.size = streams.size;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                       0,
+                       0,
+                       nullptr,
+                       1,
+                       &host_barrier,
+                       0,
+                       nullptr);
+
+  const CE::Runtime::TerrainSettings &terrain = CE::Runtime::get_terrain_settings();
+  Header &header = readback_.header;
+  header = Header{};
+  header.magic = file_magic;
+  header.version = version;
+  header.data_offset = sizeof(Header);
+  header.grid_width = static_cast<uint32_t>(world._grid.size.x);
+  header.grid_height = static_cast<uint32_t>(world._grid.size.y);
+  header.seed_alive_cells = terrain.alive_cells;
+  header.hour_accumulator = world._time.get_hour_accumulator();
+  header.passed_hours = hours;
+  header.terrain_hash = terrain_hash(terrain);
+  header.cell_count = streams.cell_count;
+  header.position_offset = streams.position_offset;
+  header.color_offset = streams.color_offset;
+  header.states_offset = streams.states_offset;
+  header.alive_offset = streams.alive_offset;
+  header.streams_size = streams.size;
+  header.parameters = world._ubo;
+
+  readback_.frame_index = frame_index;
+  readback_.state.store(SlotState::Copying, std::memory_order_release);
+  requested_ = false;
+  Log::text("{ >>> }", "Checkpoint:", path_, "hour", hours);
+  start_writer();
+}
+
+void CE::Checkpoint::collect(const uint32_t frame_index) {
+  if (readback_.frame_index != frame_index ||
+      readback_.state.load(std::memory_order_acquire) != SlotState::Copying) {
+    return;
+  }
+  readback_.state.store(SlotState::Writing, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = true;
+  }
+  wake_.notify_one();
+}
+
+void CE::Checkpoint::flush() {
+  collect(readback_.frame_index);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+  if (requested_) {
+    Log::text("{ !!! }", "Checkpoint: request never recorded", path_);
+    requested_ = false;
+  }
+  if (enabled()) {
+    Log::text("{ PERF }",
+              "Checkpoints",
+              path_,
+              "written",
+              written_.load(std::memory_order_relaxed),
+              "failed",
+              failed_.load(std::memory_order_relaxed));
+  }
+}
+
+void CE::Checkpoint::run() {
+  Trace::set_thread_name("checkpoint writer");
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return stop_ || job_; });
+    // Stopping still writes what was handed over.
+    if (!job_) {
+      return;
+    }
+    job_ = false;
+    lock.unlock();
+
+    write(readback_);
+    readback_.state.store(SlotState::Free, std::memory_order_release);
+
+    lock.lock();
+  }
+}
+
+void CE::Checkpoint::write(const Readback &readback) {
+  Trace::Scope scope("checkpoint write");
+  // Written beside the target and renamed over it, so a crash mid-write never leaves the
+  // previous checkpoint truncated.
+  const std::string staging_path = path_ + ".tmp";
+  {
+    std::ofstream file(staging_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&readback.header), sizeof(Header));
+    file.write(static_cast<const char *>(readback.buffer->mapped),
+               static_cast<std::streamsize>(readback.header.streams_size));
+    if (!file) {
+      // Log is not thread safe; the writer reports failures straight to stderr.
+      std::cerr << "Failed to write checkpoint to: " << staging_path << '\n';
+      failed_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  std::error_code error{};
+  std::filesystem::rename(staging_path, path_, error);
+  if (error) {
+    std::cerr << "Failed to replace checkpoint " << path_ << ": " << error.message() << '\n';
+    failed_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  written_.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+// Binary checkpoints of the simulation state: cell streams, simulated time, UBO parameters.
+// Exists so a long run can be resumed without re-simulating it from SeedCells.
+#include <vulkan/vulkan.h>
+
+#include "vulkan_base/VulkanBaseDescriptor.h"
+#include "vulkan_base/VulkanBaseResources.h"
+#include "world/World.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace CE {
+
+// File layout: one Header, then the newest cell storage buffer byte for byte (the
+// World::CellStreams layout) starting at Header::data_offset. Every stream starts on a 64-byte
+// boundary of the file, so the arrays can be mmapped and read in place.
+//
+// Writing works like Screenshot: record() appends a copy of the newest side into a readback
+// buffer at the end of a compute submission, collect() hands it to a writer thread once that
+// submission completed. CE_CHECKPOINT names the file, CE_CHECKPOINT_EVERY adds one every n
+// simulated hours. Restoring (CE_CHECKPOINT_RESTORE) reads the streams straight into the
+// startup staging upload of both sides, so SeedCells never runs.
+class Checkpoint {
+public:
+  static constexpr std::array<char, 8> file_magic{'C', 'E', 'C', 'K', 'P', 'T', '\0', '\0'};
+  static constexpr uint32_t version = 2;
+
+  struct alignas(64) Header {
+    std::array<char, 8> magic{};
+    uint32_t version{0};
+    uint32_t data_offset{0};
+    uint32_t grid_width{0};
+    uint32_t grid_height{0};
+    // SeedCells derives its permutation seed from the grid size and this target.
+    uint32_t seed_alive_cells{0};
+    float hour_accumulator{0.0f};
+    uint64_t passed_hours{0};
+    // FNV-1a of the terrain settings the simulation reads; cells are only meaningful on the
+    // terrain they ran on.
+    uint64_t terrain_hash{0};
+    uint64_t cell_count{0};
+    // World::CellStreams offsets, relative to data_offset.
+    uint64_t position_offset{0};
+    uint64_t color_offset{0};
+    uint64_t states_offset{0};
+    uint64_t alive_offset{0};
+    uint64_t streams_size{0};
+    World::UniformBufferObject parameters{};
+  };
+
+  Checkpoint();
+  Checkpoint(const Checkpoint &) = delete;
+  Checkpoint &operator=(const Checkpoint &) = delete;
+  Checkpoint(Checkpoint &&) = delete;
+  Checkpoint &operator=(Checkpoint &&) = delete;
+  ~Checkpoint();
+
+  bool enabled() const {
+    return !path_.empty();
+  }
+  // Reads the CE_CHECKPOINT_RESTORE streams into destination (streams.size bytes). Returns
+  // false, logging why, when there is nothing to restore or the file does not match.
+  bool restore_cells(const World::CellStreams &streams, void *destination);
+  // Header of the checkpoint restore_cells() loaded, nullptr when the run was seeded.
+  const Header *restored() const {
+    return restored_ ? &restored_header_ : nullptr;
+  }
+
+  // Checkpoints the state the next compute submission leaves behind.
+  void request();
+  // Call after the submission's last cell write; newest is the side holding the newest state.
+  void record(VkCommandBuffer command_buffer,
+              const uint32_t frame_index,
+              const VkBuffer newest,
+              const World::CellStreams &streams,
+              const World &world);
+  // Call once the slot's previous compute submission has completed.
+  void collect(const uint32_t frame_index);
+  // Writes a checkpoint still in flight and stops the writer; the device must be idle.
+  void flush();
+
+private:
+  enum class SlotState : uint8_t { Free, Copying, Writing };
+
+  struct Readback {
+    std::unique_ptr<BaseBuffer> buffer{};
+    VkDeviceSize capacity{0};
+    std::atomic<SlotState> state{SlotState::Free};
+    uint32_t frame_index{0};
+    Header header{};
+  };
+
+  std::string path_{};
+  uint64_t every_{0};
+  // passed_hours / every_ as of the last record(); a checkpoint is due when it moves.
+  uint64_t periodic_mark_{UINT64_MAX};
+  bool requested_{false};
+  Readback readback_{};
+
+  Header restored_header_{};
+  bool restored_{false};
+
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> failed_{0};
+
+  std::mutex mutex_{};
+  std::condition_variable wake_{};
+  bool job_{false};
+  bool stop_{false};
+  std::thread writer_{};
+
+  void start_writer();
+  void run();
+  void write(const Readback &readback);
+};
+
+} // namespace CE
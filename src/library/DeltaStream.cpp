@@ -0,0 +1,459 @@
+#include "DeltaStream.h"
+
+#include "engine/Log.h"
+#include "engine/Trace.h"
+#include "world/RuntimeConfig.h"
+
+#ifdef CE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+constexpr std::array<char, 8> stream_magic{'C', 'E', 'D', 'E', 'L', 'T', 'A', '\0'};
+constexpr uint32_t stream_version = 1;
+constexpr uint8_t codec_raw = 0;
+constexpr uint8_t codec_zstd = 1;
+
+void put_varint(std::vector<uint8_t> &out, uint64_t value) {
+  while (value >= 0x80u) {
+    out.push_back(static_cast<uint8_t>(value | 0x80u));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t zigzag(const uint32_t value) {
+  const auto signed_value = static_cast<int32_t>(value);
+  return (value << 1) ^ static_cast<uint32_t>(signed_value >> 31);
+}
+
+// index, position.w bits, states.xyzw; both keyframes and steps carry the w bits XOR the
+// previous cell's, which is 0 (one byte) across runs of equally sized cells.
+void put_cell(std::vector<uint8_t> &out,
+              const uint32_t *states,
+              const uint32_t w,
+              uint32_t &w_previous) {
+  for (uint32_t component = 0; component < 4; ++component) {
+    put_varint(out, zigzag(states[component]));
+  }
+  put_varint(out, w ^ w_previous);
+  w_previous = w;
+}
+
+template <typename T>
+void put_raw(std::ofstream &stream, const T value) {
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+CE::DeltaStream::DeltaStream() {
+  const char *path = std::getenv(CE::Runtime::kEnvDeltaStream);
+  if (!path || *path == '\0') {
+    return;
+  }
+  path_ = path;
+  stream_.open(path_, std::ios::binary | std::ios::trunc);
+  if (!stream_) {
+    Log::text("{ !!! }", "Delta stream: cannot write", path_);
+    return;
+  }
+  keyframe_every_ = CE::Runtime::env_uint(CE::Runtime::kEnvDeltaKeyframeEvery,
+                                          CE::Runtime::kDefaultDeltaKeyframeEvery);
+  capacity_override_ = CE::Runtime::env_uint(CE::Runtime::kEnvDeltaCapacity, 0);
+  enabled_ = true;
+
+#ifdef CE_HAS_ZSTD
+  const char *codec = "zstd";
+#else
+  const char *codec = "raw";
+#endif
+  Log::text("{ >>> }",
+            "Delta stream",
+            path_,
+            "keyframe every",
+            keyframe_every_,
+            "hours",
+            codec,
+            "blocks");
+  writer_ = std::thread([this]() { run(); });
+}
+
+CE::DeltaStream::~DeltaStream() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+}
+
+uint32_t CE::DeltaStream::capacity(const size_t cell_count) const {
+  if (!enabled_) {
+    return 0;
+  }
+  if (capacity_override_ > 0) {
+    return capacity_override_;
+  }
+  // A quarter of the grid changing within one submission is far beyond a settled run; a
+  // step that does not fit costs a keyframe, not a wrong stream.
+  const size_t entries = std::max<size_t>(cell_count / 4, 1024);
+  return static_cast<uint32_t>(std::min<size_t>(entries, std::numeric_limits<uint32_t>::max()));
+}
+
+void CE::DeltaStream::begin(VkCommandBuffer command_buffer,
+                            const uint32_t frame_index,
+                            const BaseBuffer &log,
+                            const VkBuffer scratch,
+                            const uint32_t capacity,
+                            const uint32_t group_count,
+                            const uint64_t first_hour,
+                            const uint32_t step_count) {
+  log_mapped_ = static_cast<const uint32_t *>(log.mapped);
+  Slot &slot = slots_[frame_index];
+  slot.recorded = true;
+  slot.first_hour = first_hour;
+  slot.step_count = step_count;
+  slot.word_offset = frame_index * slot_words(capacity);
+
+  // The previous submission's passes are done with the scratch header before it is reset;
+  // the log slot was last read by the host, which collect() already waited for.
+  VkMemoryBarrier reuse_barrier{};
+  reuse_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  reuse_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  reuse_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       1,
+                       &reuse_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+
+  const std::array<uint32_t, head_words> head{0, 0, 0, capacity};
+  vkCmdUpdateBuffer(
+      command_buffer, log.buffer, slot.word_offset * sizeof(uint32_t), sizeof(head), head.data());
+  const std::array<uint32_t, scratch_head_words> scratch_head{
+      static_cast<uint32_t>(slot.word_offset), 0, group_count, 0};
+  vkCmdUpdateBuffer(command_buffer, scratch, 0, sizeof(scratch_head), scratch_head.data());
+
+  VkMemoryBarrier reset_barrier{};
+  reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       0,
+                       1,
+                       &reset_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
+
+void CE::DeltaStream::end(VkCommandBuffer command_buffer,
+                          const uint32_t frame_index,
+                          const VkBuffer newest,
+                          const World::CellStreams &streams,
+                          const World &world) {
+  Slot &slot = slots_[frame_index];
+  slot.sequence = next_sequence_++;
+  slot.keyframe = false;
+
+  const uint64_t hour = world._time.passed_hours;
+  if (keyframe_every_ > 0 && hour >= last_keyframe_hour_ + keyframe_every_) {
+    keyframe_due_ = true;
+  }
+  const bool keyframe =
+      keyframe_due_ && keyframe_.state.load(std::memory_order_acquire) == SlotState::Free;
+  if (!slot.recorded && !keyframe) {
+    return;
+  }
+
+  const VkDeviceSize stream_bytes =
+      static_cast<VkDeviceSize>(streams.cell_count) * sizeof(glm::ivec4);
+  if (keyframe) {
+    if (keyframe_.capacity < stream_bytes * 2) {
+      keyframe_.buffer = std::make_unique<BaseBuffer>();
+      BaseBuffer::create(stream_bytes * 2,
+                         VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                         *keyframe_.buffer);
+      keyframe_.buffer->map();
+      keyframe_.capacity = stream_bytes * 2;
+    }
+
+    VkMemoryBarrier entry_barrier{};
+    entry_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    entry_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    entry_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         1,
+                         &entry_barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    // States first, then positions (only w is kept).
+    const std::array<VkBufferCopy, 2> regions{{
+        {.srcOffset = streams.states_offset, .dstOffset = 0, .size = stream_bytes},
+        {.srcOffset = streams.position_offset, .dstOffset = stream_bytes, .size = stream_bytes},
+    }};
+    vkCmdCopyBuffer(command_buffer,
+                    newest,
+                    keyframe_.buffer->buffer,
+                    static_cast<uint32_t>(regions.size()),
+                    regions.data());
+
+    keyframe_.hour = hour;
+    keyframe_.cell_count = streams.cell_count;
+    keyframe_.grid_width = static_cast<uint32_t>(world._grid.size.x);
+    keyframe_.grid_height = static_cast<uint32_t>(world._grid.size.y);
+    keyframe_.state.store(SlotState::Copying, std::memory_order_release);
+    slot.keyframe = true;
+    keyframe_due_ = false;
+    last_keyframe_hour_ = hour;
+  }
+
+  // Log entries and the keyframe copy become visible to the host once the submission's
+  // timeline value is reached; the next step's writes to the side wait for the copy's reads.
+  VkMemoryBarrier host_barrier{};
+  host_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  host_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                       0,
+                       1,
+                       &host_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
+
+void CE::DeltaStream::collect(const uint32_t frame_index) {
+  Slot &slot = slots_[frame_index];
+  std::vector<Job> ready{};
+
+  if (slot.recorded) {
+    slot.recorded = false;
+    const uint32_t *head = log_mapped_ + slot.word_offset;
+    const uint32_t count = head[0];
+    const uint32_t ranged = std::min(slot.step_count, max_steps);
+
+    Job job{.kind = Kind::Steps, .hour = slot.first_hour, .step_count = slot.step_count};
+    job.ranges.assign(head + head_words, head + head_words + ranged * 2);
+    const uint32_t *entries = head + head_words + max_steps * 2;
+    job.entries.assign(entries, entries + static_cast<size_t>(count) * entry_words);
+    ready.push_back(std::move(job));
+
+    // Some step did not fit (or the batch outran the step table): only a keyframe gets the
+    // stream back in sync.
+    if (head[1] != 0) {
+      keyframe_due_ = true;
+    }
+  }
+  if (slot.keyframe) {
+    slot.keyframe = false;
+    keyframe_.state.store(SlotState::Writing, std::memory_order_release);
+    ready.push_back(Job{.kind = Kind::Keyframe, .hour = keyframe_.hour});
+  }
+  if (ready.empty()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Job &job : ready) {
+      jobs_.push_back(std::move(job));
+    }
+  }
+  wake_.notify_one();
+}
+
+void CE::DeltaStream::flush() {
+  if (!enabled_) {
+    return;
+  }
+  std::array<uint32_t, MAX_FRAME_LATENCY> order{};
+  for (uint32_t slot = 0; slot < MAX_FRAME_LATENCY; ++slot) {
+    order[slot] = slot;
+  }
+  std::sort(order.begin(), order.end(), [this](const uint32_t a, const uint32_t b) {
+    return slots_[a].sequence < slots_[b].sequence;
+  });
+  for (const uint32_t slot : order) {
+    collect(slot);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+  stream_.close();
+  enabled_ = false;
+
+  Log::text("{ PERF }",
+            "Delta stream",
+            path_,
+            "steps",
+            steps_written_,
+            "entries",
+            entries_written_,
+            "keyframes",
+            keyframes_written_,
+            "gaps",
+            gaps_,
+            "bytes",
+            stored_bytes_,
+            "of",
+            raw_bytes_,
+            "encoded");
+}
+
+void CE::DeltaStream::run() {
+  Trace::set_thread_name("delta writer");
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+    // Stopping still drains what was handed over.
+    if (jobs_.empty()) {
+      return;
+    }
+    Job job = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+
+    write(job);
+    if (job.kind == Kind::Keyframe) {
+      keyframe_.state.store(SlotState::Free, std::memory_order_release);
+    }
+
+    lock.lock();
+  }
+}
+
+void CE::DeltaStream::write(const Job &job) {
+  Trace::Scope scope("delta write");
+  std::vector<uint8_t> payload{};
+
+  if (job.kind == Kind::Keyframe) {
+    if (!header_written_) {
+      stream_.write(stream_magic.data(), stream_magic.size());
+      put_raw(stream_, stream_version);
+      put_raw(stream_, keyframe_.grid_width);
+      put_raw(stream_, keyframe_.grid_height);
+      header_written_ = true;
+    }
+    const uint64_t cell_count = keyframe_.cell_count;
+    const auto *states = static_cast<const uint32_t *>(keyframe_.buffer->mapped);
+    const uint32_t *positions = states + cell_count * 4;
+
+    payload.reserve(cell_count * 6);
+    put_varint(payload, job.hour);
+    put_varint(payload, cell_count);
+    uint32_t w_previous = 0;
+    for (uint64_t cell = 0; cell < cell_count; ++cell) {
+      put_cell(payload, states + cell * 4, positions[cell * 4 + 3], w_previous);
+    }
+    write_chunk(Kind::Keyframe, payload);
+    ++keyframes_written_;
+    in_sync_ = true;
+    return;
+  }
+
+  // Steps before the first keyframe, or after a gap until the next one, have no base.
+  if (!in_sync_) {
+    return;
+  }
+
+  const uint32_t ranged = static_cast<uint32_t>(job.ranges.size() / 2);
+  uint32_t steps = 0;
+  while (steps < job.step_count && steps < ranged && job.ranges[steps * 2 + 1] != skipped) {
+    ++steps;
+  }
+
+  if (steps > 0) {
+    put_varint(payload, job.hour);
+    put_varint(payload, steps);
+    for (uint32_t step = 0; step < steps; ++step) {
+      const uint32_t first = job.ranges[step * 2];
+      const uint32_t count = job.ranges[step * 2 + 1];
+      put_varint(payload, count);
+
+      uint32_t next_index = 0;
+      uint32_t w_previous = 0;
+      for (uint32_t entry = first; entry < first + count; ++entry) {
+        const uint32_t *words = job.entries.data() + static_cast<size_t>(entry) * entry_words;
+        put_varint(payload, words[0] - next_index);
+        next_index = words[0] + 1;
+        put_cell(payload, words + 2, words[1], w_previous);
+      }
+      entries_written_ += count;
+    }
+    write_chunk(Kind::Steps, payload);
+    steps_written_ += steps;
+  }
+
+  if (steps < job.step_count) {
+    payload.clear();
+    put_varint(payload, job.hour + steps);
+    write_chunk(Kind::Gap, payload);
+    ++gaps_;
+    in_sync_ = false;
+  }
+}
+
+void CE::DeltaStream::write_chunk(const Kind kind, const std::vector<uint8_t> &payload) {
+  const uint8_t *stored = payload.data();
+  size_t stored_size = payload.size();
+  uint8_t codec = codec_raw;
+
+#ifdef CE_HAS_ZSTD
+  std::vector<uint8_t> compressed(ZSTD_compressBound(payload.size()));
+  const size_t compressed_size =
+      ZSTD_compress(compressed.data(), compressed.size(), payload.data(), payload.size(), 3);
+  if (!ZSTD_isError(compressed_size) && compressed_size < payload.size()) {
+    stored = compressed.data();
+    stored_size = compressed_size;
+    codec = codec_zstd;
+  }
+#endif
+
+  put_raw(stream_, static_cast<uint8_t>(kind));
+  put_raw(stream_, codec);
+  put_raw(stream_, static_cast<uint16_t>(0));
+  put_raw(stream_, static_cast<uint32_t>(payload.size()));
+  put_raw(stream_, static_cast<uint32_t>(stored_size));
+  stream_.write(reinterpret_cast<const char *>(stored), static_cast<std::streamsize>(stored_size));
+  if (!stream_) {
+    // Log is not thread safe; the writer reports failures straight to stderr.
+    std::cerr << "Failed to write delta stream to: " << path_ << '\n';
+  }
+  raw_bytes_ += payload.size();
+  stored_bytes_ += stored_size;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Per-step history of cell states as a sparse, compressed delta stream with keyframes.
+// Exists so every simulated hour can be replayed without writing whole cell buffers.
+#include <vulkan/vulkan.h>
+
+#include "vulkan_base/VulkanBaseDescriptor.h"
+#include "vulkan_base/VulkanBaseResources.h"
+#include "world/World.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace CE {
+
+// CellDelta.comp runs after every Engine step and compacts the cells whose states or
+// position.w changed (index, position.w, states) into a host-visible log slot of the frame,
+// so only changed entries ever cross the bus. collect() copies a completed slot out and a
+// writer thread appends it to CE_DELTA_STREAM; a keyframe (every cell) is copied from the
+// newest side every CE_DELTA_KEYFRAME_EVERY hours, and after any step the log could not hold.
+//
+// File: "CEDELTA\0", u32 version, u32 grid width, u32 grid height, then chunks of
+// u8 kind, u8 codec (0 raw, 1 zstd), u16 reserved, u32 raw size, u32 stored size, payload.
+// Payloads are LEB128 varints throughout:
+//   Keyframe: hour, cell count, per cell 4 zigzag states and position.w bits XOR the
+//             previous cell's.
+//   Steps:    first hour, step count, per step its entry count, per entry the index gap to
+//             the previous entry (0 for adjacent cells), 4 zigzag states, position.w bits XOR
+//             the previous entry's.
+//   Gap:      first hour that was not recorded; replay resumes at the next keyframe.
+// A stream always starts with a keyframe.
+class DeltaStream {
+public:
+  // Layout shared with shaders/CellDelta.comp, in 32-bit words.
+  static constexpr uint32_t max_steps = 4096;
+  static constexpr uint32_t head_words = 4;
+  static constexpr uint32_t entry_words = 6;
+  static constexpr uint32_t skipped = 0xFFFFFFFFu;
+  static constexpr uint32_t group_size = 256;
+  static constexpr uint32_t scratch_head_words = 4;
+
+  DeltaStream();
+  DeltaStream(const DeltaStream &) = delete;
+  DeltaStream &operator=(const DeltaStream &) = delete;
+  DeltaStream(DeltaStream &&) = delete;
+  DeltaStream &operator=(DeltaStream &&) = delete;
+  ~DeltaStream();
+
+  bool enabled() const {
+    return enabled_;
+  }
+  // Changed-cell entries one frame slot's log holds; 0 when recording is off.
+  uint32_t capacity(size_t cell_count) const;
+  static VkDeviceSize slot_words(uint32_t capacity) {
+    return head_words + max_steps * 2 + static_cast<VkDeviceSize>(capacity) * entry_words;
+  }
+
+  // Ahead of the first CellDelta dispatch of a submission that steps: points the passes at
+  // this slot of log and clears it.
+  void begin(VkCommandBuffer command_buffer,
+             const uint32_t frame_index,
+             const BaseBuffer &log,
+             const VkBuffer scratch,
+             const uint32_t capacity,
+             const uint32_t group_count,
+             const uint64_t first_hour,
+             const uint32_t step_count);
+  // After the submission's last cell write: publishes the log slot to the host and copies a
+  // keyframe of the newest side when one is due.
+  void end(VkCommandBuffer command_buffer,
+           const uint32_t frame_index,
+           const VkBuffer newest,
+           const World::CellStreams &streams,
+           const World &world);
+  // Call once the slot's previous compute submission has completed.
+  void collect(const uint32_t frame_index);
+  // Writes everything still in flight and stops the writer; the device must be idle.
+  void flush();
+
+private:
+  enum class Kind : uint8_t { Keyframe = 1, Steps = 2, Gap = 3 };
+  enum class SlotState : uint8_t { Free, Copying, Writing };
+
+  struct Slot {
+    bool recorded{false};
+    bool keyframe{false};
+    uint64_t first_hour{0};
+    uint32_t step_count{0};
+    VkDeviceSize word_offset{0};
+    // Submission order, so flush() can collect the slots oldest first.
+    uint64_t sequence{0};
+  };
+  // A completed slot, copied out of the log so the slot is free for its next frame.
+  struct Job {
+    Kind kind{Kind::Steps};
+    uint64_t hour{0};
+    uint32_t step_count{0};
+    std::vector<uint32_t> ranges{};
+    std::vector<uint32_t> entries{};
+  };
+  struct Keyframe {
+    std::unique_ptr<BaseBuffer> buffer{};
+    VkDeviceSize capacity{0};
+    std::atomic<SlotState> state{SlotState::Free};
+    uint64_t hour{0};
+    uint64_t cell_count{0};
+    uint32_t grid_width{0};
+    uint32_t grid_height{0};
+  };
+
+  bool enabled_{false};
+  std::string path_{};
+  uint64_t keyframe_every_{0};
+  uint32_t capacity_override_{0};
+  // Writer thread only until flush() joins it.
+  std::ofstream stream_{};
+
+  std::array<Slot, MAX_FRAME_LATENCY> slots_{};
+  const uint32_t *log_mapped_{nullptr};
+  Keyframe keyframe_{};
+  bool keyframe_due_{true};
+  uint64_t last_keyframe_hour_{0};
+  uint64_t next_sequence_{0};
+
+  std::mutex mutex_{};
+  std::condition_variable wake_{};
+  std::deque<Job> jobs_{};
+  bool stop_{false};
+  std::thread writer_{};
+
+  // Writer thread only until flush() joins it.
+  bool header_written_{false};
+  // Steps only apply on top of a keyframe; cleared again by a gap.
+  bool in_sync_{false};
+  uint64_t steps_written_{0};
+  uint64_t entries_written_{0};
+  uint64_t keyframes_written_{0};
+  uint64_t gaps_{0};
+  uint64_t raw_bytes_{0};
+  uint64_t stored_bytes_{0};
+
+  void run();
+  void write(const Job &job);
+  void write_chunk(Kind kind, const std::vector<uint8_t> &payload);
+};
+
+} // namespace CE
@@ -20,5 +20,4 @@ struct Vec2UintFast16 {
 namespace Lib {
 // Cross platform functions
 std::string path(const std::string &linux_path);
-std::string if_shader_compile(std::string linux_path);
 } // namespace Lib
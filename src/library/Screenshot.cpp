@@ -4,61 +4,175 @@
 #include "Screenshot.h"
 
 #include "engine/Log.h"
+#include "engine/Trace.h"
+#include "world/RuntimeConfig.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 #include <utility>
 #include <vector>
 
-void CE::Screenshot::capture(const VkImage &src_image,
-                             const VkExtent2D &extent,
-                             const VkFormat &format,
-                             const VkCommandPool &command_pool,
-                             const VkQueue &queue,
-                             const std::string &filename) {
-  Log::text("{ >>> }", "Screenshot:", filename);
+namespace {
 
-  VkDeviceSize imageSize = static_cast<VkDeviceSize>(extent.width) *
-                           static_cast<VkDeviceSize>(extent.height) *
-                           static_cast<VkDeviceSize>(4);
-  BaseBuffer staging_buffer{};
-  BaseBuffer::create(imageSize,
-                 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 staging_buffer);
+// Readback words as RGBA bytes; swizzled a whole pixel at a time, which vectorizes.
+std::vector<uint32_t> rgba_pixels(const void *mapped,
+                                  const VkExtent2D &extent,
+                                  const VkFormat format) {
+  const size_t pixel_count =
+      static_cast<size_t>(extent.width) * static_cast<size_t>(extent.height);
+  std::vector<uint32_t> pixels(pixel_count);
+  std::memcpy(pixels.data(), mapped, pixel_count * sizeof(uint32_t));
 
-  copy_image_to_buffer(src_image, staging_buffer, extent, command_pool, queue);
-  save_buffer_to_file(staging_buffer, extent, format, filename);
+  if (format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB ||
+      format == VK_FORMAT_B8G8R8A8_SNORM) {
+    std::transform(pixels.begin(), pixels.end(), pixels.begin(), [](const uint32_t pixel) {
+      return (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+    });
+  }
+  return pixels;
+}
 
-  Log::text(Log::Style::char_leader, "Screenshot queued for disk write");
+// Log is not thread safe; the writer reports failures straight to stderr.
+void write_png(const std::string &filename,
+               const VkExtent2D &extent,
+               const std::vector<uint32_t> &pixels) {
+  const int width = static_cast<int>(extent.width);
+  const int height = static_cast<int>(extent.height);
+  if (!stbi_write_png(filename.c_str(), width, height, 4, pixels.data(), width * 4)) {
+    std::cerr << "Failed to write screenshot to file: " << filename << '\n';
+  }
 }
 
-void CE::Screenshot::copy_image_to_buffer(const VkImage &src_image,
-                                          BaseBuffer &dst_buffer,
-                                       const VkExtent2D &extent,
-                                       const VkCommandPool &command_pool,
-                                       const VkQueue &queue) {
-  CE::BaseSingleUseCommands single_use_commands(command_pool, queue);
-  VkCommandBuffer &command_buffer = single_use_commands.command_buffer();
+} // namespace
+
+CE::Screenshot::Screenshot() {
+  const char *sequence_path = std::getenv(CE::Runtime::kEnvCaptureSequence);
+  if (!sequence_path || *sequence_path == '\0') {
+    return;
+  }
+  sequence_.path = sequence_path;
+  sequence_.y4m = std::filesystem::path(sequence_.path).extension() == ".y4m";
+  sequence_.every = std::max(CE::Runtime::env_uint(CE::Runtime::kEnvCaptureEvery, 1), 1u);
+  depth_ = std::clamp(
+      CE::Runtime::env_uint(CE::Runtime::kEnvCaptureBuffers, CE::Runtime::kDefaultCaptureBuffers),
+      1u,
+      max_readbacks);
+
+  if (sequence_.y4m) {
+    sequence_.stream.open(sequence_.path, std::ios::binary | std::ios::trunc);
+    if (!sequence_.stream) {
+      Log::text("{ !!! }", "Capture sequence: cannot write", sequence_.path);
+      return;
+    }
+  } else {
+    std::error_code error{};
+    std::filesystem::create_directories(sequence_.path, error);
+    if (error) {
+      Log::text("{ !!! }", "Capture sequence: cannot create", sequence_.path, error.message());
+      return;
+    }
+  }
+
+  sequence_.enabled = true;
+  Log::text("{ >>> }",
+            "Capture sequence",
+            sequence_.path,
+            sequence_.y4m ? "y4m" : "png",
+            "every",
+            sequence_.every,
+            "frames",
+            depth_,
+            "readbacks in flight");
+  start_writer();
+}
+
+CE::Screenshot::~Screenshot() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+}
+
+void CE::Screenshot::start_writer() {
+  if (!writer_.joinable()) {
+    stop_ = false;
+    writer_ = std::thread([this]() { run(); });
+  }
+}
+
+void CE::Screenshot::request(const std::string &filename) {
+  Log::text("{ >>> }", "Screenshot:", filename);
+  requested_.push_back(filename);
+  start_writer();
+}
+
+void CE::Screenshot::record(VkCommandBuffer command_buffer,
+                            const uint32_t frame_index,
+                            const VkImage image,
+                            const VkExtent2D &extent,
+                            const VkFormat format,
+                            const VkImageLayout resting_layout) {
+  const bool sequence_frame =
+      sequence_.enabled && sequence_.frames_seen++ % sequence_.every == 0;
+  if (requested_.empty() && !sequence_frame) {
+    return;
+  }
+
+  const auto free_readback =
+      std::find_if(readbacks_.begin(), readbacks_.begin() + depth_, [](const Readback &readback) {
+        return readback.state.load(std::memory_order_acquire) == SlotState::Free;
+      });
+  if (free_readback == readbacks_.begin() + depth_) {
+    // The writer is behind: drop the sequence frame, keep a screenshot request for later.
+    if (sequence_frame) {
+      sequence_.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+  Readback &readback = *free_readback;
+
+  const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) *
+                            static_cast<VkDeviceSize>(extent.height) *
+                            static_cast<VkDeviceSize>(4);
+  if (readback.capacity < size) {
+    // Grows with the swapchain, then stays; the old buffer's last copy was already written.
+    readback.buffer = std::make_unique<BaseBuffer>();
+    BaseBuffer::create(size,
+                       VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       *readback.buffer);
+    readback.buffer->map();
+    readback.capacity = size;
+  }
 
   VkImageMemoryBarrier barrier{};
   barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  barrier.oldLayout = resting_layout;
   barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
   barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
   barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image = src_image;
+  barrier.image = image;
   barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   barrier.subresourceRange.baseMipLevel = 0;
   barrier.subresourceRange.levelCount = 1;
   barrier.subresourceRange.baseArrayLayer = 0;
   barrier.subresourceRange.layerCount = 1;
-  barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+  // The frame's last writer is either the render pass or a post-process dispatch.
+  barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
   barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
   vkCmdPipelineBarrier(command_buffer,
-                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                        VK_PIPELINE_STAGE_TRANSFER_BIT,
                        0,
                        0,
@@ -80,56 +194,185 @@ void CE::Screenshot::copy_image_to_buffer(const VkImage &src_image,
   region.imageExtent = {extent.width, extent.height, 1};
 
   vkCmdCopyImageToBuffer(command_buffer,
-                         src_image,
+                         image,
                          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                         dst_buffer.buffer,
+                         readback.buffer->buffer,
                          1,
                          &region);
 
   barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  barrier.newLayout = resting_layout;
   barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+  barrier.dstAccessMask = 0;
+
+  // Makes the copy visible to the host once the submission's timeline value is reached.
+  VkBufferMemoryBarrier host_barrier{};
+  host_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  host_barrier.buffer = readback.buffer->buffer;
+  host_barrier.offset = 0;
+  host_barrier.size = size;
 
   vkCmdPipelineBarrier(command_buffer,
                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
                        0,
                        0,
                        nullptr,
-                       0,
-                       nullptr,
+                       1,
+                       &host_barrier,
                        1,
                        &barrier);
 
-  single_use_commands.submit_and_wait();
+  readback.frame_index = frame_index;
+  readback.extent = extent;
+  readback.format = format;
+  readback.filename.clear();
+  if (!requested_.empty()) {
+    readback.filename = std::move(requested_.front());
+    requested_.pop_front();
+  }
+  readback.in_sequence = sequence_frame;
+  if (sequence_frame) {
+    // Numbered by captured frame, so a dropped frame leaves no gap in the sequence.
+    readback.sequence_number = sequence_.captured++;
+  }
+  readback.state.store(SlotState::Copying, std::memory_order_release);
 }
 
-void CE::Screenshot::save_buffer_to_file(const BaseBuffer &buffer,
-                                         const VkExtent2D &extent,
-                                         const VkFormat &format,
-                                         const std::string &filename) {
-  void *data{};
-  vkMapMemory(
-      BaseDevice::base_device->logical_device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &data);
+void CE::Screenshot::collect(const uint32_t frame_index) {
+  bool handed_over = false;
+  for (uint32_t index = 0; index < depth_; ++index) {
+    Readback &readback = readbacks_[index];
+    if (readback.frame_index != frame_index ||
+        readback.state.load(std::memory_order_acquire) != SlotState::Copying) {
+      continue;
+    }
+    readback.state.store(SlotState::Writing, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(index);
+    }
+    handed_over = true;
+  }
+  if (handed_over) {
+    wake_.notify_one();
+  }
+}
 
-  std::vector<uint8_t> pixels(extent.width * extent.height * 4);
-  memcpy(pixels.data(), data, pixels.size());
+void CE::Screenshot::flush() {
+  for (uint32_t slot = 0; slot < MAX_FRAME_LATENCY; ++slot) {
+    collect(slot);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+  if (!requested_.empty()) {
+    Log::text("{ !!! }", "Screenshot: dropped", requested_.size(), "requests never rendered");
+    requested_.clear();
+  }
+  if (sequence_.enabled) {
+    sequence_.stream.close();
+    Log::text("{ PERF }",
+              "Capture sequence",
+              sequence_.path,
+              "written",
+              sequence_.written.load(std::memory_order_relaxed),
+              "dropped",
+              sequence_.dropped.load(std::memory_order_relaxed),
+              "of",
+              (sequence_.frames_seen + sequence_.every - 1) / sequence_.every,
+              "frames");
+    sequence_.enabled = false;
+  }
+}
 
-  if (format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB ||
-      format == VK_FORMAT_B8G8R8A8_SNORM) {
-    for (size_t i = 0; i < pixels.size(); i += 4) {
-      std::swap(pixels[i], pixels[i + 2]);
+void CE::Screenshot::run() {
+  Trace::set_thread_name("capture writer");
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+    // Stopping still drains what was handed over.
+    if (jobs_.empty()) {
+      return;
     }
+    const uint32_t index = jobs_.front();
+    jobs_.pop_front();
+    lock.unlock();
+
+    write(readbacks_[index]);
+    readbacks_[index].state.store(SlotState::Free, std::memory_order_release);
+
+    lock.lock();
   }
+}
 
-  vkUnmapMemory(BaseDevice::base_device->logical_device, buffer.memory);
+void CE::Screenshot::write(const Readback &readback) {
+  Trace::Scope scope("capture write");
+  const std::vector<uint32_t> pixels =
+      rgba_pixels(readback.buffer->mapped, readback.extent, readback.format);
 
-  const int width = static_cast<int>(extent.width);
-  const int height = static_cast<int>(extent.height);
-  const int stride = width * 4;
+  if (!readback.filename.empty()) {
+    write_png(readback.filename, readback.extent, pixels);
+  }
+  if (!readback.in_sequence) {
+    return;
+  }
+  if (sequence_.y4m) {
+    write_y4m_frame(readback, pixels);
+    return;
+  }
+  std::ostringstream name{};
+  name << "frame_" << std::setw(6) << std::setfill('0') << readback.sequence_number << ".png";
+  write_png((std::filesystem::path(sequence_.path) / name.str()).string(), readback.extent, pixels);
+  sequence_.written.fetch_add(1, std::memory_order_relaxed);
+}
 
-  if (!stbi_write_png(filename.c_str(), width, height, 4, pixels.data(), stride)) {
-    std::cerr << "Failed to write screenshot to file: " << filename << '\n';
+void CE::Screenshot::write_y4m_frame(const Readback &readback,
+                                     const std::vector<uint32_t> &pixels) {
+  // One stream has one frame size: the first frame sets it, frames from a resized
+  // swapchain are dropped.
+  if (sequence_.stream_extent.width == 0) {
+    sequence_.stream_extent = readback.extent;
+    sequence_.stream << "YUV4MPEG2 W" << readback.extent.width << " H" << readback.extent.height
+                     << " F30:1 Ip A1:1 C444\n";
+  }
+  if (readback.extent.width != sequence_.stream_extent.width ||
+      readback.extent.height != sequence_.stream_extent.height) {
+    sequence_.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // BT.601 studio range, full chroma resolution: three planes after the frame marker.
+  const size_t pixel_count = pixels.size();
+  std::vector<uint8_t> planes(pixel_count * 3);
+  uint8_t *y_plane = planes.data();
+  uint8_t *u_plane = y_plane + pixel_count;
+  uint8_t *v_plane = u_plane + pixel_count;
+  for (size_t i = 0; i < pixel_count; ++i) {
+    const int r = static_cast<int>(pixels[i] & 0xFFu);
+    const int g = static_cast<int>((pixels[i] >> 8) & 0xFFu);
+    const int b = static_cast<int>((pixels[i] >> 16) & 0xFFu);
+    y_plane[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    u_plane[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    v_plane[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  }
+
+  sequence_.stream << "FRAME\n";
+  sequence_.stream.write(reinterpret_cast<const char *>(planes.data()),
+                         static_cast<std::streamsize>(planes.size()));
+  if (!sequence_.stream) {
+    std::cerr << "Failed to write capture frame to: " << sequence_.path << '\n';
+    sequence_.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
   }
+  sequence_.written.fetch_add(1, std::memory_order_relaxed);
 }
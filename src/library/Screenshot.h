@@ -1,40 +1,110 @@
 #pragma once
 
-// Screenshot capture utility for swapchain images.
-// Exists to isolate readback/staging logic from render loop orchestration.
+// Screenshot and frame sequence capture for swapchain images.
+// Exists to isolate readback/encoding from render loop orchestration.
 #include <vulkan/vulkan.h>
 
-#include "vulkan_base/VulkanBaseDevice.h"
+#include "vulkan_base/VulkanBaseDescriptor.h"
 #include "vulkan_base/VulkanBaseResources.h"
-#include "vulkan_base/VulkanBaseSync.h"
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace CE {
 
+// Captures ride along with a frame's graphics work: record() appends a copy of the rendered
+// image into a free readback buffer, and collect() hands the copy to a writer thread once
+// the frame slot's submission has completed. Nothing here waits on the GPU or encodes on the
+// calling thread.
+//
+// Two sources share the ring: request() for single PNGs, and the CE_CAPTURE_SEQUENCE frame
+// sequence (every CE_CAPTURE_EVERY-th frame, CE_CAPTURE_BUFFERS copies in flight). The ring is
+// the writer's queue bound: a sequence frame finding no free buffer is dropped and counted,
+// a screenshot request waits for a later frame.
 class Screenshot {
 public:
-  Screenshot() = delete;
-  ~Screenshot() = delete;
+  Screenshot();
+  Screenshot(const Screenshot &) = delete;
+  Screenshot &operator=(const Screenshot &) = delete;
+  Screenshot(Screenshot &&) = delete;
+  Screenshot &operator=(Screenshot &&) = delete;
+  ~Screenshot();
 
-  static void capture(const VkImage &src_image,
-                      const VkExtent2D &extent,
-                      const VkFormat &format,
-                      const VkCommandPool &command_pool,
-                      const VkQueue &queue,
-                      const std::string &filename);
+  void request(const std::string &filename);
+  // Copies image into a readback buffer at the end of the frame if a request is waiting or
+  // the frame belongs to the sequence. The image is left in resting_layout.
+  void record(VkCommandBuffer command_buffer,
+              const uint32_t frame_index,
+              const VkImage image,
+              const VkExtent2D &extent,
+              const VkFormat format,
+              const VkImageLayout resting_layout);
+  // Call once the slot's previous graphics submission has completed.
+  void collect(const uint32_t frame_index);
+  // Writes every capture still in flight and stops the writer; the device must be idle.
+  void flush();
 
 private:
-  static void copy_image_to_buffer(const VkImage &src_image,
-                                   BaseBuffer &dst_buffer,
-                                const VkExtent2D &extent,
-                                const VkCommandPool &command_pool,
-                                const VkQueue &queue);
-
-  static void save_buffer_to_file(const BaseBuffer &buffer,
-                                  const VkExtent2D &extent,
-                                  const VkFormat &format,
-                                  const std::string &filename);
+  static constexpr uint32_t max_readbacks = 8;
+
+  enum class SlotState : uint8_t { Free, Copying, Writing };
+
+  struct Readback {
+    std::unique_ptr<BaseBuffer> buffer{};
+    VkDeviceSize capacity{0};
+    // Free -> Copying on the render thread, Copying -> Writing once the copy completed,
+    // Writing -> Free on the writer thread.
+    std::atomic<SlotState> state{SlotState::Free};
+    // Frame slot whose submission fills it.
+    uint32_t frame_index{0};
+    VkExtent2D extent{};
+    VkFormat format{VK_FORMAT_UNDEFINED};
+    // Screenshot file, empty when the copy only feeds the sequence.
+    std::string filename{};
+    bool in_sequence{false};
+    uint64_t sequence_number{0};
+  };
+
+  struct Sequence {
+    bool enabled{false};
+    // Directory of numbered PNGs, or a single .y4m stream.
+    std::string path{};
+    bool y4m{false};
+    uint32_t every{1};
+    uint64_t frames_seen{0};
+    uint64_t captured{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    // Writer thread only.
+    std::ofstream stream{};
+    VkExtent2D stream_extent{};
+  };
+
+  std::array<Readback, max_readbacks> readbacks_{};
+  uint32_t depth_{MAX_FRAME_LATENCY};
+  Sequence sequence_{};
+  std::deque<std::string> requested_{};
+
+  std::mutex mutex_{};
+  std::condition_variable wake_{};
+  std::deque<uint32_t> jobs_{};
+  bool stop_{false};
+  // Started with the sequence, or by the first request.
+  std::thread writer_{};
+
+  void start_writer();
+  void run();
+  void write(const Readback &readback);
+  void write_y4m_frame(const Readback &readback, const std::vector<uint32_t> &pixels);
 };
 
 } // namespace CE
@@ -0,0 +1,380 @@
+#include "ShaderCompiler.h"
+
+#include "engine/Log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(CE_HAS_SHADERC)
+#include <shaderc/shaderc.hpp>
+#endif
+
+namespace {
+namespace fs = std::filesystem;
+
+std::string read_file(const fs::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("\n!ERROR! failed to open shader file: " + path.string());
+  }
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+bool write_file(const fs::path &path, const char *data, const size_t size) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(data, static_cast<std::streamsize>(size));
+  return static_cast<bool>(file);
+}
+
+// Matches `#include "name"` with optional whitespace; other include forms are left alone.
+std::optional<std::string> include_target(const std::string &line) {
+  size_t pos = line.find_first_not_of(" \t");
+  if (pos == std::string::npos || line[pos] != '#') {
+    return std::nullopt;
+  }
+  pos = line.find_first_not_of(" \t", pos + 1);
+  if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) {
+    return std::nullopt;
+  }
+  const size_t open = line.find('"', pos + 7);
+  const size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+  if (close == std::string::npos) {
+    return std::nullopt;
+  }
+  return line.substr(open + 1, close - open - 1);
+}
+
+std::optional<fs::path> resolve_include(const fs::path &requesting_file,
+                                        const std::string &name,
+                                        const std::string &include_dir) {
+  for (const fs::path &candidate :
+       {requesting_file.parent_path() / name, fs::path(include_dir) / name}) {
+    if (fs::exists(candidate)) {
+      return candidate.lexically_normal();
+    }
+  }
+  return std::nullopt;
+}
+
+void expand_file(const fs::path &path,
+                 const std::string &include_dir,
+                 std::vector<fs::path> &stack,
+                 std::vector<std::string> &dependencies,
+                 std::string &out) {
+  if (std::find(stack.begin(), stack.end(), path) != stack.end()) {
+    throw std::runtime_error("\n!ERROR! shader include cycle at " + path.string());
+  }
+  stack.push_back(path);
+
+  std::istringstream lines(read_file(path));
+  std::string line{};
+  while (std::getline(lines, line)) {
+    const std::optional<std::string> name = include_target(line);
+    if (!name) {
+      out += line;
+      out += '\n';
+      continue;
+    }
+
+    const std::optional<fs::path> resolved = resolve_include(path, *name, include_dir);
+    if (!resolved) {
+      throw std::runtime_error("\n!ERROR! " + path.string() + " includes missing file " + *name);
+    }
+    if (std::find(dependencies.begin(), dependencies.end(), resolved->string()) ==
+        dependencies.end()) {
+      dependencies.push_back(resolved->string());
+    }
+    expand_file(*resolved, include_dir, stack, dependencies, out);
+  }
+
+  stack.pop_back();
+}
+
+#if defined(CE_HAS_SHADERC)
+shaderc_shader_kind shader_kind(const std::string &extension) {
+  if (extension == ".comp") {
+    return shaderc_compute_shader;
+  }
+  if (extension == ".vert") {
+    return shaderc_vertex_shader;
+  }
+  if (extension == ".frag") {
+    return shaderc_fragment_shader;
+  }
+  if (extension == ".tesc") {
+    return shaderc_tess_control_shader;
+  }
+  if (extension == ".tese") {
+    return shaderc_tess_evaluation_shader;
+  }
+  if (extension == ".geom") {
+    return shaderc_geometry_shader;
+  }
+  return shaderc_glsl_infer_from_source;
+}
+
+// Same lookup order as expand_includes(): next to the including file, then include_dir.
+class Includer : public shaderc::CompileOptions::IncluderInterface {
+public:
+  explicit Includer(std::string include_dir) : include_dir_(std::move(include_dir)) {}
+
+  shaderc_include_result *GetInclude(const char *requested_source,
+                                     shaderc_include_type,
+                                     const char *requesting_source,
+                                     size_t) override {
+    auto *include = new Include{};
+    const std::optional<fs::path> resolved =
+        resolve_include(fs::path(requesting_source), requested_source, include_dir_);
+    if (resolved) {
+      include->name = resolved->string();
+      include->content = read_file(*resolved);
+    } else {
+      // shaderc reports an empty source name as failure, with the content as the message.
+      include->content = std::string("cannot find include ") + requested_source;
+    }
+    include->result = shaderc_include_result{include->name.c_str(),
+                                             include->name.size(),
+                                             include->content.c_str(),
+                                             include->content.size(),
+                                             include};
+    return &include->result;
+  }
+
+  void ReleaseInclude(shaderc_include_result *result) override {
+    delete static_cast<Include *>(result->user_data);
+  }
+
+private:
+  struct Include {
+    std::string name{};
+    std::string content{};
+    shaderc_include_result result{};
+  };
+  std::string include_dir_;
+};
+#endif
+
+const char *outcome_label(const uint8_t outcome) {
+  constexpr std::array<const char *, 4> labels{"up to date", "from cache", "compiled", "failed"};
+  return labels[std::min<size_t>(outcome, labels.size() - 1)];
+}
+} // namespace
+
+std::string CE::ShaderCompiler::expand_includes(const std::string &source_path,
+                                                const std::string &include_dir,
+                                                std::vector<std::string> &dependencies) {
+  std::vector<fs::path> stack{};
+  std::string out{};
+  expand_file(fs::path(source_path).lexically_normal(), include_dir, stack, dependencies, out);
+  return out;
+}
+
+uint64_t CE::ShaderCompiler::hash(const std::string &text, uint64_t seed) {
+  // FNV-1a; only has to be stable and cheap, not cryptographic.
+  for (const unsigned char c : text) {
+    seed ^= c;
+    seed *= 1099511628211ull;
+  }
+  return seed;
+}
+
+std::string CE::ShaderCompiler::backend_name() {
+#if defined(CE_HAS_SHADERC)
+  return "shaderc";
+#else
+  return "glslangValidator";
+#endif
+}
+
+bool CE::ShaderCompiler::compile_to(const Job &job,
+                                    const Options &options,
+                                    const std::string &target_path,
+                                    std::string &message) {
+#if defined(CE_HAS_SHADERC)
+  shaderc::Compiler compiler;
+  shaderc::CompileOptions compile_options;
+  compile_options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+  compile_options.SetIncluder(std::make_unique<Includer>(options.include_dir));
+  for (const std::string &define : options.defines) {
+    const size_t equals = define.find('=');
+    if (equals == std::string::npos) {
+      compile_options.AddMacroDefinition(define);
+    } else {
+      compile_options.AddMacroDefinition(define.substr(0, equals), define.substr(equals + 1));
+    }
+  }
+
+  const std::string source = read_file(job.source);
+  const shaderc::SpvCompilationResult result =
+      compiler.CompileGlslToSpv(source,
+                                shader_kind(fs::path(job.source).extension().string()),
+                                job.source.c_str(),
+                                compile_options);
+  if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+    message = result.GetErrorMessage();
+    return false;
+  }
+
+  const std::vector<uint32_t> spirv(result.cbegin(), result.cend());
+  if (!write_file(target_path,
+                  reinterpret_cast<const char *>(spirv.data()),
+                  spirv.size() * sizeof(uint32_t))) {
+    message = "cannot write " + target_path;
+    return false;
+  }
+  return true;
+#else
+#ifdef _WIN32
+  std::string command = "glslangValidator.exe -V";
+#else
+  std::string command = "glslangValidator -V";
+#endif
+  command += " -I" + fs::path(options.include_dir).make_preferred().string();
+  for (const std::string &define : options.defines) {
+    command += " -D" + define;
+  }
+  command += " " + fs::path(job.source).make_preferred().string();
+  command += " -o " + fs::path(target_path).make_preferred().string();
+
+  const int ret = std::system(command.c_str());
+  if (ret != 0) {
+    message = "exit code " + std::to_string(ret);
+    return false;
+  }
+  return true;
+#endif
+}
+
+CE::ShaderCompiler::Result CE::ShaderCompiler::compile_one(const Job &job, const Options &options) {
+  const auto start = std::chrono::steady_clock::now();
+  Result result{};
+  const auto finish = [&](const Outcome outcome) {
+    result.outcome = outcome;
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                    .count();
+    return result;
+  };
+
+  try {
+    // Keyed on the include-expanded source, defines, and backend, so an edit to any included
+    // file or a define toggle produces a new key; timestamps play no part.
+    std::vector<std::string> dependencies{};
+    const std::string expanded = expand_includes(job.source, options.include_dir, dependencies);
+    result.dependency_count = dependencies.size();
+
+    std::string key_material = backend_name() + "|vulkan1.3|" +
+                               fs::path(job.source).extension().string() + "|";
+    for (const std::string &define : options.defines) {
+      key_material += define + ";";
+    }
+    std::ostringstream key_stream;
+    key_stream << std::hex << std::setw(16) << std::setfill('0')
+               << hash(expanded, hash(key_material));
+    const std::string key = key_stream.str();
+
+    const fs::path stamp_path = job.output + ".hash";
+    if (fs::exists(job.output) && fs::exists(stamp_path) && read_file(stamp_path) == key) {
+      return finish(Outcome::UpToDate);
+    }
+
+    const fs::path cached_path = fs::path(options.cache_dir) / (key + ".spv");
+    Outcome outcome = Outcome::FromCache;
+    if (!fs::exists(cached_path)) {
+      const std::string temp_path = cached_path.string() + ".tmp";
+      if (!compile_to(job, options, temp_path, result.message)) {
+        return finish(Outcome::Failed);
+      }
+      fs::rename(temp_path, cached_path);
+      outcome = Outcome::Compiled;
+    }
+
+    fs::copy_file(cached_path, job.output, fs::copy_options::overwrite_existing);
+    if (!write_file(stamp_path, key.data(), key.size())) {
+      result.message = "cannot write " + stamp_path.string();
+      return finish(Outcome::Failed);
+    }
+    return finish(outcome);
+  } catch (const std::exception &error) {
+    result.message = error.what();
+    return finish(Outcome::Failed);
+  }
+}
+
+uint32_t CE::ShaderCompiler::compile_all(const std::vector<Job> &jobs, const Options &options) {
+  const auto start = std::chrono::steady_clock::now();
+  std::error_code error{};
+  fs::create_directories(options.cache_dir, error);
+
+  std::vector<Result> results(jobs.size());
+  std::atomic<size_t> next_job{0};
+  const auto worker = [&]() {
+    for (size_t i = next_job.fetch_add(1); i < jobs.size(); i = next_job.fetch_add(1)) {
+      results[i] = compile_one(jobs[i], options);
+    }
+  };
+
+  const uint32_t requested =
+      options.thread_count > 0 ? options.thread_count : std::thread::hardware_concurrency();
+  const uint32_t thread_count =
+      static_cast<uint32_t>(std::clamp<size_t>(requested, 1, std::max<size_t>(jobs.size(), 1)));
+  std::vector<std::thread> threads{};
+  threads.reserve(thread_count - 1);
+  for (uint32_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  std::array<uint32_t, 4> counts{};
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const Result &result = results[i];
+    const uint8_t outcome = static_cast<uint8_t>(result.outcome);
+    ++counts[outcome];
+    if (result.outcome == Outcome::Failed) {
+      Log::text("{ !!! }", "shader compilation failed:", jobs[i].source, result.message);
+    } else if (result.outcome != Outcome::UpToDate) {
+      Log::text(Log::Style::char_leader,
+                jobs[i].source,
+                outcome_label(outcome),
+                result.ms,
+                "ms",
+                result.dependency_count,
+                "includes");
+    }
+  }
+
+  const double ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  Log::text("{ PERF }",
+            "Shaders",
+            jobs.size(),
+            outcome_label(0),
+            counts[0],
+            outcome_label(1),
+            counts[1],
+            outcome_label(2),
+            counts[2],
+            outcome_label(3),
+            counts[3],
+            "in",
+            ms,
+            "ms",
+            backend_name(),
+            thread_count,
+            "threads");
+  return counts[static_cast<uint8_t>(Outcome::Failed)];
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// GLSL -> SPIR-V build step with include tracking and a content-addressed binary cache.
+// Exists so shader rebuilds follow edits to included files and run in parallel in-process.
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CE {
+
+class ShaderCompiler {
+public:
+  struct Job {
+    std::string source{};
+    std::string output{};
+  };
+
+  struct Options {
+    std::string include_dir{"shaders"};
+    std::string cache_dir{"shaders/.spv_cache"};
+    // NAME or NAME=VALUE; part of every cache key.
+    std::vector<std::string> defines{};
+    // 0 selects std::thread::hardware_concurrency().
+    uint32_t thread_count{0};
+  };
+
+  ShaderCompiler() = delete;
+  ~ShaderCompiler() = delete;
+
+  // Brings every job's output up to date; returns the number of jobs that failed.
+  static uint32_t compile_all(const std::vector<Job> &jobs, const Options &options);
+
+  // Source with every #include "..." expanded, plus the files it pulled in. Throws when a
+  // file cannot be read or includes form a cycle.
+  static std::string expand_includes(const std::string &source_path,
+                                     const std::string &include_dir,
+                                     std::vector<std::string> &dependencies);
+
+private:
+  enum class Outcome : uint8_t { UpToDate, FromCache, Compiled, Failed };
+
+  struct Result {
+    Outcome outcome{Outcome::Failed};
+    size_t dependency_count{0};
+    double ms{0.0};
+    std::string message{};
+  };
+
+  static Result compile_one(const Job &job, const Options &options);
+  static bool compile_to(const Job &job,
+                         const Options &options,
+                         const std::string &target_path,
+                         std::string &message);
+  static uint64_t hash(const std::string &text, uint64_t seed = 14695981039346656037ull);
+  static std::string backend_name();
+};
+
+} // namespace CE
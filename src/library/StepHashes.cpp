@@ -0,0 +1,225 @@
+#include "StepHashes.h"
+
+#include "engine/Log.h"
+#include "world/RuntimeConfig.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+std::string hex(const uint64_t value) {
+  std::ostringstream text;
+  text << std::hex << std::setw(16) << std::setfill('0') << value;
+  return text.str();
+}
+
+} // namespace
+
+CE::StepHashes::StepHashes() {
+  const char *path = std::getenv(CE::Runtime::kEnvVerifyHashes);
+  if (!path || *path == '\0') {
+    return;
+  }
+  path_ = path;
+
+  std::error_code error{};
+  verifying_ = std::filesystem::exists(path_, error);
+  if (verifying_) {
+    std::ifstream golden(path_);
+    std::string line{};
+    uint64_t line_number = 0;
+    while (std::getline(golden, line)) {
+      ++line_number;
+      if (line.empty() || line.front() == '#') {
+        continue;
+      }
+      std::istringstream fields(line);
+      uint64_t hour = 0;
+      uint64_t hash = 0;
+      if (!(fields >> hour >> std::hex >> hash)) {
+        Log::text("{ !!! }", "Step hashes:", path_, "line", line_number, "unreadable, skipped");
+        continue;
+      }
+      golden_[hour] = hash;
+    }
+  }
+
+  const std::string output = verifying_ ? path_ + ".last" : path_;
+  stream_.open(output, std::ios::trunc);
+  if (!stream_) {
+    Log::text("{ !!! }", "Step hashes: cannot write", output);
+    return;
+  }
+  stream_ << "# hour hash\n";
+  enabled_ = true;
+
+  if (verifying_) {
+    Log::text("{ >>> }", "Step hashes: verifying", golden_.size(), "hours of", path_);
+  } else {
+    Log::text("{ >>> }", "Step hashes: recording golden", path_);
+  }
+}
+
+void CE::StepHashes::begin(VkCommandBuffer command_buffer,
+                           const uint32_t frame_index,
+                           const BaseBuffer &log,
+                           const uint32_t count) {
+  log_mapped_ = static_cast<const uint32_t *>(log.mapped);
+  Slot &slot = slots_[frame_index];
+  slot.word_offset = frame_index * slot_words();
+  slot.capacity = std::min(count, max_hashes);
+  slot.hours.clear();
+  if (slot.capacity == 0) {
+    return;
+  }
+
+  // The slot was last read by the host, which collect() already waited for.
+  vkCmdFillBuffer(command_buffer,
+                  log.buffer,
+                  slot.word_offset * sizeof(uint32_t),
+                  static_cast<VkDeviceSize>(slot.capacity) * hash_words * sizeof(uint32_t),
+                  0);
+
+  VkMemoryBarrier reset_barrier{};
+  reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       0,
+                       1,
+                       &reset_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
+
+bool CE::StepHashes::add(const uint32_t frame_index, const uint64_t hour, uint32_t &word) {
+  Slot &slot = slots_[frame_index];
+  if (slot.hours.size() >= slot.capacity) {
+    ++dropped_;
+    return false;
+  }
+  word = static_cast<uint32_t>(slot.word_offset + slot.hours.size() * hash_words);
+  slot.hours.push_back(hour);
+  return true;
+}
+
+void CE::StepHashes::end(VkCommandBuffer command_buffer) {
+  // Visible to the host once the submission's timeline value is reached.
+  VkMemoryBarrier host_barrier{};
+  host_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  host_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT,
+                       0,
+                       1,
+                       &host_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
+
+void CE::StepHashes::collect(const uint32_t frame_index) {
+  Slot &slot = slots_[frame_index];
+  if (slot.hours.empty()) {
+    return;
+  }
+  const uint32_t *words = log_mapped_ + slot.word_offset;
+  for (size_t i = 0; i < slot.hours.size(); ++i) {
+    const uint64_t hash = static_cast<uint64_t>(words[i * hash_words]) |
+                          (static_cast<uint64_t>(words[i * hash_words + 1]) << 32);
+    check(slot.hours[i], hash);
+  }
+  slot.hours.clear();
+}
+
+void CE::StepHashes::check(const uint64_t hour, const uint64_t hash) {
+  ++hashed_;
+  stream_ << hour << ' ' << hex(hash) << '\n';
+  if (!verifying_) {
+    return;
+  }
+  const auto golden = golden_.find(hour);
+  if (golden == golden_.end()) {
+    return;
+  }
+  ++compared_;
+  if (golden->second == hash) {
+    return;
+  }
+  if (mismatches_++ == 0) {
+    first_mismatch_hour_ = hour;
+    first_expected_ = golden->second;
+    first_actual_ = hash;
+    Log::text("{ !!! }",
+              "Step hashes diverge at hour",
+              hour,
+              "expected",
+              hex(golden->second),
+              "got",
+              hex(hash));
+  }
+}
+
+void CE::StepHashes::flush() {
+  if (!enabled_) {
+    return;
+  }
+  // Slots still in flight hold later hours than every slot collected so far.
+  std::array<uint32_t, MAX_FRAME_LATENCY> order{};
+  for (uint32_t slot = 0; slot < MAX_FRAME_LATENCY; ++slot) {
+    order[slot] = slot;
+  }
+  std::sort(order.begin(), order.end(), [this](const uint32_t a, const uint32_t b) {
+    const std::vector<uint64_t> &hours_a = slots_[a].hours;
+    const std::vector<uint64_t> &hours_b = slots_[b].hours;
+    return !hours_a.empty() && (hours_b.empty() || hours_a.front() < hours_b.front());
+  });
+  for (const uint32_t slot : order) {
+    collect(slot);
+  }
+  stream_.close();
+  enabled_ = false;
+
+  if (dropped_ > 0) {
+    Log::text(
+        "{ !!! }", "Step hashes:", dropped_, "hours beyond", max_hashes, "per frame unhashed");
+  }
+  if (!verifying_) {
+    Log::text("{ PERF }", "Step hashes:", hashed_, "hours written to", path_);
+  } else if (mismatches_ > 0) {
+    Log::text("{ !!! }",
+              "Step hashes:",
+              mismatches_,
+              "of",
+              compared_,
+              "hours differ from",
+              path_,
+              "- first at hour",
+              first_mismatch_hour_,
+              "expected",
+              hex(first_expected_),
+              "got",
+              hex(first_actual_));
+  } else if (compared_ == 0) {
+    Log::text("{ !!! }", "Step hashes: no hour of this run is in", path_);
+  } else {
+    Log::text("{ PERF }",
+              "Step hashes match",
+              path_,
+              compared_,
+              "hours compared",
+              golden_.size() - compared_,
+              "golden hours not reached");
+  }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// GPU-computed 64-bit hashes of the cell state after every simulation step.
+// Exists to check optimized Engine/SeedCells kernels against a golden run step by step.
+#include <vulkan/vulkan.h>
+
+#include "vulkan_base/VulkanBaseDescriptor.h"
+#include "vulkan_base/VulkanBaseResources.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CE {
+
+// CellHash.comp folds every cell's states, alive code and quantized position into one
+// 64-bit hash of the state SeedCells or an Engine step left behind, straight into a
+// host-visible slot of the frame; collect() reads the slot once the submission completed.
+//
+// CE_VERIFY_HASHES names a text file of "<hour> <16 hex digits>" lines. When it does not
+// exist the run writes it; when it does, the run compares every hour against it, writes its
+// own list to "<file>.last" and fails at exit on the first hour that differs.
+class StepHashes {
+public:
+  // Hashes one submission can hold: fast-forward's largest batch plus the startup seed.
+  static constexpr uint32_t max_hashes = 8192;
+  static constexpr uint32_t hash_words = 2;
+
+  StepHashes();
+  StepHashes(const StepHashes &) = delete;
+  StepHashes &operator=(const StepHashes &) = delete;
+  StepHashes(StepHashes &&) = delete;
+  StepHashes &operator=(StepHashes &&) = delete;
+  ~StepHashes() = default;
+
+  bool enabled() const {
+    return enabled_;
+  }
+  static VkDeviceSize slot_words() {
+    return static_cast<VkDeviceSize>(max_hashes) * hash_words;
+  }
+
+  // Ahead of the first CellHash dispatch of a submission: clears the first count hashes of
+  // this frame's slot of log.
+  void begin(VkCommandBuffer command_buffer,
+             const uint32_t frame_index,
+             const BaseBuffer &log,
+             const uint32_t count);
+  // Reserves the next hash of the slot for the state of hour; returns false when the slot
+  // is full. word is CellHash's push constant.
+  bool add(const uint32_t frame_index, const uint64_t hour, uint32_t &word);
+  // After the submission's last CellHash dispatch: publishes the slot to the host.
+  void end(VkCommandBuffer command_buffer);
+  // Call once the slot's previous compute submission has completed.
+  void collect(const uint32_t frame_index);
+  // Collects everything still in flight and reports the comparison; the device must be idle.
+  void flush();
+  // Some hour's hash differed from the golden file.
+  bool diverged() const {
+    return mismatches_ > 0;
+  }
+  const std::string &path() const {
+    return path_;
+  }
+
+private:
+  struct Slot {
+    VkDeviceSize word_offset{0};
+    uint32_t capacity{0};
+    // Hour of each reserved hash, in slot order.
+    std::vector<uint64_t> hours{};
+  };
+
+  bool enabled_{false};
+  bool verifying_{false};
+  std::string path_{};
+  std::unordered_map<uint64_t, uint64_t> golden_{};
+  std::ofstream stream_{};
+
+  std::array<Slot, MAX_FRAME_LATENCY> slots_{};
+  const uint32_t *log_mapped_{nullptr};
+
+  uint64_t hashed_{0};
+  uint64_t dropped_{0};
+  uint64_t compared_{0};
+  uint64_t mismatches_{0};
+  uint64_t first_mismatch_hour_{0};
+  uint64_t first_expected_{0};
+  uint64_t first_actual_{0};
+
+  void check(const uint64_t hour, const uint64_t hash);
+};
+
+} // namespace CE
@@ -1,5 +1,7 @@
 #include "engine/CapitalEngine.h"
 #include "engine/Log.h"
+#include "world/CellStepper.h"
+#include "world/ConwayBits.h"
 #include "world/RuntimeConfig.h"
 #include "world/SceneConfig.h"
 
@@ -12,6 +14,15 @@ int main() {
       return EXIT_SUCCESS;
     }
 
+    if (CE::Runtime::env_flag_enabled(CE::Runtime::kEnvCpuStepper)) {
+      CellStepper::run_benchmark();
+      return EXIT_SUCCESS;
+    }
+    if (CE::Runtime::env_flag_enabled(CE::Runtime::kEnvCpuConway)) {
+      ConwayBits::run_benchmark();
+      return EXIT_SUCCESS;
+    }
+
     CapitalEngine GENERATIONS;
     GENERATIONS.main_loop();
 
@@ -14,7 +14,11 @@
 namespace CE {
 
 constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
-constexpr size_t NUM_DESCRIPTORS = 5;
+// Capacity of the per-frame command buffer/semaphore ring; how much of it is used is
+// BaseSynchronizationObjects::frames_in_flight. Descriptor sets stay at
+// MAX_FRAMES_IN_FLIGHT, since compute picks them by cell buffer side, not by frame.
+constexpr uint32_t MAX_FRAME_LATENCY = 4;
+constexpr size_t NUM_DESCRIPTORS = 18;
 
 class BaseDescriptorInterface {
 public:
@@ -63,4 +67,5 @@ protected:
 } // namespace CE
 
 constexpr uint32_t MAX_FRAMES_IN_FLIGHT = CE::MAX_FRAMES_IN_FLIGHT;
+constexpr uint32_t MAX_FRAME_LATENCY = CE::MAX_FRAME_LATENCY;
 constexpr size_t NUM_DESCRIPTORS = CE::NUM_DESCRIPTORS;
@@ -3,6 +3,7 @@
 #include "VulkanBaseUtils.h"
 
 #include "engine/Log.h"
+#include "world/RuntimeConfig.h"
 
 #include <algorithm>
 #include <cctype>
@@ -287,7 +288,7 @@ void CE::BaseDevice::create_logical_device(const BaseInitializeVulkan &init_vulk
                    0,
            &queues.graphics_queue);
   vkGetDeviceQueue(this->logical_device,
-       queues.indices.graphics_and_compute_family.value(),
+       queues.indices.compute_family.value(),
                    0,
            &queues.compute_queue);
   vkGetDeviceQueue(
@@ -297,6 +298,10 @@ void CE::BaseDevice::create_logical_device(const BaseInitializeVulkan &init_vulk
     Log::text(Log::Style::char_leader,
             "graphics/compute queue family",
       queues.indices.graphics_and_compute_family.value());
+    Log::text(Log::Style::char_leader,
+            "compute queue family",
+      queues.indices.compute_family.value(),
+      queues.indices.async_compute() ? "(async)" : "(shared)");
     Log::text(Log::Style::char_leader,
             "present queue family",
       queues.indices.present_family.value());
@@ -305,12 +310,18 @@ void CE::BaseDevice::create_logical_device(const BaseInitializeVulkan &init_vulk
       queues.graphics_queue,
       queues.compute_queue,
       queues.present_queue);
+
+  this->allocator_.create(init_vulkan.instance, this->physical_device, this->logical_device);
 }
 
 void CE::BaseDevice::pick_physical_device(const BaseInitializeVulkan &init_vulkan,
                     BaseQueues &queues,
                     BaseSwapchain &swapchain) {
   Log::text("{ ### }", "Physical BaseDevice");
+  if (init_vulkan.surface == VK_NULL_HANDLE) {
+    // Headless: nothing is presented, so the swapchain extension is not required.
+    this->extensions_.clear();
+  }
   std::vector<VkPhysicalDevice> devices = fill_devices(init_vulkan);
   const GpuLogSettings &gpu_log = gpu_log_settings();
   const bool startup_gpu_logs = gpu_log.enabled && gpu_log.startup;
@@ -340,9 +351,8 @@ void CE::BaseDevice::pick_physical_device(const BaseInitializeVulkan &init_vulka
     }
     if (is_device_suitable(device, queues, init_vulkan, swapchain)) {
       this->physical_device = device;
-      VkPhysicalDeviceMemoryProperties memory_properties{};
-      vkGetPhysicalDeviceMemoryProperties(this->physical_device, &memory_properties);
-      this->device_local_heap_total_bytes_ = get_local_heap_total(memory_properties);
+      vkGetPhysicalDeviceMemoryProperties(this->physical_device, &this->memory_properties_);
+      this->device_local_heap_total_bytes_ = get_local_heap_total(this->memory_properties_);
 
       uint32_t extension_count = 0;
       vkEnumerateDeviceExtensionProperties(
@@ -373,7 +383,9 @@ void CE::BaseDevice::pick_physical_device(const BaseInitializeVulkan &init_vulka
                   "graphics+compute",
                   queues.indices.graphics_and_compute_family.value(),
                   "-> present",
-                  queues.indices.present_family.value());
+                  queues.indices.present_family.value(),
+                  "compute",
+                  queues.indices.compute_family.value());
       }
       break;
     }
@@ -442,7 +454,8 @@ CE::BaseDevice::fill_queue_create_infos(const BaseQueues &queues) const {
   std::vector<VkDeviceQueueCreateInfo> queue_create_infos{};
   const std::set<uint32_t> unique_queue_families = {
       queues.indices.graphics_and_compute_family.value(),
-      queues.indices.present_family.value()};
+      queues.indices.present_family.value(),
+      queues.indices.compute_family.value()};
 
   const float queue_priority = 1.0f;
   for (uint_fast8_t queue_family : unique_queue_families) {
@@ -460,6 +473,7 @@ VkDeviceCreateInfo CE::BaseDevice::get_device_create_info(
     const std::vector<VkDeviceQueueCreateInfo> &queue_create_infos) const {
   VkDeviceCreateInfo create_info{
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .pNext = &this->features_12,
       .queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size()),
       .pQueueCreateInfos = queue_create_infos.data(),
       .enabledLayerCount = 0,
@@ -503,7 +517,9 @@ bool CE::BaseDevice::is_device_suitable(const VkPhysicalDevice &physical_device,
   const bool extensions_supported = check_device_extension_support(physical_device);
 
   bool swapchain_adequate = false;
-  if (extensions_supported) {
+  if (init_vulkan.surface == VK_NULL_HANDLE) {
+    swapchain_adequate = extensions_supported;
+  } else if (extensions_supported) {
     BaseSwapchain::SupportDetails swapchain_support =
       swapchain.check_support(physical_device, init_vulkan.surface);
     swapchain_adequate =
@@ -584,6 +600,7 @@ void CE::BaseDevice::destroy_device() {
     Log::text(
         "{ +++ }", "Destroy BaseDevice", this->logical_device, "@", &this->logical_device);
     extensions_.clear();
+    this->allocator_.destroy();
     vkDestroyDevice(this->logical_device, nullptr);
     destroyed_devices.push_back(this->logical_device);
     if (BaseDevice::base_device == this) {
@@ -617,10 +634,16 @@ CE::BaseQueues::find_queue_families(const VkPhysicalDevice &physical_device,
         (queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
       indices.graphics_and_compute_family = i;
     }
-    VkBool32 present_support = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
-    if (present_support) {
-      indices.present_family = i;
+    if (surface == VK_NULL_HANDLE) {
+      // Headless: no surface to present to, alias the present family so the
+      // rest of device/queue setup stays unchanged.
+      indices.present_family = indices.graphics_and_compute_family;
+    } else {
+      VkBool32 present_support = false;
+      vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
+      if (present_support) {
+        indices.present_family = i;
+      }
     }
     if (indices.is_complete()) {
       Log::text(Log::Style::char_leader,
@@ -633,6 +656,21 @@ CE::BaseQueues::find_queue_families(const VkPhysicalDevice &physical_device,
     }
     i++;
   }
+
+  // A compute-only family is what discrete GPUs expose for async compute; the Engine step
+  // then overlaps rendering instead of queuing behind it.
+  indices.compute_family = indices.graphics_and_compute_family;
+  if (indices.is_complete() &&
+      !CE::Runtime::env_flag_enabled(CE::Runtime::kEnvSharedComputeQueue)) {
+    for (uint32_t family = 0; family < queue_family_count; ++family) {
+      const VkQueueFlags flags = queue_families[family].queueFlags;
+      if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+        indices.compute_family = family;
+        Log::text(Log::Style::char_leader, "dedicated compute family", family);
+        break;
+      }
+    }
+  }
   return indices;
 }
 
@@ -640,6 +678,10 @@ CE::BaseInitializeVulkan::BaseInitializeVulkan() {
   Log::text("{ VkI }", "constructing Initialize Vulkan");
   create_instance();
   this->validation.setup_debug_messenger(this->instance);
+  if (Window::get().is_headless()) {
+    Log::text("{ [ ] }", "Surface skipped (headless)");
+    return;
+  }
   create_surface(Window::get().window);
 }
 
@@ -649,7 +691,9 @@ CE::BaseInitializeVulkan::~BaseInitializeVulkan() {
     this->validation.destroy_debug_utils_messenger_ext(
         this->instance, this->validation.debug_messenger, nullptr);
   }
-  vkDestroySurfaceKHR(this->instance, this->surface, nullptr);
+  if (this->surface != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(this->instance, this->surface, nullptr);
+  }
   vkDestroyInstance(this->instance, nullptr);
 }
 
@@ -705,12 +749,13 @@ void CE::BaseInitializeVulkan::create_surface(GLFWwindow *window) {
 }
 
 std::vector<const char *> CE::BaseInitializeVulkan::get_required_extensions() const {
-  uint32_t glfw_extension_count(0);
-  const char **glfw_extensions;
-  glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
-  std::vector<const char *> extensions(glfw_extensions,
-                                       glfw_extensions + glfw_extension_count);
+  std::vector<const char *> extensions{};
+  if (!Window::get().is_headless()) {
+    uint32_t glfw_extension_count(0);
+    const char **glfw_extensions;
+    glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    extensions.assign(glfw_extensions, glfw_extensions + glfw_extension_count);
+  }
   if (this->validation.enable_validation_layers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
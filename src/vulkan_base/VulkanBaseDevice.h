@@ -10,6 +10,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include "vulkan_base/VulkanBaseMemory.h"
 #include "vulkan_base/VulkanBaseValidationLayers.h"
 #include "control/Window.h"
 
@@ -26,9 +27,15 @@ public:
   struct FamilyIndices {
     std::optional<uint32_t> graphics_and_compute_family{};
     std::optional<uint32_t> present_family{};
+    // A compute-only family when the device has one, else graphics_and_compute_family.
+    std::optional<uint32_t> compute_family{};
     bool is_complete() const {
       return graphics_and_compute_family.has_value() && present_family.has_value();
     }
+    // Simulation runs on its own queue; cell data crossing to graphics changes owner.
+    bool async_compute() const {
+      return compute_family.has_value() && compute_family != graphics_and_compute_family;
+    }
   };
 
   FamilyIndices indices{};
@@ -76,9 +83,22 @@ public:
   }
 
   void maybe_log_gpu_runtime_sample();
+  const VkPhysicalDeviceProperties &properties() const {
+    return properties_;
+  }
+  // Queried once when the physical device is picked.
+  const VkPhysicalDeviceMemoryProperties &memory_properties() const {
+    return memory_properties_;
+  }
+  BaseAllocator &allocator() {
+    return allocator_;
+  }
 
 protected:
   VkPhysicalDeviceFeatures features{};
+  // Chained into device creation; Vulkan 1.2 core features such as 8-bit storage.
+  VkPhysicalDeviceVulkan12Features features_12{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
   void pick_physical_device(const BaseInitializeVulkan &init_vulkan,
                             BaseQueues &queues,
                             BaseSwapchain &swapchain);
@@ -87,6 +107,8 @@ protected:
 
 private:
   VkPhysicalDeviceProperties properties_{};
+  VkPhysicalDeviceMemoryProperties memory_properties_{};
+  BaseAllocator allocator_{};
   bool memory_budget_supported_{false};
   VkDeviceSize device_local_heap_total_bytes_{0};
   std::chrono::steady_clock::time_point last_gpu_runtime_log_{};
@@ -0,0 +1,201 @@
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
+
+#include "VulkanBaseMemory.h"
+#include "VulkanBaseUtils.h"
+
+#include "engine/Log.h"
+
+#include <stdexcept>
+
+namespace {
+
+constexpr std::array<const char *, 3> pool_names{"Staging", "DeviceLocal", "Uniform"};
+
+} // namespace
+
+void CE::BaseAllocator::create(const VkInstance instance,
+                               const VkPhysicalDevice physical_device,
+                               const VkDevice logical_device) {
+  Log::text("{ MEM }", "Device Memory Allocator");
+
+  VmaAllocatorCreateInfo createInfo{};
+  createInfo.physicalDevice = physical_device;
+  createInfo.device = logical_device;
+  createInfo.instance = instance;
+  createInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+
+  CE::vulkan_result(vmaCreateAllocator, &createInfo, &this->allocator);
+}
+
+void CE::BaseAllocator::destroy() {
+  if (this->allocator == VK_NULL_HANDLE) {
+    return;
+  }
+  for (Pool &pool : this->pools_) {
+    if (pool.pool != VK_NULL_HANDLE) {
+      vmaDestroyPool(this->allocator, pool.pool);
+      pool.pool = VK_NULL_HANDLE;
+    }
+  }
+  vmaDestroyAllocator(this->allocator);
+  this->allocator = VK_NULL_HANDLE;
+}
+
+std::optional<CE::MemoryPool>
+CE::BaseAllocator::select_pool(const VkBufferUsageFlags usage,
+                               const VkMemoryPropertyFlags properties) {
+  if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    return (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) ? MemoryPool::Uniform
+                                                        : MemoryPool::Staging;
+  }
+  if (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+    return MemoryPool::DeviceLocal;
+  }
+  return std::nullopt;
+}
+
+VmaPool CE::BaseAllocator::get_pool(const MemoryPool kind,
+                                    const VkMemoryRequirements &requirements,
+                                    const VkMemoryPropertyFlags properties) {
+  Pool &pool = this->pools_[static_cast<size_t>(kind)];
+  if (pool.block_size != 0 && requirements.size > pool.block_size) {
+    return VK_NULL_HANDLE;
+  }
+
+  // Pools are pinned to one memory type, chosen by the first buffer that lands in them.
+  if (pool.pool == VK_NULL_HANDLE) {
+    pool.memory_type = CE::find_memory_type(requirements.memoryTypeBits, properties);
+    vmaGetMemoryTypeProperties(this->allocator, pool.memory_type, &pool.memory_flags);
+
+    VmaPoolCreateInfo poolInfo{};
+    poolInfo.memoryTypeIndex = pool.memory_type;
+    poolInfo.blockSize = pool.block_size;
+    CE::vulkan_result(vmaCreatePool, this->allocator, &poolInfo, &pool.pool);
+    vmaSetPoolName(this->allocator, pool.pool, pool_names[static_cast<size_t>(kind)]);
+
+    Log::text("{ MEM }",
+              "pool",
+              pool_names[static_cast<size_t>(kind)],
+              "memoryType",
+              pool.memory_type,
+              "blockSize",
+              pool.block_size);
+  }
+
+  // A later buffer of the same kind may need flags the first one did not (HOST_CACHED for a
+  // readback landing in Staging, say), or allow only other types.
+  if ((requirements.memoryTypeBits & (1u << pool.memory_type)) == 0 ||
+      (pool.memory_flags & properties) != properties) {
+    return VK_NULL_HANDLE;
+  }
+  return pool.pool;
+}
+
+VmaAllocation CE::BaseAllocator::allocate_buffer(const VkBuffer buffer,
+                                                 const VkMemoryRequirements &requirements,
+                                                 const VkBufferUsageFlags usage,
+                                                 const VkMemoryPropertyFlags properties) {
+  VmaAllocationCreateInfo allocationInfo{};
+  allocationInfo.requiredFlags = properties;
+  allocationInfo.memoryTypeBits = requirements.memoryTypeBits;
+
+  const std::optional<MemoryPool> kind = select_pool(usage, properties);
+  if (kind) {
+    allocationInfo.pool = get_pool(*kind, requirements, properties);
+  }
+
+  VmaAllocation allocation{};
+  VmaAllocationInfo placement{};
+  CE::vulkan_result(
+      vmaAllocateMemoryForBuffer, this->allocator, buffer, &allocationInfo, &allocation, &placement);
+  CE::vulkan_result(vmaBindBufferMemory, this->allocator, allocation, buffer);
+
+  Log::text(Log::Style::char_leader,
+            "pool",
+            allocationInfo.pool ? pool_names[static_cast<size_t>(*kind)] : "default",
+            "memoryType",
+            placement.memoryType,
+            "offset",
+            placement.offset,
+            "size",
+            placement.size);
+  return allocation;
+}
+
+VmaAllocation CE::BaseAllocator::allocate_image(const VkImage image,
+                                                const VkMemoryPropertyFlags properties) {
+  VmaAllocationCreateInfo allocationInfo{};
+  allocationInfo.requiredFlags = properties;
+
+  VmaAllocation allocation{};
+  VmaAllocationInfo placement{};
+  CE::vulkan_result(
+      vmaAllocateMemoryForImage, this->allocator, image, &allocationInfo, &allocation, &placement);
+  CE::vulkan_result(vmaBindImageMemory, this->allocator, allocation, image);
+
+  Log::text(Log::Style::char_leader,
+            "memoryType",
+            placement.memoryType,
+            "offset",
+            placement.offset,
+            "size",
+            placement.size);
+  return allocation;
+}
+
+void CE::BaseAllocator::free(VmaAllocation &allocation) {
+  if (this->allocator != VK_NULL_HANDLE && allocation != VK_NULL_HANDLE) {
+    vmaFreeMemory(this->allocator, allocation);
+  }
+  allocation = VK_NULL_HANDLE;
+}
+
+void *CE::BaseAllocator::map(const VmaAllocation allocation) {
+  void *data{};
+  CE::vulkan_result(vmaMapMemory, this->allocator, allocation, &data);
+  return data;
+}
+
+void CE::BaseAllocator::unmap(const VmaAllocation allocation) {
+  vmaUnmapMemory(this->allocator, allocation);
+}
+
+void CE::BaseAllocator::log_statistics() const {
+  if (this->allocator == VK_NULL_HANDLE) {
+    return;
+  }
+  for (size_t i = 0; i < this->pools_.size(); ++i) {
+    if (this->pools_[i].pool == VK_NULL_HANDLE) {
+      continue;
+    }
+    VmaDetailedStatistics stats{};
+    vmaCalculatePoolStatistics(this->allocator, this->pools_[i].pool, &stats);
+    Log::text("{ MEM }",
+              "pool",
+              pool_names[i],
+              "blocks",
+              stats.statistics.blockCount,
+              "allocations",
+              stats.statistics.allocationCount,
+              "used",
+              stats.statistics.allocationBytes,
+              "/",
+              stats.statistics.blockBytes,
+              "bytes");
+  }
+
+  VmaTotalStatistics total{};
+  vmaCalculateStatistics(this->allocator, &total);
+  Log::text("{ MEM }",
+            "total",
+            "vkAllocateMemory",
+            total.total.statistics.blockCount,
+            "resources",
+            total.total.statistics.allocationCount,
+            "used",
+            total.total.statistics.allocationBytes,
+            "/",
+            total.total.statistics.blockBytes,
+            "bytes");
+}
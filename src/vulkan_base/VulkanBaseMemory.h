@@ -0,0 +1,68 @@
+#pragma once
+
+// Device memory sub-allocator on top of the bundled Vulkan Memory Allocator.
+// Exists so buffers and images share large blocks instead of one vkAllocateMemory each.
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <vulkan/vulkan.h>
+
+#include <vk_mem_alloc.h>
+
+namespace CE {
+
+enum class MemoryPool : uint8_t { Staging = 0, DeviceLocal = 1, Uniform = 2 };
+
+class BaseAllocator {
+public:
+  VmaAllocator allocator{VK_NULL_HANDLE};
+
+  BaseAllocator() = default;
+  BaseAllocator(const BaseAllocator &) = delete;
+  BaseAllocator &operator=(const BaseAllocator &) = delete;
+  BaseAllocator(BaseAllocator &&) = delete;
+  BaseAllocator &operator=(BaseAllocator &&) = delete;
+  virtual ~BaseAllocator() {
+    destroy();
+  }
+
+  void create(const VkInstance instance,
+              const VkPhysicalDevice physical_device,
+              const VkDevice logical_device);
+  void destroy();
+
+  // Allocates from the pool matching usage/properties (or the default pools) and binds.
+  VmaAllocation allocate_buffer(const VkBuffer buffer,
+                                const VkMemoryRequirements &requirements,
+                                const VkBufferUsageFlags usage,
+                                const VkMemoryPropertyFlags properties);
+  VmaAllocation allocate_image(const VkImage image, const VkMemoryPropertyFlags properties);
+  void free(VmaAllocation &allocation);
+
+  void *map(const VmaAllocation allocation);
+  void unmap(const VmaAllocation allocation);
+
+  // One { MEM } line per pool plus totals: Vulkan allocations vs. resources placed in them.
+  void log_statistics() const;
+
+private:
+  struct Pool {
+    VmaPool pool{VK_NULL_HANDLE};
+    uint32_t memory_type{UINT32_MAX};
+    // Everything memory_type offers; requests needing more go to the default pools.
+    VkMemoryPropertyFlags memory_flags{0};
+    // 0 lets VMA grow blocks on its own (and place oversized requests in dedicated memory).
+    VkDeviceSize block_size{0};
+  };
+  std::array<Pool, 3> pools_{Pool{}, Pool{}, Pool{.block_size = 1024 * 1024}};
+
+  static std::optional<MemoryPool> select_pool(const VkBufferUsageFlags usage,
+                                               const VkMemoryPropertyFlags properties);
+  VmaPool get_pool(const MemoryPool kind,
+                   const VkMemoryRequirements &requirements,
+                   const VkMemoryPropertyFlags properties);
+};
+
+} // namespace CE
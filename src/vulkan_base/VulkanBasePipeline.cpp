@@ -3,15 +3,25 @@
 #include "VulkanBaseUtils.h"
 
 #include "library/Library.h"
+#include "library/ShaderCompiler.h"
 #include "engine/Log.h"
+#include "engine/Trace.h"
+#include "world/RuntimeConfig.h"
 
 #include <array>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstring>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 
@@ -48,8 +58,159 @@ std::string resolve_shader_spv_path(const std::string &shader_dir,
   return alias_path;
 }
 
+constexpr std::array<char, 4> pipeline_cache_magic{'C', 'E', 'P', 'C'};
+constexpr uint32_t pipeline_cache_format = 1;
+const std::filesystem::path pipeline_cache_dir = "pipeline_cache";
+
+// Prefixed to the driver blob; the driver version is not part of the Vulkan cache header.
+struct PipelineCacheFileHeader {
+  std::array<char, 4> magic{};
+  uint32_t format{};
+  uint32_t vendor_id{};
+  uint32_t device_id{};
+  uint32_t driver_version{};
+  std::array<uint8_t, VK_UUID_SIZE> cache_uuid{};
+  uint32_t reserved{};
+  uint64_t payload_size{};
+};
+static_assert(sizeof(PipelineCacheFileHeader) == 48, "header is compared bytewise; keep it padding-free");
+
+PipelineCacheFileHeader make_pipeline_cache_header(const VkPhysicalDeviceProperties &properties,
+                                                   const uint64_t payload_size) {
+  PipelineCacheFileHeader header{.magic = pipeline_cache_magic,
+                                 .format = pipeline_cache_format,
+                                 .vendor_id = properties.vendorID,
+                                 .device_id = properties.deviceID,
+                                 .driver_version = properties.driverVersion,
+                                 .payload_size = payload_size};
+  std::memcpy(header.cache_uuid.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+  return header;
+}
+
+std::string pipeline_cache_path(const VkPhysicalDeviceProperties &properties) {
+  std::ostringstream name;
+  name << std::hex << std::setfill('0');
+  for (const uint8_t byte : properties.pipelineCacheUUID) {
+    name << std::setw(2) << static_cast<uint32_t>(byte);
+  }
+  name << std::dec << "_" << properties.driverVersion << ".bin";
+  return (pipeline_cache_dir / name.str()).string();
+}
+
 } // namespace
 
+CE::BasePipelineCache::~BasePipelineCache() {
+  if (BaseDevice::base_device && this->cache != VK_NULL_HANDLE) {
+    vkDestroyPipelineCache(BaseDevice::base_device->logical_device, this->cache, nullptr);
+  }
+}
+
+std::vector<char> CE::BasePipelineCache::load(const VkPhysicalDeviceProperties &properties) const {
+  std::error_code error{};
+  const uintmax_t file_size = std::filesystem::file_size(path_, error);
+  std::ifstream file(path_, std::ios::binary);
+  if (error || !file) {
+    return {};
+  }
+
+  PipelineCacheFileHeader stored{};
+  file.read(reinterpret_cast<char *>(&stored), sizeof(stored));
+  const PipelineCacheFileHeader expected = make_pipeline_cache_header(properties, stored.payload_size);
+  if (!file || std::memcmp(&stored, &expected, sizeof(stored)) != 0 ||
+      stored.payload_size != file_size - sizeof(stored)) {
+    Log::text("{ PERF }", "Pipeline cache", path_, "rejected: header mismatch");
+    return {};
+  }
+
+  std::vector<char> payload(stored.payload_size);
+  file.read(payload.data(), static_cast<std::streamsize>(payload.size()));
+  if (!file) {
+    Log::text("{ PERF }", "Pipeline cache", path_, "rejected: truncated");
+    return {};
+  }
+
+  // The driver validates its own header too, but a mismatch there silently yields an
+  // empty cache; checking here keeps the log honest about cold starts.
+  VkPipelineCacheHeaderVersionOne driver_header{};
+  if (payload.size() < sizeof(driver_header)) {
+    return {};
+  }
+  std::memcpy(&driver_header, payload.data(), sizeof(driver_header));
+  if (driver_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+      driver_header.vendorID != properties.vendorID ||
+      driver_header.deviceID != properties.deviceID ||
+      std::memcmp(driver_header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) !=
+          0) {
+    Log::text("{ PERF }", "Pipeline cache", path_, "rejected: driver header mismatch");
+    return {};
+  }
+  return payload;
+}
+
+void CE::BasePipelineCache::create() {
+  const auto start = std::chrono::steady_clock::now();
+  const VkPhysicalDeviceProperties &properties = BaseDevice::base_device->properties();
+  path_ = pipeline_cache_path(properties);
+
+  const std::vector<char> initial_data = load(properties);
+  VkPipelineCacheCreateInfo create_info{.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                        .initialDataSize = initial_data.size(),
+                                        .pInitialData =
+                                            initial_data.empty() ? nullptr : initial_data.data()};
+  CE::vulkan_result(vkCreatePipelineCache,
+                    BaseDevice::base_device->logical_device,
+                    &create_info,
+                    nullptr,
+                    &this->cache);
+
+  const auto end = std::chrono::steady_clock::now();
+  const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+  Trace::complete("pipeline cache load", start, end);
+  Log::text("{ PERF }",
+            "Pipeline cache",
+            initial_data.empty() ? "cold" : "warm",
+            initial_data.size(),
+            "bytes loaded in",
+            ms,
+            "ms");
+}
+
+void CE::BasePipelineCache::save() const {
+  if (this->cache == VK_NULL_HANDLE || path_.empty()) {
+    return;
+  }
+  const VkDevice device = BaseDevice::base_device->logical_device;
+
+  size_t size = 0;
+  CE::vulkan_result(vkGetPipelineCacheData, device, this->cache, &size, nullptr);
+  std::vector<char> payload(size);
+  CE::vulkan_result(vkGetPipelineCacheData, device, this->cache, &size, payload.data());
+  payload.resize(size);
+
+  const PipelineCacheFileHeader header =
+      make_pipeline_cache_header(BaseDevice::base_device->properties(), payload.size());
+
+  // Write-then-rename so an interrupted save never leaves a torn cache behind.
+  std::error_code error{};
+  std::filesystem::create_directories(pipeline_cache_dir, error);
+  const std::string temp_path = path_ + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    if (!file) {
+      Log::text("{ !!! }", "Pipeline cache write failed:", temp_path);
+      return;
+    }
+  }
+  std::filesystem::rename(temp_path, path_, error);
+  if (error) {
+    Log::text("{ !!! }", "Pipeline cache rename failed:", path_, error.message());
+    return;
+  }
+  Log::text("{ PERF }", "Pipeline cache saved", payload.size(), "bytes to", path_);
+}
+
 CE::BaseRenderPass::~BaseRenderPass() {
   Log::text("{ []< }", "destructing Render Pass");
   if (BaseDevice::base_device) {
@@ -58,7 +219,8 @@ CE::BaseRenderPass::~BaseRenderPass() {
 }
 
 void CE::BaseRenderPass::create(VkSampleCountFlagBits msaa_image_samples,
-                            VkFormat swapchain_image_format) {
+                            VkFormat swapchain_image_format,
+                            VkImageLayout final_layout) {
   Log::text("{ []< }", "Render Pass");
   Log::text(Log::Style::char_leader,
             "colorAttachment, depthAttachment, colorAttachmentResolve");
@@ -91,7 +253,7 @@ void CE::BaseRenderPass::create(VkSampleCountFlagBits msaa_image_samples,
       .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
       .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
       .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-      .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+      .finalLayout = final_layout};
 
   VkAttachmentReference colorAttachmentRef{
       .attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
@@ -186,11 +348,43 @@ void CE::BasePipelinesConfiguration::create_pipelines(VkRenderPass &render_pass,
     throw std::runtime_error("\n!ERROR! No pipeline configurations defined.");
   }
 
-  const auto pipelinesStart = std::chrono::high_resolution_clock::now();
+  const auto pipelinesStart = std::chrono::steady_clock::now();
+  if (this->pipeline_cache.cache == VK_NULL_HANDLE) {
+    this->pipeline_cache.create();
+  }
+
+  // Everything a create call points at lives here, so all create infos can be assembled up
+  // front and handed to worker threads without dangling pointers.
+  struct PipelineBuild {
+    std::string name{};
+    VkPipeline *target{nullptr};
+    bool is_compute{false};
+
+    std::vector<VkPipelineShaderStageCreateInfo> shader_stages{};
+    VkPipelineVertexInputStateCreateInfo vertex_input{};
+    VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+    VkPipelineTessellationStateCreateInfo tessellation{};
+    VkPipelineViewportStateCreateInfo viewport{};
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+    VkPipelineColorBlendAttachmentState color_blend_attachment{};
+    VkPipelineColorBlendStateCreateInfo color_blend{};
+    VkPipelineDynamicStateCreateInfo dynamic{};
+    VkGraphicsPipelineCreateInfo graphics_info{};
+    VkComputePipelineCreateInfo compute_info{};
+
+    // Core in Vulkan 1.3; reports whether the driver served the pipeline from the cache.
+    VkPipelineCreationFeedback feedback{};
+    VkPipelineCreationFeedbackCreateInfo feedback_info{};
+
+    double ms{0.0};
+  };
 
-  for (auto &[pipelineName, pipelineVariant] : this->pipeline_map) {
-    const auto pipelineStart = std::chrono::high_resolution_clock::now();
+  std::vector<std::unique_ptr<PipelineBuild>> builds{};
+  builds.reserve(this->pipeline_map.size());
 
+  for (auto &[pipelineName, pipelineVariant] : this->pipeline_map) {
     std::vector<std::string> shaders = get_pipeline_shaders_by_name(pipelineName);
     if (shaders.empty()) {
       throw std::runtime_error("\n!ERROR! Pipeline has no shaders: " + pipelineName);
@@ -201,10 +395,18 @@ void CE::BasePipelinesConfiguration::create_pipelines(VkRenderPass &render_pass,
         return shader.ends_with("Comp");
       });
 
+    auto build = std::make_unique<PipelineBuild>();
+    PipelineBuild &b = *build;
+    b.name = pipelineName;
+    b.target = &get_pipeline_object_by_name(pipelineName);
+    b.is_compute = isCompute;
+    b.feedback_info = VkPipelineCreationFeedbackCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+        .pPipelineCreationFeedback = &b.feedback};
+
     if (!isCompute) {
       Log::text("{ === }", "Graphics Pipeline: ", pipelineName);
-      std::vector<VkPipelineShaderStageCreateInfo> shaderStages{};
-      bool tesselationEnabled = set_shader_stages(pipelineName, shaderStages);
+      bool tesselationEnabled = set_shader_stages(pipelineName, b.shader_stages);
 
       const auto &bindingDescription =
             std::get<CE::BasePipelinesConfiguration::Graphics>(pipelineVariant).vertex_bindings;
@@ -228,113 +430,102 @@ void CE::BasePipelinesConfiguration::create_pipelines(VkRenderPass &render_pass,
                                  : "VK_VERTEX_INPUT_RATE_VERTEX");
       }
 
-      VkPipelineVertexInputStateCreateInfo vertexInput{CE::vertex_input_state_default};
-      vertexInput.vertexBindingDescriptionCount = bindingsSize;
-      vertexInput.vertexAttributeDescriptionCount = attributeSize;
-      vertexInput.pVertexBindingDescriptions = bindingDescription.data();
-      vertexInput.pVertexAttributeDescriptions = attributesDescription.data();
+      b.vertex_input = CE::vertex_input_state_default;
+      b.vertex_input.vertexBindingDescriptionCount = bindingsSize;
+      b.vertex_input.vertexAttributeDescriptionCount = attributeSize;
+      b.vertex_input.pVertexBindingDescriptions = bindingDescription.data();
+      b.vertex_input.pVertexAttributeDescriptions = attributesDescription.data();
 
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{
-          CE::input_assembly_state_triangle_list};
+      b.input_assembly = CE::input_assembly_state_triangle_list;
 
-        VkPipelineRasterizationStateCreateInfo rasterization{CE::rasterization_cull_back_bit};
-      rasterization.depthBiasEnable = VK_FALSE;
-      rasterization.depthBiasConstantFactor = 0.0f;
-      rasterization.depthBiasSlopeFactor = 0.0f;
-      rasterization.depthBiasClamp = 0.0f;
+      b.rasterization = CE::rasterization_cull_back_bit;
+      b.rasterization.depthBiasEnable = VK_FALSE;
+      b.rasterization.depthBiasConstantFactor = 0.0f;
+      b.rasterization.depthBiasSlopeFactor = 0.0f;
+      b.rasterization.depthBiasClamp = 0.0f;
 
-        VkPipelineMultisampleStateCreateInfo multisampling{CE::multisample_state_default};
-      multisampling.rasterizationSamples = msaa_samples;
-        VkPipelineDepthStencilStateCreateInfo depthStencil{CE::depth_stencil_state_default};
+      b.multisampling = CE::multisample_state_default;
+      b.multisampling.rasterizationSamples = msaa_samples;
+      b.depth_stencil = CE::depth_stencil_state_default;
 
-      static VkPipelineColorBlendAttachmentState colorBlendAttachment{
-          CE::color_blend_attachment_state_false};
-        VkPipelineColorBlendStateCreateInfo colorBlend{CE::color_blend_state_default};
-      colorBlend.pAttachments = &colorBlendAttachment;
+      b.color_blend_attachment = CE::color_blend_attachment_state_false;
+      b.color_blend = CE::color_blend_state_default;
+      b.color_blend.pAttachments = &b.color_blend_attachment;
 
-        VkPipelineViewportStateCreateInfo viewport{CE::viewport_state_default};
-        VkPipelineDynamicStateCreateInfo dynamic{CE::dynamic_state_default};
-
-      VkGraphicsPipelineCreateInfo pipelineInfo{
-          .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-          .stageCount = static_cast<uint32_t>(shaderStages.size()),
-          .pStages = shaderStages.data(),
-          .pVertexInputState = &vertexInput,
-          .pInputAssemblyState = &inputAssembly,
-          .pViewportState = &viewport,
-          .pRasterizationState = &rasterization,
-          .pMultisampleState = &multisampling,
-          .pDepthStencilState = &depthStencil,
-          .pColorBlendState = &colorBlend,
-          .pDynamicState = &dynamic,
-          .layout = graphics_layout,
-          .renderPass = render_pass,
-          .subpass = 0,
-          .basePipelineHandle = VK_NULL_HANDLE};
+      b.viewport = CE::viewport_state_default;
+      b.dynamic = CE::dynamic_state_default;
 
       if (pipelineName.find("WireFrame") != std::string::npos) {
-        rasterization.polygonMode = VK_POLYGON_MODE_LINE;
-        rasterization.lineWidth = 1.05f;
-        rasterization.depthBiasEnable = VK_FALSE;
-        rasterization.cullMode = VK_CULL_MODE_NONE;
-        depthStencil.depthTestEnable = VK_FALSE;
-        depthStencil.depthWriteEnable = VK_FALSE;
-        depthStencil.depthCompareOp = VK_COMPARE_OP_ALWAYS;
-        colorBlendAttachment = CE::color_blend_attachment_state_average;
+        b.rasterization.polygonMode = VK_POLYGON_MODE_LINE;
+        b.rasterization.lineWidth = 1.05f;
+        b.rasterization.depthBiasEnable = VK_FALSE;
+        b.rasterization.cullMode = VK_CULL_MODE_NONE;
+        b.depth_stencil.depthTestEnable = VK_FALSE;
+        b.depth_stencil.depthWriteEnable = VK_FALSE;
+        b.depth_stencil.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+        b.color_blend_attachment = CE::color_blend_attachment_state_average;
       }
 
       if (pipelineName == "Sky") {
-        rasterization.cullMode = VK_CULL_MODE_NONE;
-        rasterization.depthBiasEnable = VK_FALSE;
-        depthStencil.depthTestEnable = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_FALSE;
-        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-        colorBlendAttachment = CE::color_blend_attachment_state_false;
+        b.rasterization.cullMode = VK_CULL_MODE_NONE;
+        b.rasterization.depthBiasEnable = VK_FALSE;
+        b.depth_stencil.depthTestEnable = VK_TRUE;
+        b.depth_stencil.depthWriteEnable = VK_FALSE;
+        b.depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        b.color_blend_attachment = CE::color_blend_attachment_state_false;
       }
 
       if (pipelineName == "TerrainBox") {
-        rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterization.depthBiasEnable = VK_TRUE;
-        rasterization.depthBiasConstantFactor = 1.0f;
-        rasterization.depthBiasSlopeFactor = 1.0f;
-        rasterization.depthBiasClamp = 0.0f;
-        depthStencil.depthTestEnable = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_TRUE;
-        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-        colorBlendAttachment = CE::color_blend_attachment_state_false;
+        b.rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
+        b.rasterization.depthBiasEnable = VK_TRUE;
+        b.rasterization.depthBiasConstantFactor = 1.0f;
+        b.rasterization.depthBiasSlopeFactor = 1.0f;
+        b.rasterization.depthBiasClamp = 0.0f;
+        b.depth_stencil.depthTestEnable = VK_TRUE;
+        b.depth_stencil.depthWriteEnable = VK_TRUE;
+        b.depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+        b.color_blend_attachment = CE::color_blend_attachment_state_false;
       }
 
       if (pipelineName == "CellsFollower") {
-        rasterization.depthBiasEnable = VK_FALSE;
-        rasterization.depthBiasConstantFactor = 0.0f;
-        rasterization.depthBiasSlopeFactor = 0.0f;
-        rasterization.depthBiasClamp = 0.0f;
-        depthStencil.depthTestEnable = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_TRUE;
-        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+        b.rasterization.depthBiasEnable = VK_FALSE;
+        b.rasterization.depthBiasConstantFactor = 0.0f;
+        b.rasterization.depthBiasSlopeFactor = 0.0f;
+        b.rasterization.depthBiasClamp = 0.0f;
+        b.depth_stencil.depthTestEnable = VK_TRUE;
+        b.depth_stencil.depthWriteEnable = VK_TRUE;
+        b.depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
       }
 
-      VkPipelineTessellationStateCreateInfo tessellationStateInfo{
-          CE::tessellation_state_default};
+      b.graphics_info = VkGraphicsPipelineCreateInfo{
+          .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+          .pNext = &b.feedback_info,
+          .stageCount = static_cast<uint32_t>(b.shader_stages.size()),
+          .pStages = b.shader_stages.data(),
+          .pVertexInputState = &b.vertex_input,
+          .pInputAssemblyState = &b.input_assembly,
+          .pViewportState = &b.viewport,
+          .pRasterizationState = &b.rasterization,
+          .pMultisampleState = &b.multisampling,
+          .pDepthStencilState = &b.depth_stencil,
+          .pColorBlendState = &b.color_blend,
+          .pDynamicState = &b.dynamic,
+          .layout = graphics_layout,
+          .renderPass = render_pass,
+          .subpass = 0,
+          .basePipelineHandle = VK_NULL_HANDLE};
+
+      b.tessellation = CE::tessellation_state_default;
       if (tesselationEnabled) {
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+        b.input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
         if (pipelineName.find("WireFrame") == std::string::npos) {
-          rasterization.polygonMode = VK_POLYGON_MODE_LINE;
-          rasterization.lineWidth = 1.0f;
-          colorBlendAttachment = CE::color_blend_attachment_state_multiply;
+          b.rasterization.polygonMode = VK_POLYGON_MODE_LINE;
+          b.rasterization.lineWidth = 1.0f;
+          b.color_blend_attachment = CE::color_blend_attachment_state_multiply;
         }
-        pipelineInfo.pTessellationState = &tessellationStateInfo;
+        b.graphics_info.pTessellationState = &b.tessellation;
       }
-
-      CE::vulkan_result(vkCreateGraphicsPipelines,
-            BaseDevice::base_device->logical_device,
-            VK_NULL_HANDLE,
-            1,
-            &pipelineInfo,
-            nullptr,
-            &get_pipeline_object_by_name(pipelineName));
-      destroy_shader_modules();
-    } else if (isCompute) {
+    } else {
       Log::text("{ === }", "Compute  Pipeline: ", pipelineName);
 
         const std::array<uint32_t, 3> &workGroups =
@@ -349,38 +540,120 @@ void CE::BasePipelinesConfiguration::create_pipelines(VkRenderPass &render_pass,
       const std::string shaderModuleName =
           (shaderToken == "Comp") ? (pipelineName + shaderToken) : shaderToken;
 
-      VkPipelineShaderStageCreateInfo shaderStage{create_shader_modules(
-          VK_SHADER_STAGE_COMPUTE_BIT, shaderModuleName + ".spv")};
-
-      VkComputePipelineCreateInfo pipelineInfo{
+      b.compute_info = VkComputePipelineCreateInfo{
           .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-          .stage = shaderStage,
+          .pNext = &b.feedback_info,
+          .stage = create_shader_modules(VK_SHADER_STAGE_COMPUTE_BIT, shaderModuleName + ".spv"),
           .layout = compute_layout};
+    }
+
+    builds.push_back(std::move(build));
+  }
 
-      CE::vulkan_result(vkCreateComputePipelines,
-            BaseDevice::base_device->logical_device,
-            VK_NULL_HANDLE,
-            1,
-            &pipelineInfo,
-            nullptr,
-            &get_pipeline_object_by_name(pipelineName));
-      destroy_shader_modules();
+  // vkCreate*Pipelines may run concurrently on one device, and the pipeline cache is
+  // internally synchronized, so each worker just claims the next unbuilt pipeline.
+  const VkDevice device = BaseDevice::base_device->logical_device;
+  const VkPipelineCache cache = this->pipeline_cache.cache;
+  std::atomic<size_t> nextBuild{0};
+  std::mutex errorMutex{};
+  std::exception_ptr firstError{};
+
+  const auto buildWorker = [&]() {
+    for (size_t i = nextBuild.fetch_add(1); i < builds.size(); i = nextBuild.fetch_add(1)) {
+      PipelineBuild &b = *builds[i];
+      const auto pipelineStart = std::chrono::steady_clock::now();
+      try {
+        if (b.is_compute) {
+          CE::vulkan_result(vkCreateComputePipelines, device, cache, 1, &b.compute_info, nullptr, b.target);
+        } else {
+          CE::vulkan_result(vkCreateGraphicsPipelines, device, cache, 1, &b.graphics_info, nullptr, b.target);
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!firstError) {
+          firstError = std::current_exception();
+        }
+      }
+      const auto pipelineEnd = std::chrono::steady_clock::now();
+      b.ms = std::chrono::duration<double, std::milli>(pipelineEnd - pipelineStart).count();
+      Trace::complete(b.name, pipelineStart, pipelineEnd);
     }
+  };
+
+  const uint32_t workerCount = static_cast<uint32_t>(std::clamp<size_t>(
+      std::max(std::thread::hardware_concurrency(), 1u), 1, builds.size()));
+  std::vector<std::thread> workers{};
+  workers.reserve(workerCount - 1);
+  for (uint32_t i = 1; i < workerCount; ++i) {
+    workers.emplace_back(buildWorker);
+  }
+  buildWorker();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
 
-    const auto pipelineEnd = std::chrono::high_resolution_clock::now();
-    const double pipelineMs =
-        std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
-            pipelineEnd - pipelineStart)
-            .count();
-    Log::text("{ PERF }", "Pipeline create", pipelineName, pipelineMs, "ms");
+  // Modules are shared between pipelines that reuse SPIR-V, so they outlive the whole batch.
+  const size_t moduleCount = this->shader_modules.size();
+  destroy_shader_modules();
+  if (firstError) {
+    std::rethrow_exception(firstError);
   }
 
-  const auto pipelinesEnd = std::chrono::high_resolution_clock::now();
+  uint32_t cacheHits = 0;
+  uint32_t cacheMisses = 0;
+  double cacheHitMs = 0.0;
+  double cacheMissMs = 0.0;
+  for (const std::unique_ptr<PipelineBuild> &build : builds) {
+    const bool feedbackValid =
+        (build->feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0;
+    const bool cacheHit =
+        (build->feedback.flags &
+         VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+    if (cacheHit) {
+      ++cacheHits;
+      cacheHitMs += build->ms;
+    } else {
+      ++cacheMisses;
+      cacheMissMs += build->ms;
+    }
+    Log::text("{ PERF }",
+              "Pipeline create",
+              build->name,
+              build->ms,
+              "ms",
+              !feedbackValid ? "cache ?" : cacheHit ? "cache hit" : "cache miss");
+  }
+
+  const auto pipelinesEnd = std::chrono::steady_clock::now();
+  Trace::complete("create pipelines", pipelinesStart, pipelinesEnd);
   const double totalMs =
       std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
           pipelinesEnd - pipelinesStart)
           .count();
-  Log::text("{ PERF }", "All pipelines created in", totalMs, "ms");
+  Log::text("{ PERF }",
+            "All pipelines created in",
+            totalMs,
+            "ms",
+            "threads",
+            workerCount,
+            "shader modules",
+            moduleCount);
+  Log::text("{ PERF }",
+            "Pipeline cache hits",
+            cacheHits,
+            "in",
+            cacheHitMs,
+            "ms",
+            "misses",
+            cacheMisses,
+            "in",
+            cacheMissMs,
+            "ms");
+
+  // Only worth rewriting when something was compiled fresh.
+  if (cacheMisses > 0) {
+    this->pipeline_cache.save();
+  }
 }
 
 bool CE::BasePipelinesConfiguration::set_shader_stages(
@@ -443,12 +716,23 @@ CE::BasePipelinesConfiguration::read_shader_file(const std::string &filename) {
 VkPipelineShaderStageCreateInfo
 CE::BasePipelinesConfiguration::create_shader_modules(VkShaderStageFlagBits shaderStage,
                                                   std::string shaderName) {
-  Log::text(Log::Style::char_leader, "Shader Module", shaderName);
-
   std::string shaderPath = resolve_shader_spv_path(this->shader_dir, shaderName);
-  auto shaderCode = read_shader_file(shaderPath);
   VkShaderModule shaderModule{VK_NULL_HANDLE};
 
+  // Several pipelines share SPIR-V (LandscapeVert alone feeds five); create each once.
+  const auto existing = this->shader_modules.find(shaderPath);
+  if (existing != this->shader_modules.end()) {
+    Log::text(Log::Style::char_leader, "Shader Module", shaderName, "(shared)");
+    return VkPipelineShaderStageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = shaderStage,
+        .module = existing->second,
+        .pName = "main"};
+  }
+
+  Log::text(Log::Style::char_leader, "Shader Module", shaderName);
+  auto shaderCode = read_shader_file(shaderPath);
+
   VkShaderModuleCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
       .codeSize = shaderCode.size(),
@@ -460,7 +744,7 @@ CE::BasePipelinesConfiguration::create_shader_modules(VkShaderStageFlagBits shad
                     nullptr,
                     &shaderModule);
 
-  shader_modules.push_back(shaderModule);
+  this->shader_modules.emplace(shaderPath, shaderModule);
 
   VkPipelineShaderStageCreateInfo shaderStageInfo{
       .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -473,7 +757,6 @@ CE::BasePipelinesConfiguration::create_shader_modules(VkShaderStageFlagBits shad
 
 void CE::BasePipelinesConfiguration::compile_shaders() {
   Log::text("{ GLSL }", "Compile Shaders");
-  std::string systemCommand{};
   std::string pipelineName{};
 
   const std::unordered_map<std::string, std::string> stage_tokens{{"Comp", "comp"},
@@ -498,6 +781,8 @@ void CE::BasePipelinesConfiguration::compile_shaders() {
     return {"", ""};
   };
 
+  // Several pipelines share a stage source (e.g. Cells.vert); compile each one once.
+  std::vector<CE::ShaderCompiler::Job> jobs{};
   for (const auto &[name, variant] : this->pipeline_map) {
     pipelineName = name;
     std::vector<std::string> shaders = get_pipeline_shaders_by_name(pipelineName);
@@ -507,25 +792,22 @@ void CE::BasePipelinesConfiguration::compile_shaders() {
         continue;
       }
 
-      std::string shaderSourcePath = this->shader_dir + source_base + "." + extension;
-      std::string shaderOutputPath = shaderSourcePath + ".spv";
-      bool shouldCompile = true;
-      if (std::filesystem::exists(shaderOutputPath)) {
-        const auto sourceWriteTime = std::filesystem::last_write_time(shaderSourcePath);
-        const auto outputWriteTime = std::filesystem::last_write_time(shaderOutputPath);
-        shouldCompile = sourceWriteTime > outputWriteTime;
-      }
-
-      if (!shouldCompile) {
-        continue;
-      }
-      systemCommand = Lib::path(shaderSourcePath + " -o " + shaderOutputPath);
-      int ret = system(systemCommand.c_str());
-      if (ret != 0) {
-        Log::text("{ !!! }", "shader compilation failed:", shaderSourcePath, "exit code", ret);
+      const std::string shaderSourcePath = this->shader_dir + source_base + "." + extension;
+      const bool queued = std::any_of(jobs.begin(), jobs.end(), [&](const auto &job) {
+        return job.source == shaderSourcePath;
+      });
+      if (!queued) {
+        jobs.push_back({.source = shaderSourcePath, .output = shaderSourcePath + ".spv"});
       }
     }
   }
+
+  CE::ShaderCompiler::Options options{.include_dir = this->shader_dir,
+                                      .cache_dir = this->shader_dir + ".spv_cache"};
+  if (CE::Runtime::env_flag_enabled("CE_DEBUG_ENABLE_CELL_INSTANCE_VERTEX_SANITIZATION_GUARDS")) {
+    options.defines.push_back("CE_DEBUG_ENABLE_CELL_INSTANCE_VERTEX_SANITIZATION_GUARDS=1");
+  }
+  CE::ShaderCompiler::compile_all(jobs, options);
 }
 
 VkPipeline &CE::BasePipelinesConfiguration::get_pipeline_object_by_name(
@@ -539,12 +821,10 @@ VkPipeline &CE::BasePipelinesConfiguration::get_pipeline_object_by_name(
 }
 
 void CE::BasePipelinesConfiguration::destroy_shader_modules() {
-  for (uint_fast8_t i = 0; i < this->shader_modules.size(); i++) {
-    vkDestroyShaderModule(BaseDevice::base_device->logical_device,
-                          this->shader_modules[i],
-                nullptr);
+  for (const auto &[path, shaderModule] : this->shader_modules) {
+    vkDestroyShaderModule(BaseDevice::base_device->logical_device, shaderModule, nullptr);
   }
-  this->shader_modules.resize(0);
+  this->shader_modules.clear();
 }
 
 const std::vector<std::string> &
@@ -55,12 +55,33 @@ public:
   BaseRenderPass(BaseRenderPass &&) = delete;
   BaseRenderPass &operator=(BaseRenderPass &&) = delete;
   virtual ~BaseRenderPass();
-  void create(VkSampleCountFlagBits msaa_image_samples, VkFormat swapchain_image_format);
+  void create(VkSampleCountFlagBits msaa_image_samples,
+              VkFormat swapchain_image_format,
+              VkImageLayout final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
   void create_framebuffers(CE::BaseSwapchain &swapchain,
                            const VkImageView &msaa_view,
                            const VkImageView &depth_view) const;
 };
 
+class BasePipelineCache {
+public:
+  VkPipelineCache cache{VK_NULL_HANDLE};
+
+  BasePipelineCache() = default;
+  BasePipelineCache(const BasePipelineCache &) = delete;
+  BasePipelineCache &operator=(const BasePipelineCache &) = delete;
+  BasePipelineCache(BasePipelineCache &&) = delete;
+  BasePipelineCache &operator=(BasePipelineCache &&) = delete;
+  virtual ~BasePipelineCache();
+  // Seeds the cache from disk when the stored blob was written by this device and driver.
+  void create();
+  void save() const;
+
+private:
+  std::string path_{};
+  std::vector<char> load(const VkPhysicalDeviceProperties &properties) const;
+};
+
 class BasePipelinesConfiguration {
 public:
   struct Graphics {
@@ -93,7 +114,9 @@ protected:
   void compile_shaders();
 
 private:
-  std::vector<VkShaderModule> shader_modules{};
+  BasePipelineCache pipeline_cache{};
+  // Keyed by resolved SPIR-V path; alive for one create_pipelines batch.
+  std::unordered_map<std::string, VkShaderModule> shader_modules{};
   const std::string shader_dir = "shaders/";
   const std::vector<std::string> &get_pipeline_shaders_by_name(const std::string &name);
   bool set_shader_stages(const std::string &pipeline_name,
@@ -0,0 +1,298 @@
+#include "VulkanBaseProfiler.h"
+#include "VulkanBaseUtils.h"
+
+#include "engine/Log.h"
+#include "engine/Trace.h"
+#include "world/RuntimeConfig.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+constexpr std::array<const char *, 2> queue_names{"compute", "graphics"};
+// Whole-submission span (first begin to last end) of each queue, next to the nodes.
+constexpr const char *total_node = "(total)";
+
+size_t index_of(const CE::BaseGpuProfiler::Queue queue) {
+  return static_cast<size_t>(queue);
+}
+
+double percentile(const std::vector<float> &sorted, const double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  const size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+void CE::BaseGpuProfiler::Series::push(const float ms) {
+  samples_ms[next] = ms;
+  next = (next + 1) % samples_ms.size();
+  count = std::min(count + 1, samples_ms.size());
+}
+
+void CE::BaseGpuProfiler::create(const BaseQueues::FamilyIndices &families) {
+  this->report_ = CE::Runtime::env_flag_enabled(CE::Runtime::kEnvGpuProfile);
+  if (!this->report_ && !Trace::enabled()) {
+    return;
+  }
+  BaseDevice &device = *BaseDevice::base_device;
+
+  uint32_t family_count{0};
+  vkGetPhysicalDeviceQueueFamilyProperties(device.physical_device, &family_count, nullptr);
+  std::vector<VkQueueFamilyProperties> family_properties(family_count);
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      device.physical_device, &family_count, family_properties.data());
+
+  const std::array<uint32_t, 2> family_of_queue{families.compute_family.value(),
+                                                families.graphics_and_compute_family.value()};
+  for (size_t queue = 0; queue < family_of_queue.size(); ++queue) {
+    const uint32_t bits = family_properties[family_of_queue[queue]].timestampValidBits;
+    this->valid_mask_[queue] = bits >= 64 ? ~uint64_t{0} : ((uint64_t{1} << bits) - 1);
+    if (bits == 0) {
+      Log::text("{ !!! }", "GPU profiler:", queue_names[queue], "queue has no timestamps");
+    }
+  }
+  if (this->valid_mask_[0] == 0 && this->valid_mask_[1] == 0) {
+    return;
+  }
+
+  this->timestamp_period_ns_ = device.properties().limits.timestampPeriod;
+  VkQueryPoolCreateInfo poolInfo{.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                 .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                 .queryCount = max_scopes * 2};
+  for (size_t queue = 0; queue < this->slots_.size(); ++queue) {
+    if (this->valid_mask_[queue] == 0) {
+      continue;
+    }
+    for (SlotQueries &slot : this->slots_[queue]) {
+      CE::vulkan_result(
+          vkCreateQueryPool, device.logical_device, &poolInfo, nullptr, &slot.pool);
+      vkResetQueryPool(device.logical_device, slot.pool, 0, poolInfo.queryCount);
+      slot.nodes.reserve(max_scopes);
+    }
+  }
+
+  const char *export_path = std::getenv(CE::Runtime::kEnvGpuProfileFile);
+  this->export_path_ = export_path ? export_path : "";
+  this->enabled_ = true;
+  Log::text("{ PROF }",
+            "GPU profiler",
+            "timestampPeriod",
+            this->timestamp_period_ns_,
+            "ns",
+            "scopes per frame",
+            max_scopes,
+            "export",
+            this->export_path_.empty() ? "off" : this->export_path_,
+            "trace",
+            Trace::enabled() ? "on" : "off");
+}
+
+void CE::BaseGpuProfiler::destroy() {
+  if (!BaseDevice::base_device || BaseDevice::base_device->logical_device == VK_NULL_HANDLE) {
+    return;
+  }
+  for (auto &queue_slots : this->slots_) {
+    for (SlotQueries &slot : queue_slots) {
+      if (slot.pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(BaseDevice::base_device->logical_device, slot.pool, nullptr);
+        slot.pool = VK_NULL_HANDLE;
+      }
+    }
+  }
+  this->enabled_ = false;
+}
+
+void CE::BaseGpuProfiler::begin_frame(const Queue queue, const uint32_t slot) {
+  if (!this->enabled_ || this->valid_mask_[index_of(queue)] == 0) {
+    return;
+  }
+  SlotQueries &queries = this->slots_[index_of(queue)][slot];
+  const uint32_t query_count = static_cast<uint32_t>(queries.nodes.size()) * 2;
+
+  if (query_count > 0) {
+    // The caller waited for this slot's submission, so WAIT never blocks here.
+    std::vector<uint64_t> ticks(query_count);
+    CE::vulkan_result(vkGetQueryPoolResults,
+                      BaseDevice::base_device->logical_device,
+                      queries.pool,
+                      0,
+                      query_count,
+                      ticks.size() * sizeof(uint64_t),
+                      ticks.data(),
+                      sizeof(uint64_t),
+                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    vkResetQueryPool(BaseDevice::base_device->logical_device, queries.pool, 0, query_count);
+    if (Trace::enabled()) {
+      trace(queue, queries, ticks);
+    }
+
+    const uint64_t mask = this->valid_mask_[index_of(queue)];
+    const double ms_per_tick = static_cast<double>(this->timestamp_period_ns_) * 1e-6;
+
+    // A node dispatched several times per frame (one per simulation step) is summed.
+    std::unordered_map<std::string, double> frame_ms{};
+    uint64_t first = ticks[0];
+    uint64_t last = ticks[1];
+    for (size_t scope = 0; scope < queries.nodes.size(); ++scope) {
+      const uint64_t begin = ticks[scope * 2];
+      const uint64_t end = ticks[scope * 2 + 1];
+      frame_ms[queries.nodes[scope]] += static_cast<double>((end - begin) & mask) * ms_per_tick;
+      first = std::min(first, begin);
+      last = std::max(last, end);
+    }
+    frame_ms[total_node] = static_cast<double>((last - first) & mask) * ms_per_tick;
+
+    auto &series = this->series_[index_of(queue)];
+    for (const auto &[node, ms] : frame_ms) {
+      series[node].push(static_cast<float>(ms));
+    }
+  }
+  queries.nodes.clear();
+  queries.overflowed = false;
+
+  if (queue == Queue::Graphics && ++this->frames_ % report_interval == 0 && this->report_) {
+    report();
+  }
+}
+
+uint32_t CE::BaseGpuProfiler::begin(VkCommandBuffer command_buffer,
+                                    const Queue queue,
+                                    const uint32_t slot,
+                                    const std::string &node) {
+  if (!this->enabled_ || this->valid_mask_[index_of(queue)] == 0) {
+    return no_scope;
+  }
+  SlotQueries &queries = this->slots_[index_of(queue)][slot];
+  if (queries.nodes.size() >= max_scopes) {
+    if (!queries.overflowed) {
+      queries.overflowed = true;
+      Log::text("{ !!! }", "GPU profiler:", queue_names[index_of(queue)], "scopes full", node);
+    }
+    return no_scope;
+  }
+
+  const uint32_t scope = static_cast<uint32_t>(queries.nodes.size());
+  queries.nodes.push_back(node);
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queries.pool, scope * 2);
+  return scope;
+}
+
+void CE::BaseGpuProfiler::end(VkCommandBuffer command_buffer,
+                              const Queue queue,
+                              const uint32_t slot,
+                              const uint32_t scope) {
+  if (scope == no_scope) {
+    return;
+  }
+  vkCmdWriteTimestamp(command_buffer,
+                      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      this->slots_[index_of(queue)][slot].pool,
+                      scope * 2 + 1);
+}
+
+void CE::BaseGpuProfiler::submitted(const Queue queue, const uint32_t slot) {
+  if (this->enabled_) {
+    this->slots_[index_of(queue)][slot].submit_us = Trace::now_us();
+  }
+}
+
+void CE::BaseGpuProfiler::trace(const Queue queue,
+                                const SlotQueries &queries,
+                                const std::vector<uint64_t> &ticks) {
+  // Without calibrated timestamps the GPU clock is placed on the trace clock by bounds:
+  // work starts no earlier than its submit and ends before the host saw it complete.
+  const double us_per_tick = static_cast<double>(this->timestamp_period_ns_) * 1e-3;
+  const auto [first, last] = std::minmax_element(ticks.begin(), ticks.end());
+  const double first_us = static_cast<double>(*first) * us_per_tick;
+  const double last_us = static_cast<double>(*last) * us_per_tick;
+
+  double &offset_us = this->trace_offset_us_[index_of(queue)];
+  offset_us = std::max(offset_us, queries.submit_us - first_us);
+  const double frame_offset_us = std::min(offset_us, Trace::now_us() - last_us);
+
+  const Trace::Track track =
+      queue == Queue::Compute ? Trace::Track::GpuCompute : Trace::Track::GpuGraphics;
+  for (size_t scope = 0; scope < queries.nodes.size(); ++scope) {
+    const double begin_us = static_cast<double>(ticks[scope * 2]) * us_per_tick;
+    const double end_us = static_cast<double>(ticks[scope * 2 + 1]) * us_per_tick;
+    Trace::complete(queries.nodes[scope], begin_us + frame_offset_us, end_us - begin_us, track);
+  }
+}
+
+std::vector<CE::BaseGpuProfiler::NodeSummary> CE::BaseGpuProfiler::summarize() const {
+  std::vector<NodeSummary> summary{};
+  std::vector<float> sorted{};
+  for (size_t queue = 0; queue < this->series_.size(); ++queue) {
+    for (const auto &[node, series] : this->series_[queue]) {
+      if (series.count == 0) {
+        continue;
+      }
+      sorted.assign(series.samples_ms.begin(), series.samples_ms.begin() + series.count);
+      std::sort(sorted.begin(), sorted.end());
+
+      double sum = 0.0;
+      for (const float ms : sorted) {
+        sum += ms;
+      }
+      summary.push_back(NodeSummary{.queue = static_cast<Queue>(queue),
+                                    .node = node,
+                                    .samples = sorted.size(),
+                                    .avg_ms = sum / static_cast<double>(sorted.size()),
+                                    .p50_ms = percentile(sorted, 0.50),
+                                    .p95_ms = percentile(sorted, 0.95),
+                                    .p99_ms = percentile(sorted, 0.99),
+                                    .max_ms = sorted.back()});
+    }
+  }
+  // Most expensive first within each queue.
+  std::sort(summary.begin(), summary.end(), [](const NodeSummary &a, const NodeSummary &b) {
+    return a.queue != b.queue ? a.queue < b.queue : a.avg_ms > b.avg_ms;
+  });
+  return summary;
+}
+
+void CE::BaseGpuProfiler::report() const {
+  const std::vector<NodeSummary> summary = summarize();
+  for (const NodeSummary &node : summary) {
+    Log::text("{ PROF }",
+              "gpu",
+              queue_names[index_of(node.queue)],
+              node.node,
+              "avg_ms",
+              node.avg_ms,
+              "p50_ms",
+              node.p50_ms,
+              "p95_ms",
+              node.p95_ms,
+              "p99_ms",
+              node.p99_ms,
+              "max_ms",
+              node.max_ms,
+              "frames",
+              node.samples);
+  }
+  if (!this->export_path_.empty()) {
+    export_file(summary);
+  }
+}
+
+void CE::BaseGpuProfiler::export_file(const std::vector<NodeSummary> &summary) const {
+  // Rewritten on every report, so the file holds the latest window even after a crash.
+  std::ofstream file(this->export_path_, std::ios::trunc);
+  if (!file) {
+    Log::text("{ !!! }", "GPU profiler: cannot write", this->export_path_);
+    return;
+  }
+  file << "queue,node,frames,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+  for (const NodeSummary &node : summary) {
+    file << queue_names[index_of(node.queue)] << ',' << node.node << ',' << node.samples << ','
+         << node.avg_ms << ',' << node.p50_ms << ',' << node.p95_ms << ',' << node.p99_ms << ','
+         << node.max_ms << '\n';
+  }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// GPU timestamp profiler: per-node durations from query pools, one pool per queue and frame slot.
+// Exists so frame cost can be attributed to pipelines instead of to CPU-side submit wall time.
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanBaseDescriptor.h"
+#include "VulkanBaseDevice.h"
+
+namespace CE {
+
+class BaseGpuProfiler {
+public:
+  enum class Queue : uint8_t { Compute = 0, Graphics = 1 };
+  static constexpr uint32_t no_scope = UINT32_MAX;
+
+  struct NodeSummary {
+    Queue queue{Queue::Compute};
+    std::string node{};
+    size_t samples{0};
+    double avg_ms{0.0};
+    double p50_ms{0.0};
+    double p95_ms{0.0};
+    double p99_ms{0.0};
+    double max_ms{0.0};
+  };
+
+  BaseGpuProfiler() = default;
+  BaseGpuProfiler(const BaseGpuProfiler &) = delete;
+  BaseGpuProfiler &operator=(const BaseGpuProfiler &) = delete;
+  BaseGpuProfiler(BaseGpuProfiler &&) = delete;
+  BaseGpuProfiler &operator=(BaseGpuProfiler &&) = delete;
+  virtual ~BaseGpuProfiler() {
+    destroy();
+  }
+
+  // No-op unless CE_GPU_PROFILE or CE_TRACE_FILE is set and the queue families support
+  // timestamps.
+  void create(const BaseQueues::FamilyIndices &families);
+  void destroy();
+  bool enabled() const {
+    return enabled_;
+  }
+
+  // Call once the slot's previous submission on queue has completed, before recording it
+  // again: folds its timestamps into the rolling statistics and resets the pool.
+  void begin_frame(const Queue queue, const uint32_t slot);
+  // Brackets GPU work recorded between the two calls; end() ignores no_scope.
+  uint32_t begin(VkCommandBuffer command_buffer,
+                 const Queue queue,
+                 const uint32_t slot,
+                 const std::string &node);
+  void end(VkCommandBuffer command_buffer,
+           const Queue queue,
+           const uint32_t slot,
+           const uint32_t scope);
+  // CPU time the slot's command buffer was submitted; anchors its ranges on the trace clock.
+  void submitted(const Queue queue, const uint32_t slot);
+
+  std::vector<NodeSummary> summarize() const;
+
+private:
+  // Scopes per queue and frame slot; two queries each.
+  static constexpr uint32_t max_scopes = 256;
+  // Frames of history behind the averages and percentiles.
+  static constexpr size_t window = 240;
+  static constexpr uint64_t report_interval = 120;
+
+  struct SlotQueries {
+    VkQueryPool pool{VK_NULL_HANDLE};
+    std::vector<std::string> nodes{};
+    bool overflowed{false};
+    double submit_us{0.0};
+  };
+  // Per-frame durations of one node, in a fixed ring.
+  struct Series {
+    std::array<float, window> samples_ms{};
+    size_t next{0};
+    size_t count{0};
+    void push(const float ms);
+  };
+
+  bool enabled_{false};
+  bool report_{false};
+  float timestamp_period_ns_{1.0f};
+  std::array<uint64_t, 2> valid_mask_{};
+  std::array<std::array<SlotQueries, MAX_FRAME_LATENCY>, 2> slots_{};
+  std::array<std::unordered_map<std::string, Series>, 2> series_{};
+  uint64_t frames_{0};
+  std::string export_path_{};
+  // Trace clock minus GPU clock, in microseconds, per queue: the largest lower bound seen
+  // so far, since no work starts before it was submitted.
+  std::array<double, 2> trace_offset_us_{-1e300, -1e300};
+
+  void trace(const Queue queue, const SlotQueries &queries, const std::vector<uint64_t> &ticks);
+  void report() const;
+  void export_file(const std::vector<NodeSummary> &summary) const;
+};
+
+} // namespace CE
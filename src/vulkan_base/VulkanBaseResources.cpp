@@ -3,6 +3,7 @@
 
 #include "VulkanBaseResources.h"
 #include "VulkanBaseSync.h"
+#include "VulkanBaseUpload.h"
 #include "VulkanBaseUtils.h"
 
 #include "engine/Log.h"
@@ -13,26 +14,33 @@
 
 uint32_t CE::find_memory_type(const uint32_t type_filter,
                               const VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties mem_properties{};
-  vkGetPhysicalDeviceMemoryProperties(BaseDevice::base_device->physical_device,
-                                      &mem_properties);
-
-  Log::text("{ MEM }",
-            Log::function_name(__func__),
-            "Find Memory Type",
-            "typeFilter",
-            type_filter);
-  Log::text(Log::Style::char_leader, Log::get_memory_property_string(properties));
+  const VkPhysicalDeviceMemoryProperties &mem_properties =
+      BaseDevice::base_device->memory_properties();
+
+  // Same answer every time for a given pair, so only the first lookup is logged.
+  static std::unordered_set<uint64_t> logged_lookups{};
+  const bool should_log =
+      logged_lookups.insert((static_cast<uint64_t>(type_filter) << 32) | properties).second;
+  if (should_log) {
+    Log::text("{ MEM }",
+              Log::function_name(__func__),
+              "Find Memory Type",
+              "typeFilter",
+              type_filter);
+    Log::text(Log::Style::char_leader, Log::get_memory_property_string(properties));
+  }
 
   for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
     if ((type_filter & (1 << i)) &&
         (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-      Log::text(Log::Style::char_leader,
-                Log::function_name(__func__),
-                "MemoryType index",
-                i,
-                "heap",
-                mem_properties.memoryTypes[i].heapIndex);
+      if (should_log) {
+        Log::text(Log::Style::char_leader,
+                  Log::function_name(__func__),
+                  "MemoryType index",
+                  i,
+                  "heap",
+                  mem_properties.memoryTypes[i].heapIndex);
+      }
       return i;
     }
   }
@@ -45,17 +53,30 @@ CE::BaseBuffer::~BaseBuffer() {
       vkDestroyBuffer(BaseDevice::base_device->logical_device, this->buffer, nullptr);
       this->buffer = VK_NULL_HANDLE;
     }
-    if (this->memory != VK_NULL_HANDLE) {
-      vkFreeMemory(BaseDevice::base_device->logical_device, this->memory, nullptr);
-      this->memory = VK_NULL_HANDLE;
+    if (this->mapped) {
+      unmap();
     }
+    BaseDevice::base_device->allocator().free(this->allocation);
+  }
+}
+
+void *CE::BaseBuffer::map() {
+  if (!this->mapped) {
+    this->mapped = BaseDevice::base_device->allocator().map(this->allocation);
   }
+  return this->mapped;
+}
+
+void CE::BaseBuffer::unmap() {
+  BaseDevice::base_device->allocator().unmap(this->allocation);
+  this->mapped = nullptr;
 }
 
 void CE::BaseBuffer::create(const VkDeviceSize &size,
                         const VkBufferUsageFlags &usage,
                         const VkMemoryPropertyFlags &properties,
-                        BaseBuffer &buffer) {
+                        BaseBuffer &buffer,
+                        const std::vector<uint32_t> &shared_families) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.pNext = nullptr;
@@ -65,6 +86,11 @@ void CE::BaseBuffer::create(const VkDeviceSize &size,
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   bufferInfo.queueFamilyIndexCount = 0;
   bufferInfo.pQueueFamilyIndices = nullptr;
+  if (shared_families.size() > 1) {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(shared_families.size());
+    bufferInfo.pQueueFamilyIndices = shared_families.data();
+  }
   Log::text("{ ... }", Log::get_buffer_usage_string(usage));
   Log::text(Log::Style::char_leader, Log::get_memory_property_string(properties));
   Log::text(Log::Style::char_leader, size, "bytes");
@@ -92,112 +118,12 @@ void CE::BaseBuffer::create(const VkDeviceSize &size,
             "typeBits",
             memRequirements.memoryTypeBits);
 
-  const uint32_t memory_type_index =
-      CE::find_memory_type(memRequirements.memoryTypeBits, properties);
-
-  VkMemoryAllocateInfo allocateInfo{};
-  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocateInfo.pNext = nullptr;
-  allocateInfo.allocationSize = memRequirements.size;
-  allocateInfo.memoryTypeIndex = memory_type_index;
-
-  Log::text(Log::Style::char_leader,
-            "alloc",
-            allocateInfo.allocationSize,
-            "bytes",
-            "memoryTypeIndex",
-            allocateInfo.memoryTypeIndex);
-
-  CE::vulkan_result(vkAllocateMemory,
-                    BaseDevice::base_device->logical_device,
-                    &allocateInfo,
-                    nullptr,
-                    &buffer.memory);
-  vkBindBufferMemory(
-      BaseDevice::base_device->logical_device, buffer.buffer, buffer.memory, 0);
-}
-
-void CE::BaseBuffer::copy(const VkBuffer &src_buffer,
-                      VkBuffer &dst_buffer,
-                      const VkDeviceSize size,
-                      VkCommandBuffer & /*command_buffer*/,
-                      const VkCommandPool &command_pool,
-                      const VkQueue &queue) {
-  Log::text("{ ... }", "copying", size, "bytes");
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ XFR }",
-              "BaseBuffer copy",
-              "src",
-              src_buffer,
-              "dst",
-              dst_buffer,
-              "bytes",
-              size,
-              "pool",
-              command_pool,
-              "queue",
-              queue);
-  }
-
-  CE::BaseSingleUseCommands single_use_commands(command_pool, queue);
-  VkCommandBuffer &single_use_command_buffer = single_use_commands.command_buffer();
-  VkBufferCopy copy_region{};
-  copy_region.srcOffset = 0;
-  copy_region.dstOffset = 0;
-  copy_region.size = size;
-  vkCmdCopyBuffer(single_use_command_buffer, src_buffer, dst_buffer, 1, &copy_region);
-  single_use_commands.submit_and_wait();
-}
-
-void CE::BaseBuffer::copy_to_image(const VkBuffer &buffer,
-                               VkImage &image,
-                               const uint32_t width,
-                               const uint32_t height,
-                               VkCommandBuffer & /*command_buffer*/,
-                               const VkCommandPool &command_pool,
-                               const VkQueue &queue) {
-  Log::text("{ img }", "BaseBuffer To BaseImage", width, height);
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ XFR }",
-              "BaseBuffer->BaseImage",
-              "src",
-              buffer,
-              "dst",
-              image,
-              "extent",
-              width,
-              "x",
-              height,
-              "pool",
-              command_pool,
-              "queue",
-              queue);
-  }
-
-  CE::BaseSingleUseCommands single_use_commands(command_pool, queue);
-  VkCommandBuffer &single_use_command_buffer = single_use_commands.command_buffer();
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = {width, height, 1};
-
-  vkCmdCopyBufferToImage(single_use_command_buffer,
-                         buffer,
-                         image,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                         1,
-                         &region);
-  single_use_commands.submit_and_wait();
+  buffer.allocation = BaseDevice::base_device->allocator().allocate_buffer(
+      buffer.buffer, memRequirements, usage, properties);
 }
 
 void CE::BaseImage::destroy_vulkan_images() {
-  if (BaseDevice::base_device && this->memory) {
+  if (BaseDevice::base_device && this->allocation) {
     if (Log::gpu_trace_enabled()) {
       Log::text("{ DST }",
                 "Destroy image resources",
@@ -207,8 +133,8 @@ void CE::BaseImage::destroy_vulkan_images() {
                 this->view,
                 "sampler",
                 this->sampler,
-                "memory",
-                this->memory);
+                "allocation",
+                this->allocation);
     }
     if (this->sampler != VK_NULL_HANDLE) {
       vkDestroySampler(BaseDevice::base_device->logical_device, this->sampler, nullptr);
@@ -222,10 +148,7 @@ void CE::BaseImage::destroy_vulkan_images() {
       vkDestroyImage(BaseDevice::base_device->logical_device, this->image, nullptr);
       this->image = VK_NULL_HANDLE;
     };
-    if (this->memory != VK_NULL_HANDLE) {
-      vkFreeMemory(BaseDevice::base_device->logical_device, this->memory, nullptr);
-      this->memory = VK_NULL_HANDLE;
-    };
+    BaseDevice::base_device->allocator().free(this->allocation);
   };
 }
 
@@ -274,31 +197,8 @@ void CE::BaseImage::create(const uint32_t width,
             "typeBits",
             memRequirements.memoryTypeBits);
 
-  const uint32_t memory_type_index =
-      find_memory_type(memRequirements.memoryTypeBits, properties);
-
-  VkMemoryAllocateInfo allocateInfo{};
-  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocateInfo.pNext = nullptr;
-  allocateInfo.allocationSize = memRequirements.size;
-  allocateInfo.memoryTypeIndex = memory_type_index;
-
-  Log::text(Log::Style::char_leader,
-            "alloc",
-            allocateInfo.allocationSize,
-            "bytes",
-            "memoryTypeIndex",
-            allocateInfo.memoryTypeIndex);
-
-  CE::vulkan_result(vkAllocateMemory,
-                    BaseDevice::base_device->logical_device,
-                    &allocateInfo,
-                    nullptr,
-                    &this->memory);
-  vkBindImageMemory(BaseDevice::base_device->logical_device,
-                    this->image,
-                    this->memory,
-                    0);
+  this->allocation =
+      BaseDevice::base_device->allocator().allocate_image(this->image, properties);
 }
 
 void CE::BaseImage::create_view(const VkImageAspectFlags aspect_flags) {
@@ -411,10 +311,8 @@ void CE::BaseImage::transition_layout(const VkCommandBuffer &command_buffer,
 }
 
 void CE::BaseImage::load_texture(const std::string &image_path,
-                             const VkFormat format,
-                             VkCommandBuffer &command_buffer,
-                             const VkCommandPool &command_pool,
-                             const VkQueue &queue) {
+                                 const VkFormat format,
+                                 BaseUploader &uploader) {
   Log::text("{ img }", "BaseImage Texture: ", image_path);
 
   int texWidth(0), texHeight(0), texChannels(0), rgba(4);
@@ -438,37 +336,6 @@ void CE::BaseImage::load_texture(const std::string &image_path,
                            static_cast<VkDeviceSize>(texHeight) *
                            static_cast<VkDeviceSize>(rgba);
 
-  BaseBuffer stagingResources{};
-
-  BaseBuffer::create(imageSize,
-                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 stagingResources);
-
-  void *data{};
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ MAP }", "Map texture staging memory", stagingResources.memory, imageSize);
-  }
-  vkMapMemory(
-      BaseDevice::base_device->logical_device,
-      stagingResources.memory,
-      0,
-      imageSize,
-      0,
-      &data);
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ WR }", "Write host->staging texture bytes", imageSize);
-  }
-  memcpy(data, pixels, static_cast<size_t>(imageSize));
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ MAP }", "Unmap texture staging memory", stagingResources.memory);
-  }
-  vkUnmapMemory(BaseDevice::base_device->logical_device, stagingResources.memory);
-  if (loaded_pixels) {
-    stbi_image_free(loaded_pixels);
-  }
-
   this->create(texWidth,
                texHeight,
                VK_SAMPLE_COUNT_1_BIT,
@@ -477,30 +344,16 @@ void CE::BaseImage::load_texture(const std::string &image_path,
                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-  {
-    CE::BaseSingleUseCommands single_use_commands(command_pool, queue);
-    this->transition_layout(single_use_commands.command_buffer(),
-                          format,
-                          VK_IMAGE_LAYOUT_UNDEFINED,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    single_use_commands.submit_and_wait();
+  if (Log::gpu_trace_enabled()) {
+    Log::text("{ WR }", "Stage texture bytes", imageSize);
   }
-
-  BaseBuffer::copy_to_image(stagingResources.buffer,
-                        this->image,
+  uploader.upload_image(pixels,
+                        imageSize,
+                        *this,
                         static_cast<uint32_t>(texWidth),
-                        static_cast<uint32_t>(texHeight),
-                        command_buffer,
-                        command_pool,
-                        queue);
-
-  {
-    CE::BaseSingleUseCommands single_use_commands(command_pool, queue);
-    this->transition_layout(single_use_commands.command_buffer(),
-                          format,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    single_use_commands.submit_and_wait();
+                        static_cast<uint32_t>(texHeight));
+  if (loaded_pixels) {
+    stbi_image_free(loaded_pixels);
   }
 }
 
@@ -8,14 +8,19 @@
 
 #include <vulkan/vulkan.h>
 
+#include "vulkan_base/VulkanBaseMemory.h"
+
 namespace CE {
 
+class BaseUploader;
+
 enum IMAGE_RESOURCE_TYPES { CE_DEPTH_IMAGE = 0, CE_MULTISAMPLE_IMAGE = 1 };
 
 class BaseBuffer {
 public:
   VkBuffer buffer{};
-  VkDeviceMemory memory{};
+  // Sub-allocated from BaseDevice::allocator(); the block is shared with other resources.
+  VmaAllocation allocation{};
   void *mapped{};
 
   BaseBuffer() = default;
@@ -24,29 +29,21 @@ public:
   BaseBuffer(BaseBuffer &&) = delete;
   BaseBuffer &operator=(BaseBuffer &&) = delete;
   virtual ~BaseBuffer();
+  // More than one entry in shared_families creates the buffer CONCURRENT across them.
   static void create(const VkDeviceSize &size,
                      const VkBufferUsageFlags &usage,
                      const VkMemoryPropertyFlags &properties,
-                     BaseBuffer &buffer);
-  static void copy(const VkBuffer &src_buffer,
-                   VkBuffer &dst_buffer,
-                   const VkDeviceSize size,
-                   VkCommandBuffer &command_buffer,
-                   const VkCommandPool &command_pool,
-                   const VkQueue &queue);
-  static void copy_to_image(const VkBuffer &buffer,
-                            VkImage &image,
-                            const uint32_t width,
-                            const uint32_t height,
-                            VkCommandBuffer &command_buffer,
-                            const VkCommandPool &command_pool,
-                            const VkQueue &queue);
+                     BaseBuffer &buffer,
+                     const std::vector<uint32_t> &shared_families = {});
+  // Host pointer to this buffer's range (not its whole block); kept until unmap().
+  void *map();
+  void unmap();
 };
 
 class BaseImage {
 public:
   VkImage image{};
-  VkDeviceMemory memory{};
+  VmaAllocation allocation{};
   VkImageView view{};
   VkSampler sampler{};
   VkImageCreateInfo info{.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
@@ -103,11 +100,10 @@ public:
                          const VkFormat format,
                          const VkImageLayout old_layout,
                          const VkImageLayout new_layout);
+  // Creates the image and queues its pixels on uploader; usable once that batch completes.
   void load_texture(const std::string &image_path,
                     const VkFormat format,
-                    VkCommandBuffer &command_buffer,
-                    const VkCommandPool &command_pool,
-                    const VkQueue &queue);
+                    BaseUploader &uploader);
   static VkFormat find_depth_format();
 
 protected:
@@ -2,6 +2,7 @@
 #include "VulkanBaseUtils.h"
 
 #include "engine/Log.h"
+#include "world/RuntimeConfig.h"
 
 #include <algorithm>
 #include <limits>
@@ -9,6 +10,10 @@
 VkCommandBuffer CE::BaseCommandBuffers::singular_command_buffer = VK_NULL_HANDLE;
 
 CE::BaseCommandBuffers::~BaseCommandBuffers() {
+  if (BaseDevice::base_device && this->compute_pool != VK_NULL_HANDLE &&
+      this->compute_pool != this->pool) {
+    vkDestroyCommandPool(BaseDevice::base_device->logical_device, this->compute_pool, nullptr);
+  }
   if (BaseDevice::base_device && this->pool != VK_NULL_HANDLE) {
     vkDestroyCommandPool(BaseDevice::base_device->logical_device, this->pool, nullptr);
   }
@@ -70,6 +75,20 @@ void CE::BaseCommandBuffers::create_pool(const BaseQueues::FamilyIndices &family
   if (result != VK_SUCCESS) {
     throw std::runtime_error("!ERROR! vkCreateCommandPool failed!");
   }
+
+  this->compute_pool = this->pool;
+  if (family_indices.async_compute()) {
+    poolInfo.queueFamilyIndex = family_indices.compute_family.value();
+    CE::vulkan_result(vkCreateCommandPool,
+                      BaseDevice::base_device->logical_device,
+                      &poolInfo,
+                      nullptr,
+                      &this->compute_pool);
+    Log::text("{ cmd }",
+              "Compute Command Pool: queue family",
+              family_indices.compute_family.value(),
+              this->compute_pool);
+  }
 }
 
 void CE::BaseCommandBuffers::begin_singular_commands(const VkCommandPool &command_pool,
@@ -212,8 +231,9 @@ void CE::BaseCommandBuffers::end_singular_commands(const VkCommandPool &command_
 }
 
 void CE::BaseCommandBuffers::create_buffers(
-    std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> &command_buffers) const {
-  Log::text("{ cmd }", "Command Buffers:", MAX_FRAMES_IN_FLIGHT);
+    std::array<VkCommandBuffer, MAX_FRAME_LATENCY> &command_buffers,
+    const VkCommandPool command_pool) const {
+  Log::text("{ cmd }", "Command Buffers:", static_cast<uint32_t>(command_buffers.size()));
   if (!BaseDevice::base_device) {
     Log::text("{ cmd }", "Command Buffers: base_device is null");
   } else {
@@ -223,7 +243,7 @@ void CE::BaseCommandBuffers::create_buffers(
               "@",
               &BaseDevice::base_device->logical_device);
   }
-  Log::text("{ cmd }", "Command Buffers: pool", this->pool, "@", &this->pool);
+  Log::text("{ cmd }", "Command Buffers: pool", command_pool);
   Log::text("{ cmd }",
             "Command Buffers: array",
             command_buffers.data(),
@@ -231,7 +251,7 @@ void CE::BaseCommandBuffers::create_buffers(
             static_cast<uint32_t>(command_buffers.size()));
   VkCommandBufferAllocateInfo allocateInfo{
       .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-      .commandPool = this->pool,
+      .commandPool = command_pool,
       .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
       .commandBufferCount = static_cast<uint32_t>(command_buffers.size())};
 
@@ -383,8 +403,15 @@ void CE::BaseSwapchain::destroy() {
     for (uint_fast8_t i = 0; i < this->images.size(); i++) {
         vkDestroyImageView(
           BaseDevice::base_device->logical_device, this->images[i].view, nullptr);
+      // Offscreen ring images own their memory; release them here as well.
+      this->images[i].view = VK_NULL_HANDLE;
+      this->images[i].recreate();
+    }
+    if (this->swapchain != VK_NULL_HANDLE) {
+      vkDestroySwapchainKHR(
+          BaseDevice::base_device->logical_device, this->swapchain, nullptr);
+      this->swapchain = VK_NULL_HANDLE;
     }
-    vkDestroySwapchainKHR(BaseDevice::base_device->logical_device, this->swapchain, nullptr);
   }
 }
 
@@ -409,10 +436,14 @@ void CE::BaseSwapchain::recreate(const VkSurfaceKHR &surface,
 
   // Keep frame index in a known slot after swapchain reset.
   constexpr uint32_t reset = 1;
-  sync_objects.current_frame = reset;
+  sync_objects.current_frame = std::min(reset, sync_objects.frames_in_flight - 1);
 }
 
 void CE::BaseSwapchain::create(const VkSurfaceKHR &surface, const BaseQueues &queues) {
+  if (surface == VK_NULL_HANDLE) {
+    create_offscreen();
+    return;
+  }
   Log::text("{ <-> }", "Swap Chain");
   const BaseSwapchain::SupportDetails swapchainSupport =
       check_support(BaseDevice::base_device->physical_device, surface);
@@ -520,15 +551,100 @@ void CE::BaseSwapchain::create(const VkSurfaceKHR &surface, const BaseQueues &qu
   };
 }
 
+void CE::BaseSwapchain::create_offscreen() {
+  Log::text("{ <-> }", "Offscreen image ring (headless)");
+
+  const Window &window = Window::get();
+  this->image_format = VK_FORMAT_R8G8B8A8_UNORM;
+  this->extent = {static_cast<uint32_t>(window.display.width),
+                  static_cast<uint32_t>(window.display.height)};
+  this->present_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  for (uint_fast8_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    this->images[i].create(this->extent.width,
+                           this->extent.height,
+                           VK_SAMPLE_COUNT_1_BIT,
+                           this->image_format,
+                           VK_IMAGE_TILING_OPTIMAL,
+                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+                               VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    this->images[i].create_view(VK_IMAGE_ASPECT_COLOR_BIT);
+  }
+
+  Log::text("{ SWP }",
+            Log::function_name(__func__),
+            "Offscreen ring created",
+            "format",
+            static_cast<uint32_t>(this->image_format),
+            "extent",
+            this->extent.width,
+            "x",
+            this->extent.height,
+            "images",
+            MAX_FRAMES_IN_FLIGHT);
+}
+
+void CE::BaseTimeline::create() {
+  VkSemaphoreTypeCreateInfo typeInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                                     .pNext = nullptr,
+                                     .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                                     .initialValue = 0};
+  VkSemaphoreCreateInfo semaphoreInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                                      .pNext = &typeInfo};
+  CE::vulkan_result(vkCreateSemaphore,
+                    BaseDevice::base_device->logical_device,
+                    &semaphoreInfo,
+                    nullptr,
+                    &this->semaphore);
+  this->submitted = 0;
+}
+
+void CE::BaseTimeline::destroy() {
+  if (this->semaphore != VK_NULL_HANDLE) {
+    vkDestroySemaphore(BaseDevice::base_device->logical_device, this->semaphore, nullptr);
+    this->semaphore = VK_NULL_HANDLE;
+  }
+}
+
+uint64_t CE::BaseTimeline::completed() const {
+  uint64_t value{0};
+  CE::vulkan_result(vkGetSemaphoreCounterValue,
+                    BaseDevice::base_device->logical_device,
+                    this->semaphore,
+                    &value);
+  return value;
+}
+
+void CE::BaseTimeline::wait(const uint64_t value) const {
+  if (value == 0) {
+    return;
+  }
+  VkSemaphoreWaitInfo waitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                               .pNext = nullptr,
+                               .flags = 0,
+                               .semaphoreCount = 1,
+                               .pSemaphores = &this->semaphore,
+                               .pValues = &value};
+  CE::vulkan_result(
+      vkWaitSemaphores, BaseDevice::base_device->logical_device, &waitInfo, UINT64_MAX);
+}
+
 void CE::BaseSynchronizationObjects::create() {
   Log::text("{ ||| }", "Sync Objects");
 
+  this->frames_in_flight = std::clamp(
+      CE::Runtime::env_uint(CE::Runtime::kEnvFramesInFlight, MAX_FRAMES_IN_FLIGHT),
+      1u,
+      MAX_FRAME_LATENCY);
+  Log::text(Log::Style::char_leader, "frames in flight", this->frames_in_flight);
+
   VkSemaphoreCreateInfo semaphoreInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
 
-  VkFenceCreateInfo fenceInfo{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                              .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+  this->compute_timeline.create();
+  this->graphics_timeline.create();
 
-  for (uint_fast8_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  for (uint_fast8_t i = 0; i < MAX_FRAME_LATENCY; i++) {
     CE::vulkan_result(vkCreateSemaphore,
               BaseDevice::base_device->logical_device,
               &semaphoreInfo,
@@ -539,32 +655,20 @@ void CE::BaseSynchronizationObjects::create() {
               &semaphoreInfo,
               nullptr,
               &this->render_finished_semaphores[i]);
-    CE::vulkan_result(vkCreateFence,
-              BaseDevice::base_device->logical_device,
-              &fenceInfo,
-              nullptr,
-              &this->graphics_in_flight_fences[i]);
-    CE::vulkan_result(vkCreateSemaphore,
-              BaseDevice::base_device->logical_device,
-              &semaphoreInfo,
-              nullptr,
-              &this->compute_finished_semaphores[i]);
-    CE::vulkan_result(vkCreateFence,
-              BaseDevice::base_device->logical_device,
-              &fenceInfo,
-              nullptr,
-              &this->compute_in_flight_fences[i]);
 
     Log::text(Log::Style::char_leader,
               "frame",
               i,
               "sync handles",
               this->image_available_semaphores[i],
-              this->compute_finished_semaphores[i],
-              this->render_finished_semaphores[i],
-              this->compute_in_flight_fences[i],
-              this->graphics_in_flight_fences[i]);
-  }
+              this->render_finished_semaphores[i]);
+  }
+  Log::text(Log::Style::char_leader,
+            "timelines",
+            "compute",
+            this->compute_timeline.semaphore,
+            "graphics",
+            this->graphics_timeline.semaphore);
 }
 
 void CE::BaseSynchronizationObjects::destroy() {
@@ -573,11 +677,11 @@ void CE::BaseSynchronizationObjects::destroy() {
   }
 
   Log::text("{ ||| }", "Destroy Synchronization Objects");
-  // Semaphores/fences can still be in use by in-flight submissions at shutdown.
-  // Waiting for idle prevents VUID errors during vkDestroySemaphore/vkDestroyFence.
+  // Semaphores can still be in use by in-flight submissions at shutdown.
+  // Waiting for idle prevents VUID errors during vkDestroySemaphore.
   vkDeviceWaitIdle(BaseDevice::base_device->logical_device);
 
-  for (uint_fast8_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  for (uint_fast8_t i = 0; i < MAX_FRAME_LATENCY; i++) {
     // Null-handle guards make destruction idempotent and safe across partial init paths.
     if (this->render_finished_semaphores[i] != VK_NULL_HANDLE) {
       vkDestroySemaphore(
@@ -593,27 +697,7 @@ void CE::BaseSynchronizationObjects::destroy() {
           nullptr);
       this->image_available_semaphores[i] = VK_NULL_HANDLE;
     }
-    if (this->compute_finished_semaphores[i] != VK_NULL_HANDLE) {
-      vkDestroySemaphore(
-          BaseDevice::base_device->logical_device,
-          this->compute_finished_semaphores[i],
-          nullptr);
-      this->compute_finished_semaphores[i] = VK_NULL_HANDLE;
-    }
-    if (this->graphics_in_flight_fences[i] != VK_NULL_HANDLE) {
-      vkDestroyFence(
-          BaseDevice::base_device->logical_device,
-          this->graphics_in_flight_fences[i],
-          nullptr);
-      this->graphics_in_flight_fences[i] = VK_NULL_HANDLE;
-    }
-    if (this->compute_in_flight_fences[i] != VK_NULL_HANDLE) {
-      vkDestroyFence(
-          BaseDevice::base_device->logical_device,
-          this->compute_in_flight_fences[i],
-          nullptr);
-      this->compute_in_flight_fences[i] = VK_NULL_HANDLE;
-    }
   }
-
+  this->compute_timeline.destroy();
+  this->graphics_timeline.destroy();
 }
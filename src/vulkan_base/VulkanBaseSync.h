@@ -22,8 +22,10 @@ class BaseSwapchain;
 class BaseCommandBuffers {
 public:
   VkCommandPool pool{};
-  std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> graphics{};
-  std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> compute{};
+  // Same handle as pool unless compute runs on its own queue family.
+  VkCommandPool compute_pool{};
+  std::array<VkCommandBuffer, MAX_FRAME_LATENCY> graphics{};
+  std::array<VkCommandBuffer, MAX_FRAME_LATENCY> compute{};
   static VkCommandBuffer singular_command_buffer;
 
   BaseCommandBuffers() = default;
@@ -47,8 +49,8 @@ public:
 
 protected:
   void create_pool(const BaseQueues::FamilyIndices &family_indices);
-  void create_buffers(
-      std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> &command_buffers) const;
+  void create_buffers(std::array<VkCommandBuffer, MAX_FRAME_LATENCY> &command_buffers,
+                      const VkCommandPool command_pool) const;
 };
 
 class BaseSingleUseCommands {
@@ -69,17 +71,28 @@ private:
   bool submitted_{false};
 };
 
-struct BaseCommandInterface {
-  VkCommandBuffer &command_buffer;
-  const VkCommandPool &command_pool;
-  const VkQueue &queue;
-
-  BaseCommandInterface(VkCommandBuffer &command_buffer_ref,
-                   const VkCommandPool &command_pool_ref,
-                   const VkQueue &queue_ref)
-      : command_buffer(command_buffer_ref),
-        command_pool(command_pool_ref),
-        queue(queue_ref) {}
+// Monotonic progress counter of one queue (Vulkan 1.2 timeline semaphore). Submissions
+// signal increasing values; the host waits for a value instead of resetting fences.
+class BaseTimeline {
+public:
+  VkSemaphore semaphore{VK_NULL_HANDLE};
+  // Highest value a submission has been asked to signal so far.
+  uint64_t submitted{0};
+
+  BaseTimeline() = default;
+  BaseTimeline(const BaseTimeline &) = delete;
+  BaseTimeline &operator=(const BaseTimeline &) = delete;
+  BaseTimeline(BaseTimeline &&) = delete;
+  BaseTimeline &operator=(BaseTimeline &&) = delete;
+
+  void create();
+  void destroy();
+  uint64_t completed() const;
+  // Returns at once when value has already been reached.
+  void wait(const uint64_t value) const;
+  void wait_submitted() const {
+    wait(submitted);
+  }
 };
 
 class BaseSynchronizationObjects {
@@ -93,11 +106,19 @@ public:
     destroy();
   };
 
-  std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> image_available_semaphores{};
-  std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> render_finished_semaphores{};
-  std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> compute_finished_semaphores{};
-  std::array<VkFence, MAX_FRAMES_IN_FLIGHT> graphics_in_flight_fences{};
-  std::array<VkFence, MAX_FRAMES_IN_FLIGHT> compute_in_flight_fences{};
+  // Binary: the swapchain only speaks binary semaphores.
+  std::array<VkSemaphore, MAX_FRAME_LATENCY> image_available_semaphores{};
+  std::array<VkSemaphore, MAX_FRAME_LATENCY> render_finished_semaphores{};
+  // Frame N's compute submission signals compute_timeline = N, its graphics submission
+  // graphics_timeline = N; graphics waits on compute N, and a frame slot is reused once
+  // both timelines passed the values recorded for it.
+  BaseTimeline compute_timeline{};
+  BaseTimeline graphics_timeline{};
+  std::array<uint64_t, MAX_FRAME_LATENCY> compute_slot_values{};
+  std::array<uint64_t, MAX_FRAME_LATENCY> graphics_slot_values{};
+  uint64_t next_frame_value = 1;
+  // CE_FRAMES_IN_FLIGHT, 1..MAX_FRAME_LATENCY; frames the CPU may record ahead of the GPU.
+  uint32_t frames_in_flight = MAX_FRAMES_IN_FLIGHT;
   uint32_t current_frame = 0;
 
 protected:
@@ -114,6 +135,9 @@ public:
   VkFormat image_format{};
   std::array<CE::BaseImage, MAX_FRAMES_IN_FLIGHT> images{};
   std::array<VkFramebuffer, MAX_FRAMES_IN_FLIGHT> framebuffers{};
+  // Layout images rest in between frames: PRESENT_SRC for a real swapchain,
+  // TRANSFER_SRC for the headless offscreen ring (ready for readback).
+  VkImageLayout present_layout{VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
 
   struct SupportDetails {
     VkSurfaceCapabilitiesKHR capabilities{};
@@ -141,6 +165,7 @@ protected:
 private:
   SupportDetails support_details{};
   void destroy();
+  void create_offscreen();
   VkSurfaceFormatKHR
   pick_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats) const;
   VkPresentModeKHR pick_present_mode(
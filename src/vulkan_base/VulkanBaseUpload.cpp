@@ -0,0 +1,316 @@
+#include "VulkanBaseUpload.h"
+#include "VulkanBaseDevice.h"
+#include "VulkanBaseUtils.h"
+
+#include "engine/Log.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+// Satisfies bufferOffset rules for every format we upload (multiple of 4 and of texel size).
+constexpr VkDeviceSize staging_alignment = 16;
+} // namespace
+
+CE::BaseUploader::BaseUploader(const uint32_t queue_family,
+                               const VkQueue &queue,
+                               const VkDeviceSize capacity)
+    : queue_(queue), capacity_(capacity) {
+  Log::text("{ XFR }", "Upload Ring", capacity, "bytes");
+
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = queue_family;
+  CE::vulkan_result(vkCreateCommandPool,
+                    BaseDevice::base_device->logical_device,
+                    &poolInfo,
+                    nullptr,
+                    &this->pool_);
+
+  BaseBuffer::create(capacity,
+                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     this->ring_);
+  this->ring_data_ = static_cast<std::byte *>(this->ring_.map());
+}
+
+CE::BaseUploader::~BaseUploader() {
+  if (!BaseDevice::base_device) {
+    return;
+  }
+  while (!this->in_flight_.empty()) {
+    vkWaitForFences(BaseDevice::base_device->logical_device,
+                    1,
+                    &this->in_flight_.front().fence,
+                    VK_TRUE,
+                    std::numeric_limits<uint64_t>::max());
+    retire(this->in_flight_.front());
+    this->in_flight_.pop_front();
+  }
+  vkDestroyCommandPool(BaseDevice::base_device->logical_device, this->pool_, nullptr);
+}
+
+std::pair<VkBuffer, VkDeviceSize> CE::BaseUploader::stage(const VkDeviceSize size,
+                                                          std::byte *&data) {
+  const VkDeviceSize aligned = (size + staging_alignment - 1) & ~(staging_alignment - 1);
+  if (aligned > this->capacity_) {
+    auto staging = std::make_unique<BaseBuffer>();
+    BaseBuffer::create(size,
+                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       *staging);
+    data = static_cast<std::byte *>(staging->map());
+    const VkBuffer buffer = staging->buffer;
+    this->pending_.overflow.push_back(std::move(staging));
+    return {buffer, 0};
+  }
+
+  while (true) {
+    if (this->used_ == 0) {
+      this->head_ = 0;
+    }
+    // Bytes skipped at the end of the ring when the request would straddle the wrap.
+    const VkDeviceSize waste =
+        this->head_ + aligned > this->capacity_ ? this->capacity_ - this->head_ : 0;
+    if (this->used_ + waste + aligned <= this->capacity_) {
+      if (waste > 0) {
+        this->head_ = 0;
+      }
+      const VkDeviceSize offset = this->head_;
+      this->head_ += aligned;
+      this->used_ += waste + aligned;
+      this->pending_.ring_bytes += waste + aligned;
+      data = this->ring_data_ + offset;
+      return {this->ring_.buffer, offset};
+    }
+
+    // Ring full: hand queued copies to the GPU and wait for the oldest batch to free space.
+    flush();
+    if (this->in_flight_.empty()) {
+      throw std::runtime_error("\n!ERROR! upload ring exhausted with nothing in flight!");
+    }
+    wait(this->in_flight_.front().id);
+  }
+}
+
+void CE::BaseUploader::upload(const void *data,
+                              const VkDeviceSize size,
+                              const VkBuffer dst,
+                              const VkDeviceSize dst_offset) {
+  if (size == 0) {
+    return;
+  }
+  std::memcpy(reserve(size, dst, dst_offset), data, static_cast<size_t>(size));
+}
+
+void *CE::BaseUploader::reserve(const VkDeviceSize size,
+                                const VkBuffer dst,
+                                const VkDeviceSize dst_offset) {
+  std::byte *data{};
+  const auto [src, src_offset] = stage(size, data);
+  this->buffer_copies_.push_back(BufferCopy{
+      .src = src,
+      .dst = dst,
+      .region = VkBufferCopy{.srcOffset = src_offset, .dstOffset = dst_offset, .size = size}});
+  this->pending_copy_bytes_ += size;
+  return data;
+}
+
+void *CE::BaseUploader::reserve(const VkDeviceSize size, std::initializer_list<VkBuffer> dsts) {
+  std::byte *data{};
+  const auto [src, src_offset] = stage(size, data);
+  for (const VkBuffer dst : dsts) {
+    this->buffer_copies_.push_back(BufferCopy{
+        .src = src,
+        .dst = dst,
+        .region = VkBufferCopy{.srcOffset = src_offset, .dstOffset = 0, .size = size}});
+    this->pending_copy_bytes_ += size;
+  }
+  return data;
+}
+
+void CE::BaseUploader::upload_image(const void *pixels,
+                                    const VkDeviceSize size,
+                                    BaseImage &image,
+                                    const uint32_t width,
+                                    const uint32_t height) {
+  std::byte *data{};
+  const auto [src, src_offset] = stage(size, data);
+  std::memcpy(data, pixels, static_cast<size_t>(size));
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = src_offset;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+  this->image_copies_.push_back(ImageCopy{.src = src, .image = &image, .region = region});
+  this->pending_copy_bytes_ += size;
+}
+
+uint64_t CE::BaseUploader::flush() {
+  if (this->buffer_copies_.empty() && this->image_copies_.empty()) {
+    return 0;
+  }
+  const VkDevice device = BaseDevice::base_device->logical_device;
+
+  VkCommandBufferAllocateInfo allocateInfo{};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocateInfo.commandPool = this->pool_;
+  allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocateInfo.commandBufferCount = 1;
+  CE::vulkan_result(
+      vkAllocateCommandBuffers, device, &allocateInfo, &this->pending_.command_buffer);
+  const VkCommandBuffer command_buffer = this->pending_.command_buffer;
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  CE::vulkan_result(vkBeginCommandBuffer, command_buffer, &beginInfo);
+
+  // Runtime uploads may overwrite buffers that earlier submissions on this queue still use.
+  const VkMemoryBarrier before{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                               .pNext = nullptr,
+                               .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+                               .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT};
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       1,
+                       &before,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+
+  for (const ImageCopy &copy : this->image_copies_) {
+    copy.image->transition_layout(command_buffer,
+                                  copy.image->info.format,
+                                  VK_IMAGE_LAYOUT_UNDEFINED,
+                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  }
+
+  // Consecutive copies between the same pair of buffers share one vkCmdCopyBuffer.
+  std::vector<VkBufferCopy> regions{};
+  for (size_t i = 0; i < this->buffer_copies_.size(); ++i) {
+    const BufferCopy &copy = this->buffer_copies_[i];
+    regions.push_back(copy.region);
+    const bool last_of_pair = i + 1 == this->buffer_copies_.size() ||
+                              this->buffer_copies_[i + 1].src != copy.src ||
+                              this->buffer_copies_[i + 1].dst != copy.dst;
+    if (last_of_pair) {
+      vkCmdCopyBuffer(command_buffer,
+                      copy.src,
+                      copy.dst,
+                      static_cast<uint32_t>(regions.size()),
+                      regions.data());
+      regions.clear();
+    }
+  }
+
+  for (const ImageCopy &copy : this->image_copies_) {
+    vkCmdCopyBufferToImage(command_buffer,
+                           copy.src,
+                           copy.image->image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1,
+                           &copy.region);
+    copy.image->transition_layout(command_buffer,
+                                  copy.image->info.format,
+                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  }
+
+  // Makes the copies visible to whatever is submitted to this queue afterwards.
+  const VkMemoryBarrier after{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                              .pNext = nullptr,
+                              .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                              .dstAccessMask =
+                                  VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT};
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       0,
+                       1,
+                       &after,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+  CE::vulkan_result(vkEndCommandBuffer, command_buffer);
+
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  CE::vulkan_result(vkCreateFence, device, &fenceInfo, nullptr, &this->pending_.fence);
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &command_buffer;
+  CE::vulkan_result(vkQueueSubmit, this->queue_, 1, &submitInfo, this->pending_.fence);
+
+  this->pending_.id = this->next_batch_++;
+  Log::text("{ XFR }",
+            "Upload batch",
+            this->pending_.id,
+            "buffers",
+            this->buffer_copies_.size(),
+            "images",
+            this->image_copies_.size(),
+            "bytes",
+            this->pending_copy_bytes_,
+            "overflow",
+            this->pending_.overflow.size());
+
+  const uint64_t id = this->pending_.id;
+  this->in_flight_.push_back(std::move(this->pending_));
+  this->pending_ = Batch{};
+  this->buffer_copies_.clear();
+  this->image_copies_.clear();
+  this->pending_copy_bytes_ = 0;
+
+  collect();
+  return id;
+}
+
+void CE::BaseUploader::wait(const uint64_t batch) {
+  while (!this->in_flight_.empty() && this->in_flight_.front().id <= batch) {
+    vkWaitForFences(BaseDevice::base_device->logical_device,
+                    1,
+                    &this->in_flight_.front().fence,
+                    VK_TRUE,
+                    std::numeric_limits<uint64_t>::max());
+    retire(this->in_flight_.front());
+    this->in_flight_.pop_front();
+  }
+}
+
+void CE::BaseUploader::wait_idle() {
+  flush();
+  wait(this->next_batch_ - 1);
+}
+
+void CE::BaseUploader::collect() {
+  while (!this->in_flight_.empty() &&
+         vkGetFenceStatus(BaseDevice::base_device->logical_device,
+                          this->in_flight_.front().fence) == VK_SUCCESS) {
+    retire(this->in_flight_.front());
+    this->in_flight_.pop_front();
+  }
+}
+
+void CE::BaseUploader::retire(Batch &batch) {
+  const VkDevice device = BaseDevice::base_device->logical_device;
+  vkDestroyFence(device, batch.fence, nullptr);
+  vkFreeCommandBuffers(device, this->pool_, 1, &batch.command_buffer);
+  this->used_ -= batch.ring_bytes;
+  this->completed_batch_ = batch.id;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Host -> device upload batching through one persistently mapped staging ring.
+// Exists so startup and runtime transfers share a submission instead of one wait per buffer.
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanBaseResources.h"
+
+namespace CE {
+
+class BaseUploader {
+public:
+  static constexpr VkDeviceSize default_capacity = 32ull * 1024 * 1024;
+
+  BaseUploader(const uint32_t queue_family,
+               const VkQueue &queue,
+               const VkDeviceSize capacity = default_capacity);
+  BaseUploader(const BaseUploader &) = delete;
+  BaseUploader &operator=(const BaseUploader &) = delete;
+  BaseUploader(BaseUploader &&) = delete;
+  BaseUploader &operator=(BaseUploader &&) = delete;
+  virtual ~BaseUploader();
+
+  // Queues a copy into dst; the bytes are staged immediately, so data may be freed on return.
+  void upload(const void *data,
+              const VkDeviceSize size,
+              const VkBuffer dst,
+              const VkDeviceSize dst_offset = 0);
+  // Staging memory for the caller to fill in place, copied to dst on the next flush().
+  void *reserve(const VkDeviceSize size, const VkBuffer dst, const VkDeviceSize dst_offset = 0);
+  // One staged copy of the bytes, written to the start of every buffer in dsts.
+  void *reserve(const VkDeviceSize size, std::initializer_list<VkBuffer> dsts);
+  // Copies tightly packed RGBA8 pixels into image and leaves it SHADER_READ_ONLY_OPTIMAL.
+  void upload_image(const void *pixels,
+                    const VkDeviceSize size,
+                    BaseImage &image,
+                    const uint32_t width,
+                    const uint32_t height);
+
+  // Submits everything queued so far as one command buffer; returns its batch id
+  // (0 when nothing was queued). Does not wait.
+  uint64_t flush();
+  void wait(const uint64_t batch);
+  void wait_idle();
+  // Recycles staging space of batches the GPU has finished; never blocks.
+  void collect();
+  uint64_t completed_batch() const {
+    return completed_batch_;
+  }
+
+private:
+  struct BufferCopy {
+    VkBuffer src{};
+    VkBuffer dst{};
+    VkBufferCopy region{};
+  };
+  struct ImageCopy {
+    VkBuffer src{};
+    BaseImage *image{};
+    VkBufferImageCopy region{};
+  };
+  struct Batch {
+    uint64_t id{0};
+    VkFence fence{VK_NULL_HANDLE};
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    VkDeviceSize ring_bytes{0};
+    // Uploads larger than the ring get their own staging buffer for one batch.
+    std::vector<std::unique_ptr<BaseBuffer>> overflow{};
+  };
+
+  const VkQueue &queue_;
+  VkCommandPool pool_{VK_NULL_HANDLE};
+  BaseBuffer ring_{};
+  std::byte *ring_data_{nullptr};
+  VkDeviceSize capacity_{0};
+  VkDeviceSize head_{0};
+  VkDeviceSize used_{0};
+
+  Batch pending_{};
+  std::vector<BufferCopy> buffer_copies_{};
+  std::vector<ImageCopy> image_copies_{};
+  std::deque<Batch> in_flight_{};
+  uint64_t next_batch_{1};
+  uint64_t completed_batch_{0};
+  VkDeviceSize pending_copy_bytes_{0};
+
+  // Ring offset for size bytes (or an overflow buffer) backing the next copy.
+  std::pair<VkBuffer, VkDeviceSize> stage(const VkDeviceSize size, std::byte *&data);
+  void retire(Batch &batch);
+};
+
+} // namespace CE
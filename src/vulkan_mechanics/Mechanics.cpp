@@ -32,4 +32,6 @@ void VulkanMechanics::BaseSwapchain::recreate(const VkSurfaceKHR &surface,
 
   resources.storage_image.create_descriptor_write(resources.descriptor_interface, images);
   resources.descriptor_interface.update_sets();
+  // Updated sets and work groups invalidate everything recorded against the old ones.
+  resources.commands.invalidate_recorded();
 }
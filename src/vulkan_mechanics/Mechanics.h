@@ -34,6 +34,14 @@ public:
       features.wideLines = VK_TRUE;
       features.samplerAnisotropy = VK_TRUE;
       features.shaderInt64 = VK_TRUE;
+      // Cell detail levels share one instance list, each drawn from its own offset (CellCull).
+      features.drawIndirectFirstInstance = VK_TRUE;
+      // Packed one-byte alive stream (shaders/CellStreams.glsl).
+      features_12.storageBuffer8BitAccess = VK_TRUE;
+      // Frame pacing (FrameContext, CE::BaseTimeline).
+      features_12.timelineSemaphore = VK_TRUE;
+      // Timestamp pools are recycled from the CPU (CE::BaseGpuProfiler).
+      features_12.hostQueryReset = VK_TRUE;
 
       pick_physical_device(init_vulkan, queues, swapchain);
       create_logical_device(init_vulkan, queues);
@@ -6,6 +6,7 @@
 #include "vulkan_base/VulkanBaseUtils.h"
 #include "control/Window.h"
 #include "engine/Log.h"
+#include "engine/Trace.h"
 
 #include <algorithm>
 #include <array>
@@ -17,6 +18,7 @@
 
 namespace {
 constexpr size_t GRAPHICS_WAIT_COUNT = 2;
+constexpr size_t GRAPHICS_SIGNAL_COUNT = 2;
 constexpr uint32_t SINGLE_OBJECT_COUNT = 1;
 
 double ms_since(const std::chrono::steady_clock::time_point &start,
@@ -93,53 +95,104 @@ thread_local FrameSample g_sample{};
 FrameContext::FrameContext(VulkanMechanics &mechanics,
                            VulkanResources &resources,
                            Pipelines &pipelines)
-    : mechanics_(mechanics), resources_(resources), pipelines_(pipelines) {}
+    : mechanics_(mechanics), resources_(resources), pipelines_(pipelines),
+      scheduler_(Window::get().is_headless()) {}
 
 void FrameContext::draw_frame(uint32_t &last_presented_image_index,
                               uint32_t &last_submitted_frame_index,
                               const std::function<void()> &recreate_swapchain) {
   const auto t_frame_start = std::chrono::steady_clock::now();
-  const uint32_t frame_index = mechanics_.sync_objects.current_frame;
+  CE::BaseSynchronizationObjects &sync = mechanics_.sync_objects;
+  const uint32_t frame_index = sync.current_frame;
+  // Timeline value both submissions of this frame signal.
+  const uint64_t frame_value = sync.next_frame_value++;
+  // Headless runs render into the offscreen ring slot matching the frame index;
+  // there is no acquire, image-available wait, or present.
+  const bool headless = Window::get().is_headless();
+  const bool async_compute = mechanics_.queues.indices.async_compute();
 
   g_sample = FrameSample{};
 
   const auto submit_compute = [&]() {
     const auto t_submit_start = std::chrono::steady_clock::now();
 
+    // Blocks only when the CPU is frames_in_flight frames ahead of the compute queue.
     const auto t_wait_start = std::chrono::steady_clock::now();
-    vkWaitForFences(mechanics_.main_device.logical_device,
-                    1,
-                    &mechanics_.sync_objects.compute_in_flight_fences[frame_index],
-                    VK_TRUE,
-                    UINT64_MAX);
+    sync.compute_timeline.wait(sync.compute_slot_values[frame_index]);
     const auto t_wait_end = std::chrono::steady_clock::now();
     g_sample.compute_wait_ms = ms_since(t_wait_start, t_wait_end);
+    Trace::complete("compute timeline wait", t_wait_start, t_wait_end);
+    resources_.commands.profiler.begin_frame(CE::BaseGpuProfiler::Queue::Compute, frame_index);
+    // A checkpoint copied by the slot's previous submission is complete now; write it off-thread.
+    resources_.commands.checkpoints.collect(frame_index);
+    resources_.commands.deltas.collect(frame_index);
+    resources_.commands.hashes.collect(frame_index);
+
+    scheduler_.report_compute_wait(g_sample.compute_wait_ms);
+    resources_.simulation_batch = scheduler_.next_batch(resources_.world._time);
+
+    {
+      Trace::Scope scope("uniform update");
+      // The slot's copy was last read by its previous frame's draws, which can still be
+      // running once its compute finished; graphics waits for them right after anyway.
+      sync.graphics_timeline.wait(sync.graphics_slot_values[frame_index]);
+      resources_.uniform.update(resources_.world, mechanics_.swapchain.extent, frame_index);
+    }
+
+    // Uploads queued since the last frame are submitted ahead of this frame's compute work.
+    // A separate compute queue is not ordered behind them, so it waits for the rare frame
+    // that has any.
+    {
+      Trace::Scope scope("upload flush");
+      const uint64_t upload_batch = resources_.uploader.flush();
+      if (async_compute && upload_batch != 0) {
+        resources_.uploader.wait(upload_batch);
+      }
+      resources_.uploader.collect();
+    }
 
-    resources_.uniform.update(resources_.world, mechanics_.swapchain.extent);
+    {
+      Trace::Scope scope("compute record");
+      vkResetCommandBuffer(resources_.commands.compute[frame_index], 0);
+      resources_.commands.record_compute_command_buffer(resources_, pipelines_, frame_index);
+    }
 
-    vkResetFences(mechanics_.main_device.logical_device,
-                  1,
-                  &mechanics_.sync_objects.compute_in_flight_fences[frame_index]);
+    // Async compute: only the transfers at the end (the cull's command reset and the
+    // render_cells copy) wait for graphics to finish drawing this slot's previous frame; the
+    // Engine steps before them overlap that draw.
+    const VkPipelineStageFlags free_wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    const uint64_t free_wait_value = sync.graphics_slot_values[frame_index];
+    const bool wait_for_free = async_compute && free_wait_value != 0;
 
-    vkResetCommandBuffer(resources_.commands.compute[frame_index], 0);
-    resources_.commands.record_compute_command_buffer(resources_, pipelines_, frame_index);
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = wait_for_free ? SINGLE_OBJECT_COUNT : 0,
+        .pWaitSemaphoreValues = &free_wait_value,
+        .signalSemaphoreValueCount = SINGLE_OBJECT_COUNT,
+        .pSignalSemaphoreValues = &frame_value};
 
     VkSubmitInfo compute_submit_info{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 0,
-        .pWaitSemaphores = nullptr,
-        .pWaitDstStageMask = nullptr,
+        .pNext = &timeline_info,
+        .waitSemaphoreCount = wait_for_free ? SINGLE_OBJECT_COUNT : 0,
+        .pWaitSemaphores = &sync.graphics_timeline.semaphore,
+        .pWaitDstStageMask = &free_wait_stage,
         .commandBufferCount = 1,
         .pCommandBuffers = &resources_.commands.compute[frame_index],
         .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &mechanics_.sync_objects.compute_finished_semaphores[frame_index]};
+        .pSignalSemaphores = &sync.compute_timeline.semaphore};
 
+    const auto t_queue_submit = std::chrono::steady_clock::now();
+    resources_.commands.profiler.submitted(CE::BaseGpuProfiler::Queue::Compute, frame_index);
     CE::vulkan_result(vkQueueSubmit,
                       mechanics_.queues.compute_queue,
                       SINGLE_OBJECT_COUNT,
                       &compute_submit_info,
-                      mechanics_.sync_objects.compute_in_flight_fences[frame_index]);
+                      VK_NULL_HANDLE);
+    Trace::complete("compute submit", t_queue_submit, std::chrono::steady_clock::now());
+    sync.compute_timeline.submitted = frame_value;
+    sync.compute_slot_values[frame_index] = frame_value;
 
     const auto t_submit_end = std::chrono::steady_clock::now();
     g_sample.compute_work_ms =
@@ -147,14 +200,21 @@ void FrameContext::draw_frame(uint32_t &last_presented_image_index,
   };
 
   const auto acquire_image = [&](uint32_t &image_index) {
+    // The slot's command buffer and binary semaphores are free once its previous
+    // graphics submission completed.
     const auto t_wait_start = std::chrono::steady_clock::now();
-    vkWaitForFences(mechanics_.main_device.logical_device,
-                    1,
-                    &mechanics_.sync_objects.graphics_in_flight_fences[frame_index],
-                    VK_TRUE,
-                    UINT64_MAX);
+    sync.graphics_timeline.wait(sync.graphics_slot_values[frame_index]);
     const auto t_wait_end = std::chrono::steady_clock::now();
     g_sample.graphics_wait_ms = ms_since(t_wait_start, t_wait_end);
+    Trace::complete("graphics timeline wait", t_wait_start, t_wait_end);
+    resources_.commands.profiler.begin_frame(CE::BaseGpuProfiler::Queue::Graphics, frame_index);
+    // A screenshot copied by the slot's previous frame is complete now; encode it off-thread.
+    resources_.commands.screenshots.collect(frame_index);
+
+    if (headless) {
+      image_index = frame_index % MAX_FRAMES_IN_FLIGHT;
+      return true;
+    }
 
     const auto t_acquire_start = std::chrono::steady_clock::now();
     VkResult result = vkAcquireNextImageKHR(mechanics_.main_device.logical_device,
@@ -165,6 +225,7 @@ void FrameContext::draw_frame(uint32_t &last_presented_image_index,
                                             &image_index);
     const auto t_acquire_end = std::chrono::steady_clock::now();
     g_sample.acquire_ms = ms_since(t_acquire_start, t_acquire_end);
+    Trace::complete("acquire", t_acquire_start, t_acquire_end);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
       Window::get().framebuffer_resized = false;
@@ -180,39 +241,63 @@ void FrameContext::draw_frame(uint32_t &last_presented_image_index,
 
   const auto submit_graphics = [&](const uint32_t image_index) {
     const auto t_submit_start = std::chrono::steady_clock::now();
-    vkResetFences(mechanics_.main_device.logical_device,
-                  1,
-                  &mechanics_.sync_objects.graphics_in_flight_fences[frame_index]);
-
     vkResetCommandBuffer(resources_.commands.graphics[frame_index], 0);
     resources_.commands.record_graphics_command_buffer(
         mechanics_.swapchain, resources_, pipelines_, frame_index, image_index);
+    const auto t_record_end = std::chrono::steady_clock::now();
+    Trace::complete("graphics record", t_submit_start, t_record_end);
 
+    // Timeline entries first, so headless runs can drop the binary swapchain ones by count.
     const std::array<VkSemaphore, GRAPHICS_WAIT_COUNT> wait_semaphores{
-        mechanics_.sync_objects.compute_finished_semaphores[frame_index],
-        mechanics_.sync_objects.image_available_semaphores[frame_index]};
+        sync.compute_timeline.semaphore,
+        sync.image_available_semaphores[frame_index]};
     const std::array<VkPipelineStageFlags, GRAPHICS_WAIT_COUNT> wait_stages{
-        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    // Values of binary entries are ignored.
+    const std::array<uint64_t, GRAPHICS_WAIT_COUNT> wait_values{frame_value, 0};
+
+    const std::array<VkSemaphore, GRAPHICS_SIGNAL_COUNT> signal_semaphores{
+        sync.graphics_timeline.semaphore,
+        sync.render_finished_semaphores[frame_index]};
+    const std::array<uint64_t, GRAPHICS_SIGNAL_COUNT> signal_values{frame_value, 0};
+
+    // Headless: only the compute wait applies and nothing presents render_finished.
+    const uint32_t wait_count =
+        headless ? SINGLE_OBJECT_COUNT : static_cast<uint32_t>(wait_semaphores.size());
+    const uint32_t signal_count =
+        headless ? SINGLE_OBJECT_COUNT : static_cast<uint32_t>(signal_semaphores.size());
+
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = wait_count,
+        .pWaitSemaphoreValues = wait_values.data(),
+        .signalSemaphoreValueCount = signal_count,
+        .pSignalSemaphoreValues = signal_values.data()};
 
     VkSubmitInfo graphics_submit_info{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size()),
+        .pNext = &timeline_info,
+        .waitSemaphoreCount = wait_count,
         .pWaitSemaphores = wait_semaphores.data(),
         .pWaitDstStageMask = wait_stages.data(),
         .commandBufferCount = SINGLE_OBJECT_COUNT,
         .pCommandBuffers = &resources_.commands.graphics[frame_index],
-        .signalSemaphoreCount = SINGLE_OBJECT_COUNT,
-        .pSignalSemaphores = &mechanics_.sync_objects.render_finished_semaphores[frame_index]};
+        .signalSemaphoreCount = signal_count,
+        .pSignalSemaphores = signal_semaphores.data()};
 
+    resources_.commands.profiler.submitted(CE::BaseGpuProfiler::Queue::Graphics, frame_index);
     CE::vulkan_result(vkQueueSubmit,
                       mechanics_.queues.graphics_queue,
                       SINGLE_OBJECT_COUNT,
                       &graphics_submit_info,
-                      mechanics_.sync_objects.graphics_in_flight_fences[frame_index]);
+                      VK_NULL_HANDLE);
+    sync.graphics_timeline.submitted = frame_value;
+    sync.graphics_slot_values[frame_index] = frame_value;
     const auto t_submit_end = std::chrono::steady_clock::now();
     g_sample.graphics_submit_ms = ms_since(t_submit_start, t_submit_end);
+    Trace::complete("graphics submit", t_record_end, t_submit_end);
   };
 
   const auto present = [&](const uint32_t image_index) {
@@ -223,7 +308,7 @@ void FrameContext::draw_frame(uint32_t &last_presented_image_index,
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .pNext = nullptr,
         .waitSemaphoreCount = SINGLE_OBJECT_COUNT,
-        .pWaitSemaphores = &mechanics_.sync_objects.render_finished_semaphores[frame_index],
+        .pWaitSemaphores = &sync.render_finished_semaphores[frame_index],
         .swapchainCount = SINGLE_OBJECT_COUNT,
         .pSwapchains = &swapchain,
         .pImageIndices = &image_index,
@@ -243,6 +328,7 @@ void FrameContext::draw_frame(uint32_t &last_presented_image_index,
     }
     const auto t_present_end = std::chrono::steady_clock::now();
     g_sample.present_ms = ms_since(t_present_start, t_present_end);
+    Trace::complete("present", t_present_start, t_present_end);
   };
 
   submit_compute();
@@ -253,17 +339,20 @@ void FrameContext::draw_frame(uint32_t &last_presented_image_index,
   }
 
   submit_graphics(image_index);
-  present(image_index);
+  if (!headless) {
+    present(image_index);
+  }
 
   last_presented_image_index = image_index;
   last_submitted_frame_index = frame_index;
 
   // Move to next frame-in-flight slot (ring buffer indexing).
-  mechanics_.sync_objects.current_frame =
-      (mechanics_.sync_objects.current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+  sync.current_frame = (sync.current_frame + 1) % sync.frames_in_flight;
+
+  const auto t_frame_end = std::chrono::steady_clock::now();
+  Trace::complete("frame", t_frame_start, t_frame_end);
 
   if (g_profiler.enabled) {
-    const auto t_frame_end = std::chrono::steady_clock::now();
     const double frame_ms = ms_since(t_frame_start, t_frame_end);
     g_profiler.frames += 1;
     g_profiler.sum_compute_wait_ms += g_sample.compute_wait_ms;
@@ -3,6 +3,8 @@
 // Per-frame submission coordinator.
 // Exists to sequence acquire/compute/graphics/present with correct sync ordering.
 
+#include "control/StepScheduler.h"
+
 #include <cstdint>
 #include <functional>
 
@@ -14,6 +16,10 @@ class FrameContext {
 public:
   FrameContext(VulkanMechanics &mechanics, VulkanResources &resources, Pipelines &pipelines);
 
+  const StepScheduler &scheduler() const {
+    return scheduler_;
+  }
+
   void draw_frame(uint32_t &last_presented_image_index,
                   uint32_t &last_submitted_frame_index,
                   const std::function<void()> &recreate_swapchain);
@@ -31,4 +37,5 @@ private:
   VulkanMechanics &mechanics_;
   VulkanResources &resources_;
   Pipelines &pipelines_;
+  StepScheduler scheduler_;
 };
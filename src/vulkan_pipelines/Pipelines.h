@@ -38,7 +38,7 @@ public:
 		Render(CE::BaseSwapchain &swapchain,
 					 const CE::BaseImage &msaa_image,
 					 const VkImageView &depth_view) {
-			create(msaa_image.info.samples, swapchain.image_format);
+			create(msaa_image.info.samples, swapchain.image_format, swapchain.present_layout);
 			create_framebuffers(swapchain, msaa_image.view, depth_view);
 		}
 	};
@@ -65,7 +65,24 @@ public:
 			if (pipeline_name == "Engine") {
 				return compute_groups_2d(16, 16);
 			}
-			if (pipeline_name == "SeedCells") {
+			if (pipeline_name == "SeedCells" || pipeline_name == "CellCull" ||
+					pipeline_name == "CellHash") {
+				return compute_groups_2d(16, 16);
+			}
+			// One 256-cell row segment per group, so group order is cell index order.
+			if (pipeline_name == "CellDelta") {
+				return compute_groups_2d(256, 1);
+			}
+			// TerrainSurfaceBake: one invocation per grid cell, each baking its subdivided patch.
+			if (pipeline_name == "TerrainBake" || pipeline_name == "TerrainJumpFlood" ||
+					pipeline_name == "TerrainSurfaceBake") {
+				return compute_groups_2d(16, 16);
+			}
+			if (pipeline_name == "ConwayPack" || pipeline_name == "Conway") {
+				// One invocation per 32-cell occupancy word along x.
+				return compute_groups_2d(16 * 32, 16);
+			}
+			if (pipeline_name == "ConwayUnpack") {
 				return compute_groups_2d(16, 16);
 			}
 			if (pipeline_name == "PostFX") {
@@ -2,11 +2,13 @@
 #include "Pipelines.h"
 #include "vulkan_resources/VulkanResources.h"
 #include "control/gui.h"
+#include "engine/Log.h"
 #include "vulkan_base/VulkanBaseUtils.h"
 #include "world/RuntimeConfig.h"
 
 #include <array>
 #include <algorithm>
+#include <bit>
 #include <string_view>
 #include <stdexcept>
 #include <unordered_map>
@@ -26,49 +28,457 @@ void CE::ShaderAccess::CommandResources::record_compute_command_buffer(
     throw std::runtime_error("failed to begin recording compute command buffer!");
   }
 
-  vkCmdBindDescriptorSets(command_buffer,
-                          VK_PIPELINE_BIND_POINT_COMPUTE,
-                          pipelines.compute.layout,
-                          0,
-                          1,
-                          &resources.descriptor_interface.sets[frame_index],
-                          0,
-                          nullptr);
+  // Every bind selects this frame slot's copy of the uniform buffer.
+  const uint32_t uniform_offset = resources.uniform.offset(frame_index);
+  const auto bind_cell_set = [&](const uint32_t set_index) {
+    vkCmdBindDescriptorSets(command_buffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipelines.compute.layout,
+                            0,
+                            1,
+                            &resources.descriptor_interface.sets[set_index],
+                            1,
+                            &uniform_offset);
+  };
+  bind_cell_set(resources.latest_cell_buffer);
+
+  // Terrain is static: bake height/shore data once, ahead of the first Engine step.
+  if (resources.terrain_bake_pending) {
+    record_terrain_bake(command_buffer, resources, pipelines, frame_index);
+    resources.terrain_bake_pending = false;
+  }
+
+  const std::vector<DispatchCommand> &pre_compute = compiled_graph(resources, pipelines).pre_compute;
+
+  const auto insert_compute_barrier = [&](VkCommandBuffer buffer) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(buffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+  };
+
+  const auto dispatch = [&](const DispatchCommand &command) {
+    const uint32_t scope =
+        profiler.begin(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, command.node);
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, command.pipeline);
+    vkCmdDispatch(command_buffer,
+                  command.work_groups[0],
+                  command.work_groups[1],
+                  command.work_groups[2]);
+    profiler.end(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, scope);
+  };
+
+  // With step hashes, the sub-hour remainder (wall time) must not reach Engine's day cycle.
+  const auto push_time = [&](const uint64_t hour) {
+    const Timer &time = resources.world._time;
+    resources.push_constant.set_data(static_cast<uint32_t>(hour),
+                                     hashes.enabled() ? time.whole_hour_day_fraction(hour)
+                                                      : time.day_fraction_at(hour));
+    vkCmdPushConstants(command_buffer,
+                       pipelines.compute.layout,
+                       resources.push_constant.shader_stage,
+                       resources.push_constant.offset,
+                       resources.push_constant.size,
+                       resources.push_constant.data.data());
+  };
+
+  const StepScheduler::Batch batch = resources.simulation_batch;
+  const bool steps = batch.count > 0 && !pre_compute.empty();
+  const bool record_hashes = hashes.enabled() && (resources.startup_seed_pending || steps);
+  if (record_hashes) {
+    hashes.begin(command_buffer,
+                 frame_index,
+                 resources.cell_hashes.log,
+                 (resources.startup_seed_pending ? 1u : 0u) + (steps ? batch.count : 0u));
+  }
+
+  // SeedCells fills both cell buffers, so it is independent of which side is newest.
+  if (resources.startup_seed_pending) {
+    push_time(resources.world._time.passed_hours);
+    dispatch(resolve_dispatch("SeedCells", pipelines));
+    insert_compute_barrier(command_buffer);
+    if (record_hashes) {
+      record_cell_hash(
+          command_buffer, resources, pipelines, frame_index, resources.world._time.passed_hours);
+    }
+    resources.startup_seed_pending = false;
+  }
+
+  if (steps) {
+    // Order this submission's cell writes after the previous frame's compute writes and the
+    // last cull's reads. Graphics never reads the sides; it draws the cull's visible list.
+    VkMemoryBarrier entry_barrier{};
+    entry_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    entry_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    entry_barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         1,
+                         &entry_barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    const bool record_deltas = deltas.enabled();
+    if (record_deltas) {
+      const DispatchCommand delta = resolve_dispatch("CellDelta", pipelines);
+      deltas.begin(command_buffer,
+                   frame_index,
+                   resources.cell_deltas.log,
+                   resources.cell_deltas.scratch.buffer,
+                   resources.cell_deltas.capacity,
+                   delta.work_groups[0] * delta.work_groups[1],
+                   batch.first_hour,
+                   batch.count);
+    }
+
+    // Each step runs the whole pre-compute chain once against the newest buffer, then
+    // flips which side is newest. CellDelta and CellHash read the step's sides before the
+    // flip; neither writes cells, so they need no barrier between them.
+    const bool inspect_steps = record_deltas || record_hashes;
+    for (uint32_t step = 0; step < batch.count; ++step) {
+      if (step > 0) {
+        bind_cell_set(resources.latest_cell_buffer);
+      }
+      push_time(batch.first_hour + step);
+      for (std::size_t i = 0; i < pre_compute.size(); ++i) {
+        dispatch(pre_compute[i]);
+        if (i + 1 < pre_compute.size() || step + 1 < batch.count || inspect_steps) {
+          insert_compute_barrier(command_buffer);
+        }
+      }
+      if (record_deltas) {
+        record_cell_delta(command_buffer, resources, pipelines, frame_index, step);
+      }
+      if (record_hashes) {
+        record_cell_hash(
+            command_buffer, resources, pipelines, frame_index, batch.first_hour + step);
+      }
+      if (inspect_steps && step + 1 < batch.count) {
+        insert_compute_barrier(command_buffer);
+      }
+      resources.latest_cell_buffer ^= 1u;
+    }
+  }
+
+  const VulkanResources::StorageBuffer &storage = resources.shader_storage;
+  if (record_hashes) {
+    hashes.end(command_buffer);
+  }
+  if (steps && deltas.enabled()) {
+    deltas.end(command_buffer,
+               frame_index,
+               resources.latest_cell_buffer ? storage.buffer_out.buffer
+                                            : storage.buffer_in.buffer,
+               storage.streams,
+               resources.world);
+  }
+  checkpoints.record(command_buffer,
+                     frame_index,
+                     resources.latest_cell_buffer ? storage.buffer_out.buffer
+                                                  : storage.buffer_in.buffer,
+                     storage.streams,
+                     resources.world);
+
+  record_cell_cull(command_buffer, resources, pipelines, frame_index);
+
+  if (families_.async_compute()) {
+    const uint32_t scope = profiler.begin(
+        command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, "render_cells copy");
+    record_render_cells_release(command_buffer, resources, frame_index);
+    profiler.end(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, scope);
+  }
 
-  resources.push_constant.set_data(static_cast<uint32_t>(resources.world._time.passed_hours),
-                                   resources.world._time.get_day_fraction());
+  CE::vulkan_result(vkEndCommandBuffer, command_buffer);
+}
+
+void CE::ShaderAccess::CommandResources::record_cell_delta(VkCommandBuffer command_buffer,
+                                                           VulkanResources &resources,
+                                                           Pipelines &pipelines,
+                                                           const uint32_t frame_index,
+                                                           const uint32_t step) {
+  const DispatchCommand delta = resolve_dispatch("CellDelta", pipelines);
+  const uint32_t scope =
+      profiler.begin(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, delta.node);
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, delta.pipeline);
+  // Pass 0 counts changed cells per work group, pass 1 (a single group) turns the counts
+  // into entry offsets in the log, pass 2 writes the entries.
+  for (uint32_t pass = 0; pass < 3; ++pass) {
+    if (pass > 0) {
+      VkMemoryBarrier count_barrier{};
+      count_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      count_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      count_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      vkCmdPipelineBarrier(command_buffer,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           0,
+                           1,
+                           &count_barrier,
+                           0,
+                           nullptr,
+                           0,
+                           nullptr);
+    }
+    resources.push_constant.set_data(static_cast<uint64_t>(pass) |
+                                     (static_cast<uint64_t>(step) << 32));
+    vkCmdPushConstants(command_buffer,
+                       pipelines.compute.layout,
+                       resources.push_constant.shader_stage,
+                       resources.push_constant.offset,
+                       resources.push_constant.size,
+                       resources.push_constant.data.data());
+    if (pass == 1) {
+      vkCmdDispatch(command_buffer, 1, 1, 1);
+    } else {
+      vkCmdDispatch(
+          command_buffer, delta.work_groups[0], delta.work_groups[1], delta.work_groups[2]);
+    }
+  }
+  profiler.end(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, scope);
+}
 
+void CE::ShaderAccess::CommandResources::record_cell_hash(VkCommandBuffer command_buffer,
+                                                          VulkanResources &resources,
+                                                          Pipelines &pipelines,
+                                                          const uint32_t frame_index,
+                                                          const uint64_t hour) {
+  uint32_t word = 0;
+  if (!hashes.add(frame_index, hour, word)) {
+    return;
+  }
+  const DispatchCommand hash = resolve_dispatch("CellHash", pipelines);
+  const uint32_t scope =
+      profiler.begin(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, hash.node);
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, hash.pipeline);
+  resources.push_constant.set_data(static_cast<uint64_t>(word));
   vkCmdPushConstants(command_buffer,
                      pipelines.compute.layout,
                      resources.push_constant.shader_stage,
                      resources.push_constant.offset,
                      resources.push_constant.size,
                      resources.push_constant.data.data());
+  vkCmdDispatch(command_buffer, hash.work_groups[0], hash.work_groups[1], hash.work_groups[2]);
+  profiler.end(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, scope);
+}
 
-  const CE::Runtime::RenderGraph *render_graph = CE::Runtime::get_render_graph();
-  const CE::Runtime::PipelineExecutionPlan *plan = CE::Runtime::get_pipeline_execution_plan();
-  std::vector<std::string> pre_compute;
-  if (render_graph) {
-    for (const CE::Runtime::RenderNode &node : render_graph->nodes) {
-      if (node.stage == CE::Runtime::RenderStage::PreCompute) {
-        pre_compute.push_back(node.pipeline);
-      }
+void CE::ShaderAccess::CommandResources::record_cell_cull(VkCommandBuffer command_buffer,
+                                                          VulkanResources &resources,
+                                                          Pipelines &pipelines,
+                                                          const uint32_t frame_index) {
+  const VkBuffer visible = resources.visible_cells.buffer.buffer;
+  const bool async = families_.async_compute();
+
+  // The list is rebuilt in place, after its last reader (vertex fetch and the indirect
+  // command on a shared queue, the render_cells copy with async compute) and after the
+  // steps above wrote the state it reads.
+  VkMemoryBarrier entry_barrier{};
+  entry_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  entry_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  entry_barrier.dstAccessMask =
+      VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           (async ? VK_PIPELINE_STAGE_TRANSFER_BIT
+                                  : VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT),
+                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       0,
+                       1,
+                       &entry_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+
+  // Both cell pipelines draw the same shapes, so one command per detail level serves both.
+  const World &world = resources.world;
+  VulkanResources::VisibleCellsBuffer::Head reset{};
+  reset.draws[0].vertexCount = static_cast<uint32_t>(world._cube.all_vertices.size());
+  reset.draws[1].vertexCount = static_cast<uint32_t>(world._cell_box.all_vertices.size());
+  reset.draws[2].vertexCount = static_cast<uint32_t>(world._cell_billboard.all_vertices.size());
+  vkCmdUpdateBuffer(command_buffer, visible, 0, sizeof(reset), &reset);
+
+  VkMemoryBarrier reset_barrier{};
+  reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       0,
+                       1,
+                       &reset_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+
+  // The set whose "in" side holds the newest state, which the last step did not bind.
+  const uint32_t uniform_offset = resources.uniform.offset(frame_index);
+  vkCmdBindDescriptorSets(command_buffer,
+                          VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipelines.compute.layout,
+                          0,
+                          1,
+                          &resources.descriptor_interface.sets[resources.latest_cell_buffer],
+                          1,
+                          &uniform_offset);
+  const DispatchCommand cull = resolve_dispatch("CellCull", pipelines);
+  const uint32_t scope =
+      profiler.begin(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, cull.node);
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull.pipeline);
+  // Pass 0 counts each detail level, pass 1 lays the levels out back to back and fills them.
+  // The high word tells the cull whether the box level is worth drawing at all.
+  const uint64_t box_lod = world.cell_box_lod() ? 1u : 0u;
+  for (uint32_t pass = 0; pass < 2; ++pass) {
+    if (pass > 0) {
+      VkMemoryBarrier count_barrier{};
+      count_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      count_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      count_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      vkCmdPipelineBarrier(command_buffer,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           0,
+                           1,
+                           &count_barrier,
+                           0,
+                           nullptr,
+                           0,
+                           nullptr);
     }
-  } else if (plan) {
-    pre_compute = plan->pre_graphics_compute;
+    resources.push_constant.set_data(static_cast<uint64_t>(pass) | (box_lod << 32));
+    vkCmdPushConstants(command_buffer,
+                       pipelines.compute.layout,
+                       resources.push_constant.shader_stage,
+                       resources.push_constant.offset,
+                       resources.push_constant.size,
+                       resources.push_constant.data.data());
+    vkCmdDispatch(command_buffer, cull.work_groups[0], cull.work_groups[1], cull.work_groups[2]);
   }
+  profiler.end(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, scope);
+
+  // Shared queue: graphics reads the list straight from here. Async compute: the
+  // render_cells copy does.
+  VkMemoryBarrier exit_barrier{};
+  exit_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  exit_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  exit_barrier.dstAccessMask = async ? VK_ACCESS_TRANSFER_READ_BIT
+                                     : VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                                           VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       async ? VK_PIPELINE_STAGE_TRANSFER_BIT
+                             : VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                                   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                       0,
+                       1,
+                       &exit_barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
 
-  const bool run_startup_seed = resources.startup_seed_pending;
-  if (run_startup_seed) {
-    pre_compute.insert(pre_compute.begin(), "SeedCells");
+void CE::ShaderAccess::CommandResources::record_render_cells_release(
+    VkCommandBuffer command_buffer, VulkanResources &resources, const uint32_t frame_index) const {
+  const VulkanResources::VisibleCellsBuffer &visible_cells = resources.visible_cells;
+  const VkBuffer snapshot = visible_cells.render_cells[frame_index].buffer;
+
+  // Copied every frame, stepped or not, so both slots always show the newest state. The
+  // instance count is only known on the GPU, so the whole list goes.
+  const VkBufferCopy region{.srcOffset = 0, .dstOffset = 0, .size = visible_cells.size};
+  vkCmdCopyBuffer(command_buffer, visible_cells.buffer.buffer, snapshot, 1, &region);
+
+  // Release half of the ownership transfer; graphics records the matching acquire. The
+  // reverse direction needs no transfer: the next copy overwrites the whole snapshot.
+  VkBufferMemoryBarrier release{};
+  release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  release.dstAccessMask = 0;
+  release.srcQueueFamilyIndex = families_.compute_family.value();
+  release.dstQueueFamilyIndex = families_.graphics_and_compute_family.value();
+  release.buffer = snapshot;
+  release.offset = 0;
+  release.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       0,
+                       0,
+                       nullptr,
+                       1,
+                       &release,
+                       0,
+                       nullptr);
+}
+
+void CE::ShaderAccess::CommandResources::record_render_cells_acquire(
+    VkCommandBuffer command_buffer, VulkanResources &resources, const uint32_t frame_index) const {
+  // Source stages match the compute timeline wait stages, so the acquire chains after them.
+  VkBufferMemoryBarrier acquire{};
+  acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  acquire.srcAccessMask = 0;
+  acquire.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+  acquire.srcQueueFamilyIndex = families_.compute_family.value();
+  acquire.dstQueueFamilyIndex = families_.graphics_and_compute_family.value();
+  acquire.buffer = resources.visible_cells.render_cells[frame_index].buffer;
+  acquire.offset = 0;
+  acquire.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                       0,
+                       0,
+                       nullptr,
+                       1,
+                       &acquire,
+                       0,
+                       nullptr);
+}
+
+std::vector<uint32_t> CE::ShaderAccess::CommandResources::jump_flood_steps(const uint32_t width,
+                                                                           const uint32_t height) {
+  // Halving steps from the largest power of two below the grid extent, then one extra
+  // unit step (JFA+1) to fix the few sites plain JFA misses.
+  std::vector<uint32_t> steps{};
+  const uint32_t extent = std::max({width, height, 2u});
+  for (uint32_t step = std::bit_floor(extent - 1); step > 0; step >>= 1) {
+    steps.push_back(step);
+  }
+  steps.push_back(1);
+  // Passes ping-pong between the two halves of the buffer; an even count ends in the half
+  // Engine.comp reads.
+  if (steps.size() % 2 != 0) {
+    steps.push_back(1);
   }
+  return steps;
+}
 
-  const auto insert_compute_barrier = [&](VkCommandBuffer buffer) {
+void CE::ShaderAccess::CommandResources::record_terrain_bake(VkCommandBuffer command_buffer,
+                                                             VulkanResources &resources,
+                                                             Pipelines &pipelines,
+                                                             const uint32_t frame_index) {
+  const auto insert_compute_barrier = [&]() {
     VkMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
     barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-    vkCmdPipelineBarrier(buffer,
+    vkCmdPipelineBarrier(command_buffer,
                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                          0,
@@ -80,25 +490,308 @@ void CE::ShaderAccess::CommandResources::record_compute_command_buffer(
                          nullptr);
   };
 
-  for (std::size_t i = 0; i < pre_compute.size(); ++i) {
-    const std::string &pipeline_name = pre_compute[i];
+  const auto dispatch = [&](const std::string &pipeline_name) {
+    const uint32_t scope =
+        profiler.begin(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, pipeline_name);
     vkCmdBindPipeline(command_buffer,
                       VK_PIPELINE_BIND_POINT_COMPUTE,
                       pipelines.config.get_pipeline_object_by_name(pipeline_name));
-
     const std::array<uint32_t, 3> &work_groups =
         pipelines.config.get_work_groups_by_name(pipeline_name);
     vkCmdDispatch(command_buffer, work_groups[0], work_groups[1], work_groups[2]);
-    if (i + 1 < pre_compute.size()) {
-      insert_compute_barrier(command_buffer);
+    profiler.end(command_buffer, BaseGpuProfiler::Queue::Compute, frame_index, scope);
+    insert_compute_barrier();
+  };
+
+  dispatch("TerrainBake");
+
+  // Height and normal per landscape mesh vertex, for the vertex shaders.
+  resources.push_constant.set_data(static_cast<uint64_t>(resources.terrain_surface.subdivisions));
+  vkCmdPushConstants(command_buffer,
+                     pipelines.compute.layout,
+                     resources.push_constant.shader_stage,
+                     resources.push_constant.offset,
+                     resources.push_constant.size,
+                     resources.push_constant.data.data());
+  dispatch("TerrainSurfaceBake");
+
+  const std::vector<uint32_t> steps =
+      jump_flood_steps(static_cast<uint32_t>(resources.world._grid.size.x),
+                       static_cast<uint32_t>(resources.world._grid.size.y));
+  for (uint32_t pass = 0; pass < steps.size(); ++pass) {
+    resources.push_constant.set_data(static_cast<uint64_t>(steps[pass]) |
+                                     (static_cast<uint64_t>(pass) << 32));
+    vkCmdPushConstants(command_buffer,
+                       pipelines.compute.layout,
+                       resources.push_constant.shader_stage,
+                       resources.push_constant.offset,
+                       resources.push_constant.size,
+                       resources.push_constant.data.data());
+    dispatch("TerrainJumpFlood");
+  }
+
+  Log::text("{ MAP }",
+            "Terrain bake",
+            "jump flood passes",
+            steps.size(),
+            "surface subdivisions",
+            resources.terrain_surface.subdivisions);
+}
+
+void CE::ShaderAccess::CommandResources::invalidate_recorded() {
+  this->compiled_.valid = false;
+  for (RecordedDraws &recorded : this->recorded_draws_) {
+    recorded.valid = false;
+  }
+}
+
+CE::ShaderAccess::CommandResources::DrawCommand
+CE::ShaderAccess::CommandResources::resolve_draw(const std::string &pipeline_name,
+                                                 CE::Runtime::DrawOpId draw_op,
+                                                 VulkanResources &resources,
+                                                 Pipelines &pipelines) {
+  if (draw_op == CE::Runtime::DrawOpId::Unknown) {
+    draw_op = CE::Runtime::get_graphics_draw_op_id(pipeline_name);
+  }
+  if (draw_op == CE::Runtime::DrawOpId::Unknown) {
+    const std::string *draw_op_name = CE::Runtime::get_graphics_draw_op(pipeline_name);
+    constexpr std::string_view indexed_prefix = "indexed:";
+    if (draw_op_name && draw_op_name->starts_with(indexed_prefix)) {
+      const std::string_view target = std::string_view(*draw_op_name).substr(indexed_prefix.size());
+      if (target == "grid") {
+        draw_op = CE::Runtime::DrawOpId::IndexedGrid;
+      } else if (target == "grid_box") {
+        draw_op = CE::Runtime::DrawOpId::IndexedGridBox;
+      } else if (target == "cube") {
+        draw_op = CE::Runtime::DrawOpId::IndexedCube;
+      } else {
+        draw_op = CE::Runtime::DrawOpId::IndexedRectangle;
+      }
     }
   }
 
-  if (run_startup_seed) {
-    resources.startup_seed_pending = false;
+  DrawCommand draw{.node = pipeline_name, .draw_op = draw_op};
+  if (draw_op == CE::Runtime::DrawOpId::Unknown) {
+    return draw;
   }
+  draw.pipeline = pipelines.config.get_pipeline_object_by_name(pipeline_name);
+
+  World &world = resources.world;
+  const auto indexed = [&draw](const VkBuffer vertex_buffer,
+                               const VkBuffer index_buffer,
+                               const size_t index_count) {
+    draw.vertex_buffer = vertex_buffer;
+    draw.index_buffer = index_buffer;
+    draw.count = static_cast<uint32_t>(index_count);
+  };
+  // Shapes without index data are drawn from their vertex list.
+  const auto shape = [&draw, &indexed](const auto &geometry) {
+    if (!geometry.indices.empty() && geometry.index_buffer.buffer != VK_NULL_HANDLE) {
+      indexed(geometry.vertex_buffer.buffer, geometry.index_buffer.buffer, geometry.indices.size());
+    } else {
+      draw.vertex_buffer = geometry.vertex_buffer.buffer;
+      draw.count = static_cast<uint32_t>(geometry.all_vertices.size());
+    }
+  };
 
-  CE::vulkan_result(vkEndCommandBuffer, command_buffer);
+  switch (draw_op) {
+  case CE::Runtime::DrawOpId::InstancedCells:
+    // Vertex and instance counts come from the indirect commands CellCull writes.
+    draw.vertex_buffer = world._cube.vertex_buffer.buffer;
+    draw.lod_vertex_buffers = {world._cube.vertex_buffer.buffer,
+                               world._cell_box.vertex_buffer.buffer,
+                               world._cell_billboard.vertex_buffer.buffer};
+    break;
+  case CE::Runtime::DrawOpId::IndexedGrid:
+    indexed(world._grid.vertex_buffer.buffer, world._grid.index_buffer.buffer, world._grid.indices.size());
+    break;
+  case CE::Runtime::DrawOpId::IndexedGridBox:
+    indexed(world._grid.box_vertex_buffer.buffer,
+            world._grid.box_index_buffer.buffer,
+            world._grid.box_indices.size());
+    break;
+  case CE::Runtime::DrawOpId::IndexedRectangle:
+    indexed(world._rectangle.vertex_buffer.buffer,
+            world._rectangle.index_buffer.buffer,
+            world._rectangle.indices.size());
+    break;
+  case CE::Runtime::DrawOpId::IndexedCube:
+    shape(world._cube);
+    break;
+  case CE::Runtime::DrawOpId::SkyDome:
+    shape(world._sky_dome);
+    break;
+  case CE::Runtime::DrawOpId::Unknown:
+    break;
+  }
+  return draw;
+}
+
+CE::ShaderAccess::CommandResources::DispatchCommand
+CE::ShaderAccess::CommandResources::resolve_dispatch(const std::string &pipeline_name,
+                                                     Pipelines &pipelines) {
+  return DispatchCommand{.node = pipeline_name,
+                         .pipeline = pipelines.config.get_pipeline_object_by_name(pipeline_name),
+                         .work_groups = pipelines.config.get_work_groups_by_name(pipeline_name)};
+}
+
+const CE::ShaderAccess::CommandResources::CompiledGraph &
+CE::ShaderAccess::CommandResources::compiled_graph(VulkanResources &resources,
+                                                   Pipelines &pipelines) {
+  const uint64_t revision = CE::Runtime::render_graph_revision();
+  if (this->compiled_.valid && this->compiled_.revision == revision) {
+    return this->compiled_;
+  }
+
+  CompiledGraph compiled{.valid = true, .revision = revision};
+  if (const CE::Runtime::RenderGraph *graph = CE::Runtime::get_render_graph()) {
+    for (const CE::Runtime::RenderNode &node : graph->nodes) {
+      switch (node.stage) {
+      case CE::Runtime::RenderStage::PreCompute:
+        compiled.pre_compute.push_back(resolve_dispatch(node.pipeline, pipelines));
+        break;
+      case CE::Runtime::RenderStage::Graphics:
+        compiled.draws.push_back(resolve_draw(node.pipeline, node.draw_op, resources, pipelines));
+        break;
+      case CE::Runtime::RenderStage::PostCompute:
+        compiled.post_compute.push_back(resolve_dispatch(node.pipeline, pipelines));
+        break;
+      }
+    }
+  } else if (const CE::Runtime::PipelineExecutionPlan *plan =
+                 CE::Runtime::get_pipeline_execution_plan()) {
+    for (const std::string &pipeline_name : plan->pre_graphics_compute) {
+      compiled.pre_compute.push_back(resolve_dispatch(pipeline_name, pipelines));
+    }
+    for (const std::string &pipeline_name : plan->graphics) {
+      compiled.draws.push_back(
+          resolve_draw(pipeline_name, CE::Runtime::DrawOpId::Unknown, resources, pipelines));
+    }
+    for (const std::string &pipeline_name : plan->post_graphics_compute) {
+      compiled.post_compute.push_back(resolve_dispatch(pipeline_name, pipelines));
+    }
+  }
+  std::erase_if(compiled.draws, [](const DrawCommand &draw) {
+    return draw.draw_op == CE::Runtime::DrawOpId::Unknown;
+  });
+
+  Log::text("{ cmd }",
+            "Render graph compiled",
+            "revision",
+            revision,
+            "pre-compute",
+            compiled.pre_compute.size(),
+            "draws",
+            compiled.draws.size(),
+            "post-compute",
+            compiled.post_compute.size());
+  this->compiled_ = std::move(compiled);
+  return this->compiled_;
+}
+
+const CE::ShaderAccess::CommandResources::DrawCommand &
+CE::ShaderAccess::CommandResources::draw_by_name(const std::string &pipeline_name,
+                                                 VulkanResources &resources,
+                                                 Pipelines &pipelines) {
+  auto it = this->compiled_.by_name.find(pipeline_name);
+  if (it == this->compiled_.by_name.end()) {
+    it = this->compiled_.by_name
+             .emplace(pipeline_name,
+                      resolve_draw(pipeline_name, CE::Runtime::DrawOpId::Unknown, resources, pipelines))
+             .first;
+  }
+  return it->second;
+}
+
+void CE::ShaderAccess::CommandResources::record_draw(VkCommandBuffer command_buffer,
+                                                     const DrawCommand &draw,
+                                                     const VkBuffer cells) {
+  if (draw.draw_op == CE::Runtime::DrawOpId::Unknown) {
+    return;
+  }
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+
+  if (draw.draw_op == CE::Runtime::DrawOpId::InstancedCells) {
+    const VkDeviceSize instances_offset = VulkanResources::VisibleCellsBuffer::instances_offset;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &cells, &instances_offset);
+    // Only alive, on-screen cells, one draw per detail level: CellCull wrote each level's
+    // count and first entry into the list's head.
+    for (uint32_t lod = 0; lod < World::cell_lod_count; ++lod) {
+      const VkDeviceSize shape_offset = 0;
+      vkCmdBindVertexBuffers(command_buffer, 1, 1, &draw.lod_vertex_buffers[lod], &shape_offset);
+      vkCmdDrawIndirect(command_buffer,
+                        cells,
+                        lod * sizeof(VkDrawIndirectCommand),
+                        1,
+                        sizeof(VkDrawIndirectCommand));
+    }
+    return;
+  }
+
+  const VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &draw.vertex_buffer, &offset);
+  if (draw.index_buffer != VK_NULL_HANDLE) {
+    vkCmdBindIndexBuffer(command_buffer, draw.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(command_buffer, draw.count, draw.instances, 0, 0, 0);
+  } else {
+    vkCmdDraw(command_buffer, draw.count, draw.instances, 0, 0);
+  }
+}
+
+VkCommandBuffer CE::ShaderAccess::CommandResources::recorded_draws(CE::BaseSwapchain &swapchain,
+                                                                  VulkanResources &resources,
+                                                                  Pipelines &pipelines,
+                                                                  const uint32_t frame_index,
+                                                                  const VkBuffer cells) {
+  const CompiledGraph &graph = compiled_graph(resources, pipelines);
+  RecordedDraws &recorded = this->recorded_draws_[frame_index];
+  if (recorded.valid && recorded.revision == graph.revision && recorded.cells == cells &&
+      recorded.extent.width == swapchain.extent.width &&
+      recorded.extent.height == swapchain.extent.height) {
+    return recorded.command_buffer;
+  }
+
+  // Any framebuffer of the render pass: nothing recorded here depends on the image.
+  VkCommandBufferInheritanceInfo inheritanceInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+      .renderPass = pipelines.render.render_pass,
+      .subpass = 0,
+      .framebuffer = VK_NULL_HANDLE};
+  VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+      .pInheritanceInfo = &inheritanceInfo};
+  CE::vulkan_result(vkBeginCommandBuffer, recorded.command_buffer, &beginInfo);
+
+  const VkViewport viewport{.x = 0.0f,
+                            .y = 0.0f,
+                            .width = static_cast<float>(swapchain.extent.width),
+                            .height = static_cast<float>(swapchain.extent.height),
+                            .minDepth = 0.0f,
+                            .maxDepth = 1.0f};
+  const VkRect2D scissor{.offset = {0, 0}, .extent = swapchain.extent};
+  vkCmdSetViewport(recorded.command_buffer, 0, 1, &viewport);
+  vkCmdSetScissor(recorded.command_buffer, 0, 1, &scissor);
+  // The slot's uniform offset never changes, so it can be recorded once with the draws.
+  const uint32_t uniform_offset = resources.uniform.offset(frame_index);
+  vkCmdBindDescriptorSets(recorded.command_buffer,
+                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          pipelines.graphics.layout,
+                          0,
+                          1,
+                          &resources.descriptor_interface.sets[frame_index % MAX_FRAMES_IN_FLIGHT],
+                          1,
+                          &uniform_offset);
+  for (const DrawCommand &draw : graph.draws) {
+    record_draw(recorded.command_buffer, draw, cells);
+  }
+  CE::vulkan_result(vkEndCommandBuffer, recorded.command_buffer);
+
+  recorded.valid = true;
+  recorded.revision = graph.revision;
+  recorded.cells = cells;
+  recorded.extent = swapchain.extent;
+  return recorded.command_buffer;
 }
 
 void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
@@ -117,6 +810,37 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
 
   CE::vulkan_result(vkBeginCommandBuffer, command_buffer, &begin_info);
 
+  // Frame slots can outnumber descriptor sets (CE_FRAMES_IN_FLIGHT > 2).
+  const uint32_t set_index = frame_index % MAX_FRAMES_IN_FLIGHT;
+  const uint32_t uniform_offset = resources.uniform.offset(frame_index);
+
+  if (families_.async_compute()) {
+    record_render_cells_acquire(command_buffer, resources, frame_index);
+  }
+
+  // Visible cells of the newest state, culled by this frame's compute submission; with
+  // async compute, the copy of them it handed over.
+  VkBuffer cells = resources.visible_cells.buffer.buffer;
+  if (families_.async_compute()) {
+    cells = resources.visible_cells.render_cells[frame_index].buffer;
+  }
+
+  const CompiledGraph &graph = compiled_graph(resources, pipelines);
+
+  const bool stage_strip_potentially_enabled = CE::RenderGUI::is_stage_strip_enabled();
+  bool stage_strip_enabled = false;
+  CE::RenderGUI::StageStripConfig stage_strip{};
+
+  if (stage_strip_potentially_enabled) {
+    stage_strip = CE::RenderGUI::get_stage_strip_config(swapchain.extent);
+    stage_strip_enabled =
+        stage_strip.enabled && swapchain.extent.height > (stage_strip.strip_height_px + 1);
+  }
+
+  // The graph's draws replay from a recorded secondary unless something needs inline
+  // commands in the same subpass: per-node timestamps, or the stage-strip tiles.
+  const bool replay_draws = !profiler.enabled() && !stage_strip_enabled;
+
   std::array<VkClearValue, 2> clear_values{
       VkClearValue{.color = {{0.46f, 0.55f, 0.62f, 1.0f}}},
       VkClearValue{.depthStencil = {1.0f, 0}}};
@@ -130,266 +854,45 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
       .clearValueCount = static_cast<uint32_t>(clear_values.size()),
       .pClearValues = clear_values.data()};
 
-  vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
   VkViewport viewport{.x = 0.0f,
                       .y = 0.0f,
                       .width = static_cast<float>(swapchain.extent.width),
                       .height = static_cast<float>(swapchain.extent.height),
                       .minDepth = 0.0f,
                       .maxDepth = 1.0f};
-  vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-
   VkRect2D scissor{.offset = {0, 0}, .extent = swapchain.extent};
-  const bool stage_strip_potentially_enabled = CE::RenderGUI::is_stage_strip_enabled();
-  bool stage_strip_enabled = false;
-  CE::RenderGUI::StageStripConfig stage_strip{};
-
-  if (stage_strip_potentially_enabled) {
-    stage_strip = CE::RenderGUI::get_stage_strip_config(swapchain.extent);
-    stage_strip_enabled =
-        stage_strip.enabled && swapchain.extent.height > (stage_strip.strip_height_px + 1);
-  }
 
-  if (stage_strip_enabled) {
-    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+  if (replay_draws) {
+    const VkCommandBuffer draws =
+        recorded_draws(swapchain, resources, pipelines, frame_index, cells);
+    vkCmdBeginRenderPass(
+        command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(command_buffer, 1, &draws);
   } else {
+    vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
-  }
-
-  vkCmdBindDescriptorSets(command_buffer,
-                          VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          pipelines.graphics.layout,
-                          0,
-                          1,
-                          &resources.descriptor_interface.sets[frame_index],
-                          0,
-                          nullptr);
-
-  std::unordered_map<std::string, VkPipeline> graphics_pipeline_cache{};
-  std::unordered_map<std::string, CE::Runtime::DrawOpId> graphics_draw_op_cache{};
-
-  const auto resolve_pipeline = [&](const std::string &pipeline_name) -> VkPipeline {
-    const auto it = graphics_pipeline_cache.find(pipeline_name);
-    if (it != graphics_pipeline_cache.end()) {
-      return it->second;
-    }
-
-    const VkPipeline pipeline = pipelines.config.get_pipeline_object_by_name(pipeline_name);
-    graphics_pipeline_cache.emplace(pipeline_name, pipeline);
-    return pipeline;
-  };
-
-  const auto resolve_draw_op_id = [&](const std::string &pipeline_name)
-      -> CE::Runtime::DrawOpId {
-    const auto cached = graphics_draw_op_cache.find(pipeline_name);
-    if (cached != graphics_draw_op_cache.end()) {
-      return cached->second;
-    }
-
-    CE::Runtime::DrawOpId draw_op_id = CE::Runtime::get_graphics_draw_op_id(pipeline_name);
-    if (draw_op_id == CE::Runtime::DrawOpId::Unknown) {
-      const std::string *draw_op = CE::Runtime::get_graphics_draw_op(pipeline_name);
-      if (draw_op) {
-        draw_op_id = CE::Runtime::draw_op_from_string(*draw_op);
-        if (draw_op_id == CE::Runtime::DrawOpId::Unknown) {
-          constexpr std::string_view indexed_prefix = "indexed:";
-          if (draw_op->starts_with(indexed_prefix)) {
-            const std::string_view target =
-                std::string_view(*draw_op).substr(indexed_prefix.size());
-            if (target == "grid") {
-              draw_op_id = CE::Runtime::DrawOpId::IndexedGrid;
-            } else if (target == "grid_box") {
-              draw_op_id = CE::Runtime::DrawOpId::IndexedGridBox;
-            } else if (target == "cube") {
-              draw_op_id = CE::Runtime::DrawOpId::IndexedCube;
-            } else {
-              draw_op_id = CE::Runtime::DrawOpId::IndexedRectangle;
-            }
-          }
-        }
-      }
-    }
-
-    graphics_draw_op_cache.emplace(pipeline_name, draw_op_id);
-    return draw_op_id;
-  };
-
-  const auto bind_and_draw_indexed = [&](VkPipeline pipeline,
-                                         VkBuffer vertex_buffer,
-                                         VkBuffer index_buffer,
-                                         uint32_t index_count) {
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-    VkBuffer vertex_buffers[] = {vertex_buffer};
-    VkDeviceSize indexed_offsets[] = {0};
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, indexed_offsets);
-    vkCmdBindIndexBuffer(command_buffer, index_buffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(command_buffer, index_count, 1, 0, 0, 0);
-  };
-
-  const auto draw_cells = [&](VkPipeline pipeline) {
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-    VkDeviceSize offsets_0[]{0, 0};
-
-    VkBuffer current_shader_storage_buffer[] = {resources.shader_storage.buffer_out.buffer,
-                          resources.shader_storage.buffer_in.buffer};
-
-    VkBuffer vertex_buffers_0[] = {current_shader_storage_buffer[frame_index],
-                                   resources.world._cube.vertex_buffer.buffer};
-
-    vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers_0, offsets_0);
-    vkCmdDraw(command_buffer,
-              static_cast<uint32_t>(resources.world._cube.all_vertices.size()),
-              resources.world._grid.size.x * resources.world._grid.size.y,
-              0,
-              0);
-  };
-
-  const auto draw_grid_indexed = [&](VkPipeline pipeline) {
-    bind_and_draw_indexed(pipeline,
-                          resources.world._grid.vertex_buffer.buffer,
-                          resources.world._grid.index_buffer.buffer,
-                          static_cast<uint32_t>(resources.world._grid.indices.size()));
-  };
-
-  const auto draw_grid_box_indexed = [&](VkPipeline pipeline) {
-    bind_and_draw_indexed(pipeline,
-                          resources.world._grid.box_vertex_buffer.buffer,
-                          resources.world._grid.box_index_buffer.buffer,
-                          static_cast<uint32_t>(resources.world._grid.box_indices.size()));
-  };
-
-  const auto draw_rectangle_indexed = [&](VkPipeline pipeline) {
-    bind_and_draw_indexed(pipeline,
-                          resources.world._rectangle.vertex_buffer.buffer,
-                          resources.world._rectangle.index_buffer.buffer,
-                          static_cast<uint32_t>(resources.world._rectangle.indices.size()));
-  };
-
-  const auto draw_cube_indexed = [&](VkPipeline pipeline) {
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-    VkBuffer vertex_buffers[] = {resources.world._cube.vertex_buffer.buffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
-
-    const bool has_index_data = !resources.world._cube.indices.empty() &&
-                                resources.world._cube.index_buffer.buffer != VK_NULL_HANDLE;
-    if (has_index_data) {
-      vkCmdBindIndexBuffer(command_buffer,
-                           resources.world._cube.index_buffer.buffer,
-                           0,
-                           VK_INDEX_TYPE_UINT32);
-      vkCmdDrawIndexed(command_buffer,
-                       static_cast<uint32_t>(resources.world._cube.indices.size()),
-                       1,
-                       0,
-                       0,
-                       0);
-      return;
-    }
-
-    vkCmdDraw(command_buffer,
-              static_cast<uint32_t>(resources.world._cube.all_vertices.size()),
-              1,
-              0,
-              0);
-  };
-
-  const auto draw_sky_dome = [&](VkPipeline pipeline) {
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-    VkBuffer vertex_buffers[] = {resources.world._sky_dome.vertex_buffer.buffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
-
-    const bool has_index_data = !resources.world._sky_dome.indices.empty() &&
-                                resources.world._sky_dome.index_buffer.buffer != VK_NULL_HANDLE;
-    if (has_index_data) {
-      vkCmdBindIndexBuffer(command_buffer,
-                           resources.world._sky_dome.index_buffer.buffer,
-                           0,
-                           VK_INDEX_TYPE_UINT32);
-      vkCmdDrawIndexed(command_buffer,
-                       static_cast<uint32_t>(resources.world._sky_dome.indices.size()),
-                       1,
-                       0,
-                       0,
-                       0);
-      return;
-    }
-
-    vkCmdDraw(command_buffer,
-              static_cast<uint32_t>(resources.world._sky_dome.all_vertices.size()),
-              1,
-              0,
-              0);
-  };
-
-  const auto draw_pipeline_from_draw_op_id = [&](VkPipeline pipeline,
-                                                 CE::Runtime::DrawOpId draw_op_id) {
-    if (draw_op_id == CE::Runtime::DrawOpId::InstancedCells) {
-      draw_cells(pipeline);
-      return;
-    }
-
-    if (draw_op_id == CE::Runtime::DrawOpId::IndexedGrid) {
-      draw_grid_indexed(pipeline);
-      return;
-    }
-
-    if (draw_op_id == CE::Runtime::DrawOpId::IndexedGridBox) {
-      draw_grid_box_indexed(pipeline);
-      return;
-    }
-
-    if (draw_op_id == CE::Runtime::DrawOpId::IndexedRectangle) {
-      draw_rectangle_indexed(pipeline);
-      return;
-    }
-
-    if (draw_op_id == CE::Runtime::DrawOpId::IndexedCube) {
-      draw_cube_indexed(pipeline);
-      return;
-    }
-
-    if (draw_op_id == CE::Runtime::DrawOpId::SkyDome) {
-      draw_sky_dome(pipeline);
-      return;
-    }
-  };
-
-  const auto draw_pipeline_by_name = [&](const std::string &pipeline_name) {
-    const CE::Runtime::DrawOpId draw_op_id = resolve_draw_op_id(pipeline_name);
-    if (draw_op_id != CE::Runtime::DrawOpId::Unknown) {
-      const VkPipeline pipeline = resolve_pipeline(pipeline_name);
-      draw_pipeline_from_draw_op_id(pipeline, draw_op_id);
-    }
-  };
+    vkCmdBindDescriptorSets(command_buffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipelines.graphics.layout,
+                            0,
+                            1,
+                            &resources.descriptor_interface.sets[set_index],
+                            1,
+                            &uniform_offset);
 
-  const CE::Runtime::PipelineExecutionPlan *legacy_plan =
-      CE::Runtime::get_pipeline_execution_plan();
-  const CE::Runtime::RenderGraph *graphics_render_graph = CE::Runtime::get_render_graph();
-  if (graphics_render_graph) {
-    for (const CE::Runtime::RenderNode &node : graphics_render_graph->nodes) {
-      if (node.stage != CE::Runtime::RenderStage::Graphics) {
-        continue;
-      }
-      if (node.draw_op != CE::Runtime::DrawOpId::Unknown) {
-        const VkPipeline pipeline = resolve_pipeline(node.pipeline);
-        draw_pipeline_from_draw_op_id(pipeline, node.draw_op);
-      } else {
-        draw_pipeline_by_name(node.pipeline);
-      }
-    }
-  } else {
-    if (legacy_plan) {
-      for (const std::string &pipeline_name : legacy_plan->graphics) {
-        draw_pipeline_by_name(pipeline_name);
-      }
+    for (const DrawCommand &draw : graph.draws) {
+      const uint32_t scope =
+          profiler.begin(command_buffer, BaseGpuProfiler::Queue::Graphics, frame_index, draw.node);
+      record_draw(command_buffer, draw, cells);
+      profiler.end(command_buffer, BaseGpuProfiler::Queue::Graphics, frame_index, scope);
     }
   }
 
   if (stage_strip_enabled) {
+    const auto draw_pipeline_by_name = [&](const std::string &pipeline_name) {
+      record_draw(command_buffer, draw_by_name(pipeline_name, resources, pipelines), cells);
+    };
     const bool strip_live_lightweight =
       !CE::Runtime::env_flag_enabled("CE_RENDER_STAGE_STRIP_FULL");
     const std::vector<CE::RenderGUI::StageStripTile> &strip_tiles =
@@ -404,6 +907,8 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
 
       // Store original viewport for restoration
       const VkViewport original_viewport = viewport;
+      const uint32_t strip_scope = profiler.begin(
+          command_buffer, BaseGpuProfiler::Queue::Graphics, frame_index, "stage strip");
 
       for (uint32_t tile_idx = 0; tile_idx < tile_count; ++tile_idx) {
         const CE::RenderGUI::StageStripTile &tile_config = strip_tiles[tile_idx];
@@ -485,6 +990,7 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
         }
       }
 
+      profiler.end(command_buffer, BaseGpuProfiler::Queue::Graphics, frame_index, strip_scope);
       vkCmdSetViewport(command_buffer, 0, 1, &original_viewport);
       vkCmdSetScissor(command_buffer, 0, 1, &scissor);
     }
@@ -495,23 +1001,10 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
   //       This is part of an image memory barrier (i.e., vkCmdPipelineBarrier
   //       with the VkImageMemoryBarrier parameter set)
 
-  std::vector<std::string> post_compute;
-  if (graphics_render_graph) {
-    for (const CE::Runtime::RenderNode &node : graphics_render_graph->nodes) {
-      if (node.stage == CE::Runtime::RenderStage::PostCompute) {
-        post_compute.push_back(node.pipeline);
-      }
-    }
-  } else {
-    if (legacy_plan) {
-      post_compute = legacy_plan->post_graphics_compute;
-    }
-  }
-
-  if (!post_compute.empty()) {
+  if (!graph.post_compute.empty()) {
     swapchain.images[image_index].transition_layout(command_buffer,
                                                     swapchain.image_format,
-                                                    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                                    swapchain.present_layout,
                                                     /* -> */ VK_IMAGE_LAYOUT_GENERAL);
 
     vkCmdBindDescriptorSets(command_buffer,
@@ -519,9 +1012,9 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
                             pipelines.compute.layout,
                             0,
                             1,
-                            &resources.descriptor_interface.sets[frame_index],
-                            0,
-                            nullptr);
+                            &resources.descriptor_interface.sets[set_index],
+                            1,
+                            &uniform_offset);
 
     resources.push_constant.set_data(
       static_cast<uint32_t>(resources.world._time.passed_hours),
@@ -550,15 +1043,17 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
                            nullptr);
     };
 
-    for (std::size_t i = 0; i < post_compute.size(); ++i) {
-      const std::string &pipeline_name = post_compute[i];
-      vkCmdBindPipeline(command_buffer,
-                        VK_PIPELINE_BIND_POINT_COMPUTE,
-                        pipelines.config.get_pipeline_object_by_name(pipeline_name));
-      const std::array<uint32_t, 3> &work_groups =
-          pipelines.config.get_work_groups_by_name(pipeline_name);
-      vkCmdDispatch(command_buffer, work_groups[0], work_groups[1], work_groups[2]);
-      if (i + 1 < post_compute.size()) {
+    for (std::size_t i = 0; i < graph.post_compute.size(); ++i) {
+      const DispatchCommand &command = graph.post_compute[i];
+      const uint32_t scope =
+          profiler.begin(command_buffer, BaseGpuProfiler::Queue::Graphics, frame_index, command.node);
+      vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, command.pipeline);
+      vkCmdDispatch(command_buffer,
+                    command.work_groups[0],
+                    command.work_groups[1],
+                    command.work_groups[2]);
+      profiler.end(command_buffer, BaseGpuProfiler::Queue::Graphics, frame_index, scope);
+      if (i + 1 < graph.post_compute.size()) {
         insert_compute_barrier(command_buffer);
       }
     }
@@ -566,8 +1061,15 @@ void CE::ShaderAccess::CommandResources::record_graphics_command_buffer(
     swapchain.images[image_index].transition_layout(command_buffer,
                                                     swapchain.image_format,
                                                     VK_IMAGE_LAYOUT_GENERAL,
-                                                    /* -> */ VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+                                                    /* -> */ swapchain.present_layout);
   }
 
+  screenshots.record(command_buffer,
+                     frame_index,
+                     swapchain.images[image_index].image,
+                     swapchain.extent,
+                     swapchain.image_format,
+                     swapchain.present_layout);
+
   CE::vulkan_result(vkEndCommandBuffer, command_buffer);
 }
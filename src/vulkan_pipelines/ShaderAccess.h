@@ -2,7 +2,18 @@
 
 // Command recording entry points for shader-driven passes.
 // Exists to keep graphics/compute command encoding close to pipeline intent.
+#include "library/Checkpoint.h"
+#include "library/DeltaStream.h"
+#include "library/Screenshot.h"
+#include "library/StepHashes.h"
+#include "vulkan_base/VulkanBaseProfiler.h"
 #include "vulkan_base/VulkanBaseSync.h"
+#include "world/RuntimeConfig.h"
+#include "world/World.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace CE {
 
@@ -18,6 +29,118 @@ public:
                                         Pipelines &pipelines,
                                         const uint32_t frame_index,
                                         const uint32_t image_index) override;
+    // Drops the compiled graph and recorded draw lists; call when pipelines, work groups,
+    // descriptor sets or the framebuffer extent change.
+    void invalidate_recorded();
+
+    // GPU time per render-graph node; idle unless CE_GPU_PROFILE is set.
+    CE::BaseGpuProfiler profiler{};
+    // Screenshot readback ring, filled at the end of the frames it captures.
+    CE::Screenshot screenshots{};
+    // Cell state readback, appended to the compute submission a checkpoint is due in.
+    CE::Checkpoint checkpoints{};
+    // Per-step changed cells, compacted after every Engine step while CE_DELTA_STREAM is set.
+    CE::DeltaStream deltas{};
+    // Hash of the cell state after SeedCells and every step while CE_VERIFY_HASHES is set.
+    CE::StepHashes hashes{};
+
+  private:
+    CE::BaseQueues::FamilyIndices families_{};
+
+    // One graphics node with its pipeline and geometry resolved. Cell draws take their
+    // instance buffer at record time and their counts from its indirect commands, one per
+    // detail level.
+    struct DrawCommand {
+      std::string node{};
+      VkPipeline pipeline{VK_NULL_HANDLE};
+      CE::Runtime::DrawOpId draw_op{CE::Runtime::DrawOpId::Unknown};
+      VkBuffer vertex_buffer{VK_NULL_HANDLE};
+      std::array<VkBuffer, World::cell_lod_count> lod_vertex_buffers{};
+      VkBuffer index_buffer{VK_NULL_HANDLE};
+      // Index count when index_buffer is set, vertex count otherwise.
+      uint32_t count{0};
+      uint32_t instances{1};
+    };
+    struct DispatchCommand {
+      std::string node{};
+      VkPipeline pipeline{VK_NULL_HANDLE};
+      std::array<uint32_t, 3> work_groups{};
+    };
+    // The render graph (or legacy plan) flattened for recording; rebuilt only when
+    // CE::Runtime::render_graph_revision() moves or invalidate_recorded() is called.
+    struct CompiledGraph {
+      bool valid{false};
+      uint64_t revision{0};
+      std::vector<DispatchCommand> pre_compute{};
+      std::vector<DrawCommand> draws{};
+      std::vector<DispatchCommand> post_compute{};
+      // Stage-strip tiles name pipelines outside the graph; resolved on first use.
+      std::unordered_map<std::string, DrawCommand> by_name{};
+    };
+    // Secondary command buffer holding the graph's draws for one frame slot, re-recorded
+    // only when what it captured changes.
+    struct RecordedDraws {
+      VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+      bool valid{false};
+      uint64_t revision{0};
+      VkBuffer cells{VK_NULL_HANDLE};
+      VkExtent2D extent{};
+    };
+
+    CompiledGraph compiled_{};
+    std::array<RecordedDraws, MAX_FRAME_LATENCY> recorded_draws_{};
+
+    const CompiledGraph &compiled_graph(VulkanResources &resources, Pipelines &pipelines);
+    static DrawCommand resolve_draw(const std::string &pipeline_name,
+                                    CE::Runtime::DrawOpId draw_op,
+                                    VulkanResources &resources,
+                                    Pipelines &pipelines);
+    static DispatchCommand resolve_dispatch(const std::string &pipeline_name,
+                                            Pipelines &pipelines);
+    const DrawCommand &draw_by_name(const std::string &pipeline_name,
+                                    VulkanResources &resources,
+                                    Pipelines &pipelines);
+    static void record_draw(VkCommandBuffer command_buffer,
+                            const DrawCommand &draw,
+                            const VkBuffer cells);
+    VkCommandBuffer recorded_draws(CE::BaseSwapchain &swapchain,
+                                   VulkanResources &resources,
+                                   Pipelines &pipelines,
+                                   const uint32_t frame_index,
+                                   const VkBuffer cells);
+
+    static std::vector<uint32_t> jump_flood_steps(uint32_t width, uint32_t height);
+    // Compacts alive, on-screen cells of the newest state into VisibleCellsBuffer and its
+    // indirect draw command.
+    void record_cell_cull(VkCommandBuffer command_buffer,
+                          VulkanResources &resources,
+                          Pipelines &pipelines,
+                          const uint32_t frame_index);
+    // Compacts the cells the step just written changed into this frame's delta log slot;
+    // the step's descriptor set must still be bound.
+    void record_cell_delta(VkCommandBuffer command_buffer,
+                           VulkanResources &resources,
+                           Pipelines &pipelines,
+                           const uint32_t frame_index,
+                           const uint32_t step);
+    // Folds the state the bound set's "out" side holds into this frame's hash of hour.
+    void record_cell_hash(VkCommandBuffer command_buffer,
+                          VulkanResources &resources,
+                          Pipelines &pipelines,
+                          const uint32_t frame_index,
+                          const uint64_t hour);
+    // Async compute: copies the visible cell list into this frame's render_cells and
+    // releases it to the graphics family.
+    void record_render_cells_release(VkCommandBuffer command_buffer,
+                                     VulkanResources &resources,
+                                     const uint32_t frame_index) const;
+    void record_render_cells_acquire(VkCommandBuffer command_buffer,
+                                     VulkanResources &resources,
+                                     const uint32_t frame_index) const;
+    void record_terrain_bake(VkCommandBuffer command_buffer,
+                             VulkanResources &resources,
+                             Pipelines &pipelines,
+                             const uint32_t frame_index);
   };
 };
 } // namespace CE
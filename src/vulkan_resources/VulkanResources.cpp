@@ -3,20 +3,16 @@
 #include "library/Library.h"
 #include "engine/Log.h"
 #include "vulkan_mechanics/Mechanics.h"
+#include "vulkan_base/VulkanBaseUtils.h"
 #include "VulkanResources.h"
 
 VulkanResources::VulkanResources(VulkanMechanics &mechanics, const CE::Runtime::TerrainSettings &terrain_settings)
   : commands{mechanics.queues.indices},
-      command_interface{
-          commands.singular_command_buffer,
-          commands.pool,
-          mechanics.queues.graphics_queue},
+      uploader{mechanics.queues.indices.graphics_and_compute_family.value(),
+               mechanics.queues.graphics_queue},
 
       push_constant{VK_SHADER_STAGE_COMPUTE_BIT, 8, 0},
-      world{commands.singular_command_buffer,
-        commands.pool,
-        mechanics.queues.graphics_queue,
-        terrain_settings},
+      world{uploader, terrain_settings},
 
       descriptor_interface(),
 
@@ -28,18 +24,61 @@ VulkanResources::VulkanResources(VulkanMechanics &mechanics, const CE::Runtime::
                 mechanics.swapchain.extent,
             mechanics.swapchain.image_format},
 
-        uniform{descriptor_interface, world._ubo}, shader_storage{descriptor_interface,
-                                    command_interface,
+        uniform{descriptor_interface,
+                world._ubo,
+                mechanics.queues.indices,
+                mechanics.sync_objects.frames_in_flight},
+        shader_storage{descriptor_interface,
+                                    uploader,
+                                    mechanics.queues.indices,
+                                    commands.checkpoints,
                                     world._grid.cells,
-                                      world._grid.point_count},
-        sampler{descriptor_interface, command_interface, Lib::path("assets/Avatar.PNG")},
-        storage_image{descriptor_interface, mechanics.swapchain.images} {
+                                      world._grid.point_count,
+                                      static_cast<uint32_t>(world._grid.size.x)},
+        sampler{descriptor_interface, uploader, Lib::path("assets/Avatar.PNG")},
+        storage_image{descriptor_interface, mechanics.swapchain.images},
+        terrain_field{descriptor_interface, world._grid.point_count},
+        conway_bits{descriptor_interface, world._grid.size},
+        visible_cells{descriptor_interface,
+                      mechanics.queues.indices,
+                      mechanics.sync_objects.frames_in_flight,
+                      world._grid.point_count},
+        terrain_surface{descriptor_interface,
+                        mechanics.queues.indices,
+                        world._grid.size,
+                        static_cast<uint32_t>(
+                            std::max(terrain_settings.terrain_render_subdivisions, 1))},
+        cell_deltas{descriptor_interface,
+                    mechanics.sync_objects.frames_in_flight,
+                    world._grid.size,
+                    commands.deltas.capacity(world._grid.point_count)},
+        cell_hashes{descriptor_interface,
+                    mechanics.sync_objects.frames_in_flight,
+                    commands.hashes.enabled()} {
   Log::text(Log::Style::header_guard);
   Log::text("{ /// }", "constructing VulkanResources (start)");
   Log::text(Log::Style::header_guard);
   Log::text("{ /// }", "constructing VulkanResources");
 
   descriptor_interface.initialize_sets();
+
+  // Cells restored from a checkpoint resume at its hour with its parameters; the streams are
+  // already staged, so the run never seeds.
+  if (const CE::Checkpoint::Header *restored = commands.checkpoints.restored()) {
+    startup_seed_pending = false;
+    world._time.restore(restored->passed_hours, restored->hour_accumulator);
+    world._ubo.light = restored->parameters.light;
+    world._ubo.water_threshold = restored->parameters.water_threshold;
+    world._ubo.water_rules = restored->parameters.water_rules;
+  }
+
+  // Every startup transfer (meshes, cell streams, texture) goes out as one submission. Frames
+  // are queued behind it on the same queue, so nothing has to wait for it here.
+  uploader.flush();
+  if (mechanics.queues.indices.async_compute()) {
+    // ...except the first Engine step, which runs on the compute queue.
+    uploader.wait_idle();
+  }
 }
 
 VulkanResources::~VulkanResources() {
@@ -47,19 +86,39 @@ VulkanResources::~VulkanResources() {
 }
 
 CE::ShaderAccess::CommandResources::CommandResources(
-    const CE::BaseQueues::FamilyIndices &family_indices) {
+    const CE::BaseQueues::FamilyIndices &family_indices)
+    : families_(family_indices) {
   create_pool(family_indices);
-  create_buffers(graphics);
-  create_buffers(compute);
+  create_buffers(graphics, pool);
+  create_buffers(compute, compute_pool);
+
+  std::array<VkCommandBuffer, MAX_FRAME_LATENCY> secondaries{};
+  VkCommandBufferAllocateInfo allocateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                           .commandPool = pool,
+                                           .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                                           .commandBufferCount =
+                                               static_cast<uint32_t>(secondaries.size())};
+  CE::vulkan_result(vkAllocateCommandBuffers,
+                    CE::BaseDevice::base_device->logical_device,
+                    &allocateInfo,
+                    secondaries.data());
+  for (size_t i = 0; i < secondaries.size(); ++i) {
+    recorded_draws_[i].command_buffer = secondaries[i];
+  }
+
+  profiler.create(family_indices);
 }
 
 VulkanResources::UniformBuffer::UniformBuffer(CE::BaseDescriptorInterface &interface,
-                                        World::UniformBufferObject &u)
-    : ubo(u) {
+                                        World::UniformBufferObject &u,
+                                        const CE::BaseQueues::FamilyIndices &families,
+                                        const uint32_t frames_in_flight)
+    : ubo(u), copies(frames_in_flight) {
   my_index = interface.write_index;
   interface.write_index++;
 
-  VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  // Dynamic, so both sets select the frame slot's copy at bind time.
+  VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
   set_layout_binding.binding = 0;
   set_layout_binding.descriptorType = type;
   set_layout_binding.descriptorCount = 1;
@@ -72,27 +131,35 @@ VulkanResources::UniformBuffer::UniformBuffer(CE::BaseDescriptorInterface &inter
   pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
   interface.pool_sizes.push_back(pool_size);
 
-  create_buffer();
+  create_buffer(families);
 
   create_descriptor_write(interface);
 }
 
-void VulkanResources::UniformBuffer::create_buffer() {
-  Log::text("{ 101 }", MAX_FRAMES_IN_FLIGHT, "Uniform Buffers");
-  VkDeviceSize bufferSize = sizeof(World::UniformBufferObject);
-
+void VulkanResources::UniformBuffer::create_buffer(const CE::BaseQueues::FamilyIndices &families) {
+  const VkDeviceSize alignment =
+      CE::BaseDevice::base_device->properties().limits.minUniformBufferOffsetAlignment;
+  stride = sizeof(World::UniformBufferObject);
+  if (alignment > 1) {
+    stride = (stride + alignment - 1) / alignment * alignment;
+  }
+  Log::text("{ 101 }", copies, "Uniform Buffer copies of", stride, "bytes");
+  VkDeviceSize bufferSize = stride * copies;
+
+  // Read by the Engine step on the compute queue and by the draws on the graphics queue.
+  std::vector<uint32_t> shared_families{};
+  if (families.async_compute()) {
+    shared_families = {families.graphics_and_compute_family.value(),
+                       families.compute_family.value()};
+  }
   CE::BaseBuffer::create(bufferSize,
                      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     buffer);
-
-  vkMapMemory(CE::BaseDevice::base_device->logical_device,
-              buffer.memory,
-              0,
-              bufferSize,
-              0,
-              &buffer.mapped);
+                     buffer,
+                     shared_families);
+
+  buffer.map();
 }
 
 void VulkanResources::UniformBuffer::create_descriptor_write(CE::BaseDescriptorInterface &interface) {
@@ -119,7 +186,9 @@ void VulkanResources::UniformBuffer::create_descriptor_write(CE::BaseDescriptorI
   }
 };
 
-void VulkanResources::UniformBuffer::update(World &world, const VkExtent2D extent) {
+void VulkanResources::UniformBuffer::update(World &world,
+                                            const VkExtent2D extent,
+                                            const uint32_t frame_index) {
   static bool ubo_logged = false;
   ubo.light = world._ubo.light;
   ubo.grid_xy = glm::ivec2(world._grid.size.x, world._grid.size.y);
@@ -137,114 +206,126 @@ void VulkanResources::UniformBuffer::update(World &world, const VkExtent2D exten
                             ubo.water_rules.z, ubo.water_rules.w);
   }
 
-  std::memcpy(buffer.mapped, &ubo, sizeof(ubo));
+  std::memcpy(static_cast<char *>(buffer.mapped) + offset(frame_index), &ubo, sizeof(ubo));
 }
 
 VulkanResources::StorageBuffer::StorageBuffer(CE::BaseDescriptorInterface &descriptor_interface,
-                                        const CE::BaseCommandInterface &command_interface,
+                                        CE::BaseUploader &uploader,
+                                        const CE::BaseQueues::FamilyIndices &families,
+                                        CE::Checkpoint &checkpoint,
                                         const auto &object,
-                                        const size_t quantity) {
+                                        const size_t quantity,
+                                        const uint32_t grid_width)
+    : streams(quantity) {
   my_index = descriptor_interface.write_index;
-  descriptor_interface.write_index += 2;
+  descriptor_interface.write_index += stream_count * 2;
 
-  set_layout_binding.binding = 1;
   set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
   set_layout_binding.descriptorCount = 1;
   set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-  descriptor_interface.set_layout_bindings[my_index] = set_layout_binding;
-  set_layout_binding.binding = 2;
-  descriptor_interface.set_layout_bindings[my_index + 1] = set_layout_binding;
+  for (size_t stream = 0; stream < stream_count; ++stream) {
+    for (size_t side = 0; side < 2; ++side) {
+      set_layout_binding.binding = stream_bindings[stream][side];
+      descriptor_interface.set_layout_bindings[my_index + stream * 2 + side] = set_layout_binding;
+    }
+  }
 
   pool_size.type = set_layout_binding.descriptorType;
-  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT * 2;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT * stream_count * 2;
   descriptor_interface.pool_sizes.push_back(pool_size);
 
-  create(command_interface, object, quantity);
+  create(uploader, families, checkpoint, object, grid_width);
 
-  create_descriptor_write(descriptor_interface, quantity);
+  create_descriptor_write(descriptor_interface);
 }
 
-void VulkanResources::StorageBuffer::create(const CE::BaseCommandInterface &command_interface,
+void VulkanResources::StorageBuffer::create(CE::BaseUploader &uploader,
+                                      const CE::BaseQueues::FamilyIndices &families,
+                                      CE::Checkpoint &checkpoint,
                                       const auto &object,
-                                      const size_t quantity) {
+                                      const uint32_t grid_width) {
   Log::text("{ 101 }", "Shader Storage Buffers");
-
-  CE::BaseBuffer stagingResources;
-  VkDeviceSize bufferSize = sizeof(World::Cell) * quantity;
-
-  CE::BaseBuffer::create(bufferSize,
-                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     stagingResources);
-
-  void *data;
-  vkMapMemory(CE::BaseDevice::base_device->logical_device,
-              stagingResources.memory,
-              0,
-              bufferSize,
-              0,
-              &data);
-  std::memcpy(data, object.data(), static_cast<size_t>(bufferSize));
-  vkUnmapMemory(CE::BaseDevice::base_device->logical_device, stagingResources.memory);
-
+  Log::text(Log::Style::char_leader,
+            "cell streams",
+            streams.cell_count,
+            "cells",
+            streams.size,
+            "bytes per side");
+
+  VkDeviceSize bufferSize = streams.size;
+
+  // With async compute the sides are only touched by uploads (graphics queue) and the Engine
+  // step (compute queue), so sharing them costs nothing per frame; the per-frame handoff goes
+  // through VisibleCellsBuffer::render_cells with explicit ownership transfers.
+  std::vector<uint32_t> shared_families{};
+  if (families.async_compute()) {
+    shared_families = {families.graphics_and_compute_family.value(),
+                       families.compute_family.value()};
+  }
+  // Graphics draws from VisibleCellsBuffer, never from the sides themselves.
+  const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT;
   CE::BaseBuffer::create(static_cast<VkDeviceSize>(bufferSize),
-                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-                         VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     usage,
                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                     buffer_in);
-  CE::BaseBuffer::copy(stagingResources.buffer,
-                   buffer_in.buffer,
-                   bufferSize,
-                   command_interface.command_buffer,
-                   command_interface.command_pool,
-                   command_interface.queue);
-
+                     buffer_in,
+                     shared_families);
   CE::BaseBuffer::create(static_cast<VkDeviceSize>(bufferSize),
-                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-                         VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     usage,
                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                     buffer_out);
-  CE::BaseBuffer::copy(stagingResources.buffer,
-                   buffer_out.buffer,
-                   bufferSize,
-                   command_interface.command_buffer,
-                   command_interface.command_pool,
-                   command_interface.queue);
+                     buffer_out,
+                     shared_families);
+
+  // Packed (or read from a checkpoint) straight into staging memory; both sides start from the
+  // same state.
+  void *staging = uploader.reserve(bufferSize, {buffer_in.buffer, buffer_out.buffer});
+  if (!checkpoint.restore_cells(streams, staging)) {
+    streams.pack(object, grid_width, staging);
+  }
 }
 
-void VulkanResources::StorageBuffer::create_descriptor_write(CE::BaseDescriptorInterface &interface,
-                                                       const size_t quantity) {
-  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    VkDescriptorBufferInfo bufferInfo{.buffer = !i ? buffer_in.buffer : buffer_out.buffer,
-                                      .offset = 0,
-                                      .range = sizeof(World::Cell) * quantity};
-
-    !i ? info.current_frame = bufferInfo : info.previous_frame = bufferInfo;
+void VulkanResources::StorageBuffer::create_descriptor_write(CE::BaseDescriptorInterface &interface) {
+  const VkDeviceSize count = static_cast<VkDeviceSize>(streams.cell_count);
+  const std::array<std::pair<VkDeviceSize, VkDeviceSize>, stream_count> stream_ranges{{
+      {streams.position_offset, count * sizeof(glm::vec4)},
+      {streams.color_offset, count * sizeof(glm::vec4)},
+      {streams.states_offset, count * sizeof(glm::ivec4)},
+      {streams.alive_offset, streams.size - streams.alive_offset},
+  }};
 
-    VkWriteDescriptorSet descriptorWrite{};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.pNext = nullptr;
-    descriptorWrite.dstSet = VK_NULL_HANDLE;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(i ? 2 : 1);
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
-    descriptorWrite.descriptorType = set_layout_binding.descriptorType;
-    descriptorWrite.pImageInfo = nullptr;
-    descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.current_frame);
-    descriptorWrite.pTexelBufferView = nullptr;
-
-    interface.descriptor_writes[i][my_index] = descriptorWrite;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(i ? 1 : 2);
-    descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.previous_frame);
-    interface.descriptor_writes[i][my_index + 1] = descriptorWrite;
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    // Frame 0 reads buffer_in and writes buffer_out; frame 1 swaps them.
+    const std::array<VkBuffer, 2> sides{!i ? buffer_in.buffer : buffer_out.buffer,
+                                        !i ? buffer_out.buffer : buffer_in.buffer};
+
+    for (size_t stream = 0; stream < stream_count; ++stream) {
+      for (size_t side = 0; side < 2; ++side) {
+        const size_t slot = stream * 2 + side;
+        buffer_infos[i][slot] = VkDescriptorBufferInfo{.buffer = sides[side],
+                                                       .offset = stream_ranges[stream].first,
+                                                       .range = stream_ranges[stream].second};
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.pNext = nullptr;
+        descriptorWrite.dstSet = VK_NULL_HANDLE;
+        descriptorWrite.dstBinding = stream_bindings[stream][side];
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+        descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+        descriptorWrite.pImageInfo = nullptr;
+        descriptorWrite.pBufferInfo = &buffer_infos[i][slot];
+        descriptorWrite.pTexelBufferView = nullptr;
+
+        interface.descriptor_writes[i][my_index + slot] = descriptorWrite;
+      }
+    }
   }
 };
 
 VulkanResources::ImageSampler::ImageSampler(CE::BaseDescriptorInterface &interface,
-                    const CE::BaseCommandInterface &command_interface,
+                    CE::BaseUploader &uploader,
                     const std::string &texture_path)
   : texture_image(texture_path) {
   my_index = interface.write_index;
@@ -260,11 +341,7 @@ VulkanResources::ImageSampler::ImageSampler(CE::BaseDescriptorInterface &interfa
   pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
   interface.pool_sizes.push_back(pool_size);
 
-  texture_image.load_texture(texture_path,
-                             VK_FORMAT_R8G8B8A8_SRGB,
-                             command_interface.command_buffer,
-                             command_interface.command_pool,
-                             command_interface.queue);
+  texture_image.load_texture(texture_path, VK_FORMAT_R8G8B8A8_SRGB, uploader);
   texture_image.create_view(VK_IMAGE_ASPECT_COLOR_BIT);
   texture_image.create_sampler();
 
@@ -340,3 +417,371 @@ void VulkanResources::StorageImage::create_descriptor_write(
     interface.descriptor_writes[i][my_index] = descriptorWrite;
   }
 }
+
+VulkanResources::TerrainFieldBuffer::TerrainFieldBuffer(CE::BaseDescriptorInterface &interface,
+                                                        const size_t quantity) {
+  my_index = interface.write_index;
+  interface.write_index++;
+
+  set_layout_binding.binding = 5;
+  set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  set_layout_binding.descriptorCount = 1;
+  set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  interface.set_layout_bindings[my_index] = set_layout_binding;
+
+  pool_size.type = set_layout_binding.descriptorType;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
+  interface.pool_sizes.push_back(pool_size);
+
+  // Filled on the GPU by TerrainBake before the first Engine dispatch; no upload needed.
+  // Twice the grid so the jump flood passes can ping-pong inside one binding.
+  Log::text("{ 101 }", "Terrain Field Buffer", quantity, "samples");
+  CE::BaseBuffer::create(static_cast<VkDeviceSize>(sizeof(World::TerrainSample) * quantity * 2),
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         buffer);
+
+  create_descriptor_write(interface, quantity);
+}
+
+void VulkanResources::TerrainFieldBuffer::create_descriptor_write(
+    CE::BaseDescriptorInterface &interface, const size_t quantity) {
+  VkDescriptorBufferInfo bufferInfo{.buffer = buffer.buffer,
+                                    .offset = 0,
+                                    .range = sizeof(World::TerrainSample) * quantity * 2};
+  info.current_frame = bufferInfo;
+
+  VkWriteDescriptorSet descriptorWrite{};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.pNext = nullptr;
+  descriptorWrite.dstSet = VK_NULL_HANDLE;
+  descriptorWrite.dstBinding = set_layout_binding.binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+  descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+  descriptorWrite.pImageInfo = nullptr;
+  descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.current_frame);
+  descriptorWrite.pTexelBufferView = nullptr;
+
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    interface.descriptor_writes[i][my_index] = descriptorWrite;
+  }
+}
+
+VulkanResources::ConwayBitsBuffer::ConwayBitsBuffer(CE::BaseDescriptorInterface &interface,
+                                                    const Vec2UintFast16 grid_size) {
+  my_index = interface.write_index;
+  interface.write_index++;
+
+  set_layout_binding.binding = 12;
+  set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  set_layout_binding.descriptorCount = 1;
+  set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  interface.set_layout_bindings[my_index] = set_layout_binding;
+
+  pool_size.type = set_layout_binding.descriptorType;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
+  interface.pool_sizes.push_back(pool_size);
+
+  // 32 cells per word, rows padded to whole words; two grids so Conway reads one and
+  // writes the other. Scratch only: ConwayPack refills it from the alive stream each frame.
+  const VkDeviceSize row_words = (std::max<VkDeviceSize>(grid_size.x, 1) + 31) / 32;
+  const VkDeviceSize words = row_words * std::max<VkDeviceSize>(grid_size.y, 1);
+  const VkDeviceSize range = words * sizeof(uint32_t) * 2;
+  Log::text("{ 101 }", "Conway Bits Buffer", words, "words");
+  CE::BaseBuffer::create(range,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         buffer);
+
+  create_descriptor_write(interface, range);
+}
+
+void VulkanResources::ConwayBitsBuffer::create_descriptor_write(
+    CE::BaseDescriptorInterface &interface, const VkDeviceSize range) {
+  VkDescriptorBufferInfo bufferInfo{.buffer = buffer.buffer, .offset = 0, .range = range};
+  info.current_frame = bufferInfo;
+
+  VkWriteDescriptorSet descriptorWrite{};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.pNext = nullptr;
+  descriptorWrite.dstSet = VK_NULL_HANDLE;
+  descriptorWrite.dstBinding = set_layout_binding.binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+  descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+  descriptorWrite.pImageInfo = nullptr;
+  descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.current_frame);
+  descriptorWrite.pTexelBufferView = nullptr;
+
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    interface.descriptor_writes[i][my_index] = descriptorWrite;
+  }
+}
+
+VulkanResources::VisibleCellsBuffer::VisibleCellsBuffer(
+    CE::BaseDescriptorInterface &interface,
+    const CE::BaseQueues::FamilyIndices &families,
+    const uint32_t frames_in_flight,
+    const size_t quantity)
+    : size(instances_offset + sizeof(World::VisibleCell) * std::max<size_t>(quantity, 1)) {
+  my_index = interface.write_index;
+  interface.write_index++;
+
+  set_layout_binding.binding = 13;
+  set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  set_layout_binding.descriptorCount = 1;
+  set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  interface.set_layout_bindings[my_index] = set_layout_binding;
+
+  pool_size.type = set_layout_binding.descriptorType;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
+  interface.pool_sizes.push_back(pool_size);
+
+  // Rebuilt by CellCull every frame before anything reads it; no upload needed. The head
+  // (per-level draw commands and counts) is reset with vkCmdUpdateBuffer ahead of each cull.
+  Log::text("{ 101 }", "Visible Cells Buffer", quantity, "cells", size, "bytes");
+  CE::BaseBuffer::create(size,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                             VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         buffer);
+
+  if (families.async_compute()) {
+    for (uint32_t slot = 0; slot < frames_in_flight; ++slot) {
+      CE::BaseBuffer::create(size,
+                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                             render_cells[slot]);
+    }
+  }
+
+  create_descriptor_write(interface);
+}
+
+void VulkanResources::VisibleCellsBuffer::create_descriptor_write(
+    CE::BaseDescriptorInterface &interface) {
+  VkDescriptorBufferInfo bufferInfo{.buffer = buffer.buffer, .offset = 0, .range = size};
+  info.current_frame = bufferInfo;
+
+  VkWriteDescriptorSet descriptorWrite{};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.pNext = nullptr;
+  descriptorWrite.dstSet = VK_NULL_HANDLE;
+  descriptorWrite.dstBinding = set_layout_binding.binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+  descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+  descriptorWrite.pImageInfo = nullptr;
+  descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.current_frame);
+  descriptorWrite.pTexelBufferView = nullptr;
+
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    interface.descriptor_writes[i][my_index] = descriptorWrite;
+  }
+}
+
+VulkanResources::TerrainSurfaceBuffer::TerrainSurfaceBuffer(
+    CE::BaseDescriptorInterface &interface,
+    const CE::BaseQueues::FamilyIndices &families,
+    const Vec2UintFast16 grid_size,
+    const uint32_t subdivisions)
+    : subdivisions(subdivisions) {
+  my_index = interface.write_index;
+  interface.write_index++;
+
+  set_layout_binding.binding = 14;
+  set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  set_layout_binding.descriptorCount = 1;
+  set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+  interface.set_layout_bindings[my_index] = set_layout_binding;
+
+  pool_size.type = set_layout_binding.descriptorType;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
+  interface.pool_sizes.push_back(pool_size);
+
+  // Same lattice World::Grid builds the landscape mesh on.
+  const VkDeviceSize lattice_width =
+      (std::max<VkDeviceSize>(grid_size.x, 1) - 1) * subdivisions + 1;
+  const VkDeviceSize lattice_height =
+      (std::max<VkDeviceSize>(grid_size.y, 1) - 1) * subdivisions + 1;
+  const VkDeviceSize range =
+      sizeof(glm::uvec4) + sizeof(glm::vec4) * lattice_width * lattice_height;
+
+  // Filled on the GPU by TerrainSurfaceBake alongside TerrainBake; no upload needed. Written
+  // once on the compute queue and only read afterwards, so it is shared rather than handed
+  // over between families.
+  std::vector<uint32_t> shared_families{};
+  if (families.async_compute()) {
+    shared_families = {families.graphics_and_compute_family.value(),
+                       families.compute_family.value()};
+  }
+  Log::text("{ 101 }",
+            "Terrain Surface Buffer",
+            lattice_width,
+            "x",
+            lattice_height,
+            "vertices",
+            subdivisions,
+            "subdivisions");
+  CE::BaseBuffer::create(range,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         buffer,
+                         shared_families);
+
+  create_descriptor_write(interface, range);
+}
+
+void VulkanResources::TerrainSurfaceBuffer::create_descriptor_write(
+    CE::BaseDescriptorInterface &interface, const VkDeviceSize range) {
+  VkDescriptorBufferInfo bufferInfo{.buffer = buffer.buffer, .offset = 0, .range = range};
+  info.current_frame = bufferInfo;
+
+  VkWriteDescriptorSet descriptorWrite{};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.pNext = nullptr;
+  descriptorWrite.dstSet = VK_NULL_HANDLE;
+  descriptorWrite.dstBinding = set_layout_binding.binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+  descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+  descriptorWrite.pImageInfo = nullptr;
+  descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.current_frame);
+  descriptorWrite.pTexelBufferView = nullptr;
+
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    interface.descriptor_writes[i][my_index] = descriptorWrite;
+  }
+}
+
+VulkanResources::CellDeltaBuffers::CellDeltaBuffers(CE::BaseDescriptorInterface &interface,
+                                                    const uint32_t frames_in_flight,
+                                                    const Vec2UintFast16 grid_size,
+                                                    const uint32_t capacity)
+    : capacity(capacity) {
+  my_index = interface.write_index;
+  interface.write_index += 2;
+
+  set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  set_layout_binding.descriptorCount = 1;
+  set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  set_layout_binding.binding = 15;
+  interface.set_layout_bindings[my_index] = set_layout_binding;
+  set_layout_binding.binding = 16;
+  interface.set_layout_bindings[my_index + 1] = set_layout_binding;
+
+  pool_size.type = set_layout_binding.descriptorType;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT * 2;
+  interface.pool_sizes.push_back(pool_size);
+
+  // One offset per CellDelta work group: row segments of group_size cells, as in
+  // Pipelines::default_work_groups.
+  const VkDeviceSize groups =
+      capacity > 0 ? static_cast<VkDeviceSize>(
+                         (grid_size.x + CE::DeltaStream::group_size - 1) /
+                         CE::DeltaStream::group_size) *
+                         grid_size.y
+                   : 0;
+  const VkDeviceSize scratch_range =
+      sizeof(uint32_t) * (CE::DeltaStream::scratch_head_words + std::max<VkDeviceSize>(groups, 1));
+  const VkDeviceSize log_range =
+      capacity > 0 ? sizeof(uint32_t) * CE::DeltaStream::slot_words(capacity) * frames_in_flight
+                   : sizeof(uint32_t) * CE::DeltaStream::head_words;
+
+  // The passes write the log straight into host memory, so only changed cells cross the bus.
+  Log::text("{ 101 }", "Cell Delta Buffers", capacity, "entries per frame", log_range, "bytes");
+  CE::BaseBuffer::create(scratch_range,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         scratch);
+  CE::BaseBuffer::create(log_range,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                         log);
+  log.map();
+
+  create_descriptor_write(interface, scratch_range, log_range);
+}
+
+void VulkanResources::CellDeltaBuffers::create_descriptor_write(
+    CE::BaseDescriptorInterface &interface,
+    const VkDeviceSize scratch_range,
+    const VkDeviceSize log_range) {
+  buffer_infos[0] =
+      VkDescriptorBufferInfo{.buffer = scratch.buffer, .offset = 0, .range = scratch_range};
+  buffer_infos[1] = VkDescriptorBufferInfo{.buffer = log.buffer, .offset = 0, .range = log_range};
+
+  for (uint32_t binding = 0; binding < buffer_infos.size(); ++binding) {
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.pNext = nullptr;
+    descriptorWrite.dstSet = VK_NULL_HANDLE;
+    descriptorWrite.dstBinding = 15 + binding;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+    descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+    descriptorWrite.pImageInfo = nullptr;
+    descriptorWrite.pBufferInfo = &buffer_infos[binding];
+    descriptorWrite.pTexelBufferView = nullptr;
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+      interface.descriptor_writes[i][my_index + binding] = descriptorWrite;
+    }
+  }
+}
+
+VulkanResources::CellHashBuffer::CellHashBuffer(CE::BaseDescriptorInterface &interface,
+                                                const uint32_t frames_in_flight,
+                                                const bool enabled) {
+  my_index = interface.write_index;
+  interface.write_index++;
+
+  set_layout_binding.binding = 17;
+  set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  set_layout_binding.descriptorCount = 1;
+  set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  interface.set_layout_bindings[my_index] = set_layout_binding;
+
+  pool_size.type = set_layout_binding.descriptorType;
+  pool_size.descriptorCount = MAX_FRAMES_IN_FLIGHT;
+  interface.pool_sizes.push_back(pool_size);
+
+  // Small enough to stay host-visible: CellHash folds its atomics straight into it.
+  const VkDeviceSize range =
+      sizeof(uint32_t) * (enabled ? CE::StepHashes::slot_words() * frames_in_flight
+                                  : CE::StepHashes::hash_words);
+  Log::text("{ 101 }", "Cell Hash Buffer", range, "bytes");
+  CE::BaseBuffer::create(range,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                         log);
+  log.map();
+
+  create_descriptor_write(interface, range);
+}
+
+void VulkanResources::CellHashBuffer::create_descriptor_write(
+    CE::BaseDescriptorInterface &interface, const VkDeviceSize range) {
+  VkDescriptorBufferInfo bufferInfo{.buffer = log.buffer, .offset = 0, .range = range};
+  info.current_frame = bufferInfo;
+
+  VkWriteDescriptorSet descriptorWrite{};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.pNext = nullptr;
+  descriptorWrite.dstSet = VK_NULL_HANDLE;
+  descriptorWrite.dstBinding = set_layout_binding.binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = set_layout_binding.descriptorCount;
+  descriptorWrite.descriptorType = set_layout_binding.descriptorType;
+  descriptorWrite.pImageInfo = nullptr;
+  descriptorWrite.pBufferInfo = &std::get<VkDescriptorBufferInfo>(info.current_frame);
+  descriptorWrite.pTexelBufferView = nullptr;
+
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    interface.descriptor_writes[i][my_index] = descriptorWrite;
+  }
+}
@@ -4,12 +4,14 @@
 // Exists to keep descriptor/buffer/image setup co-located with world-owned data.
 #include "vulkan/vulkan.h"
 
+#include "control/StepScheduler.h"
 #include "vulkan_pipelines/ShaderAccess.h"
 #include "world/World.h"
 #include "vulkan_base/VulkanBaseDescriptor.h"
 #include "vulkan_base/VulkanBasePipeline.h"
 #include "vulkan_base/VulkanBaseResources.h"
 #include "vulkan_base/VulkanBaseSync.h"
+#include "vulkan_base/VulkanBaseUpload.h"
 #include "world/RuntimeConfig.h"
 
 #include <array>
@@ -32,13 +34,24 @@ public:
 
 	class UniformBuffer : public CE::BaseDescriptor {
 	public:
-		UniformBuffer(CE::BaseDescriptorInterface &interface, World::UniformBufferObject &u);
-		void update(World &world, const VkExtent2D extent);
+		UniformBuffer(CE::BaseDescriptorInterface &interface,
+		              World::UniformBufferObject &u,
+		              const CE::BaseQueues::FamilyIndices &families,
+		              const uint32_t frames_in_flight);
+		// Writes only frame_index's copy; the slot's previous frame must have completed.
+		void update(World &world, const VkExtent2D extent, const uint32_t frame_index);
+		// Dynamic offset of frame_index's copy, for every bind of a set in that frame.
+		uint32_t offset(const uint32_t frame_index) const {
+			return static_cast<uint32_t>(frame_index * stride);
+		}
 
 	private:
 		CE::BaseBuffer buffer;
 		World::UniformBufferObject &ubo;
-		void create_buffer();
+		// One aligned copy per frame slot, so a slot still being drawn keeps its values.
+		VkDeviceSize stride{0};
+		uint32_t copies{0};
+		void create_buffer(const CE::BaseQueues::FamilyIndices &families);
 		void create_descriptor_write(CE::BaseDescriptorInterface &interface);
 	};
 
@@ -46,23 +59,36 @@ public:
 	public:
 		CE::BaseBuffer buffer_in;
 		CE::BaseBuffer buffer_out;
+		World::CellStreams streams;
 
 		StorageBuffer(CE::BaseDescriptorInterface &descriptor_interface,
-									const CE::BaseCommandInterface &command_interface,
+									CE::BaseUploader &uploader,
+									const CE::BaseQueues::FamilyIndices &families,
+									CE::Checkpoint &checkpoint,
 									const auto &object,
-									const size_t quantity);
+									const size_t quantity,
+									const uint32_t grid_width);
 
 	private:
-		void create(const CE::BaseCommandInterface &command_interface,
+		static constexpr size_t stream_count = 4;
+		// In/out binding pair per stream: position, color, states, alive.
+		static constexpr std::array<std::array<uint32_t, 2>, stream_count> stream_bindings{
+				{{1, 2}, {6, 7}, {8, 9}, {10, 11}}};
+		std::array<std::array<VkDescriptorBufferInfo, stream_count * 2>, MAX_FRAMES_IN_FLIGHT>
+				buffer_infos{};
+
+		void create(CE::BaseUploader &uploader,
+								const CE::BaseQueues::FamilyIndices &families,
+								CE::Checkpoint &checkpoint,
 								const auto &object,
-								const size_t quantity);
-		void create_descriptor_write(CE::BaseDescriptorInterface &interface, const size_t quantity);
+								const uint32_t grid_width);
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface);
 	};
 
 	class ImageSampler : public CE::BaseDescriptor {
 	public:
 		ImageSampler(CE::BaseDescriptorInterface &interface,
-								 const CE::BaseCommandInterface &command_interface,
+								 CE::BaseUploader &uploader,
 								 const std::string &texture_path);
 
 	private:
@@ -77,9 +103,106 @@ public:
 		void create_descriptor_write(CE::BaseDescriptorInterface &interface,
 																 std::array<CE::BaseImage, MAX_FRAMES_IN_FLIGHT> &images);
 	};
+
+	class TerrainFieldBuffer : public CE::BaseDescriptor {
+	public:
+		CE::BaseBuffer buffer;
+
+		TerrainFieldBuffer(CE::BaseDescriptorInterface &interface, const size_t quantity);
+
+	private:
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface, const size_t quantity);
+	};
+
+	class ConwayBitsBuffer : public CE::BaseDescriptor {
+	public:
+		CE::BaseBuffer buffer;
+
+		ConwayBitsBuffer(CE::BaseDescriptorInterface &interface, const Vec2UintFast16 grid_size);
+
+	private:
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface, const VkDeviceSize range);
+	};
+	class VisibleCellsBuffer : public CE::BaseDescriptor {
+	public:
+		// Head of one VkDrawIndirectCommand per cell detail level plus the per-level totals
+		// CellCull counts, followed by up to one World::VisibleCell per grid cell, grouped by
+		// level. Matches shaders/VisibleCells.glsl.
+		CE::BaseBuffer buffer;
+		// Async compute only: per frame slot copy of the list Cells draws from, handed from the
+		// compute queue to the graphics queue so the next cull can overwrite the list while
+		// this one is still on screen.
+		std::array<CE::BaseBuffer, MAX_FRAME_LATENCY> render_cells;
+		VkDeviceSize size{};
+
+		struct Head {
+			std::array<VkDrawIndirectCommand, World::cell_lod_count> draws{};
+			std::array<uint32_t, 4> totals{};
+		};
+		static constexpr VkDeviceSize instances_offset = sizeof(Head);
+
+		VisibleCellsBuffer(CE::BaseDescriptorInterface &interface,
+											 const CE::BaseQueues::FamilyIndices &families,
+											 const uint32_t frames_in_flight,
+											 const size_t quantity);
+
+	private:
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface);
+	};
+	class TerrainSurfaceBuffer : public CE::BaseDescriptor {
+	public:
+		// Header (subdivisions, lattice width/height) followed by a normal and height per
+		// landscape mesh vertex. Matches shaders/TerrainSurface.glsl.
+		CE::BaseBuffer buffer;
+		const uint32_t subdivisions;
+
+		TerrainSurfaceBuffer(CE::BaseDescriptorInterface &interface,
+												 const CE::BaseQueues::FamilyIndices &families,
+												 const Vec2UintFast16 grid_size,
+												 const uint32_t subdivisions);
+
+	private:
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface, const VkDeviceSize range);
+	};
+	class CellDeltaBuffers : public CE::BaseDescriptor {
+	public:
+		// Per-work-group counts and offsets of CellDelta's prefix sum, behind a header naming
+		// the log slot the passes write (binding 15).
+		CE::BaseBuffer scratch;
+		// Host-visible compacted changes, one CE::DeltaStream slot per frame in flight
+		// (binding 16). Both are a few words when CE_DELTA_STREAM is unset.
+		CE::BaseBuffer log;
+		const uint32_t capacity;
+
+		CellDeltaBuffers(CE::BaseDescriptorInterface &interface,
+										 const uint32_t frames_in_flight,
+										 const Vec2UintFast16 grid_size,
+										 const uint32_t capacity);
+
+	private:
+		std::array<VkDescriptorBufferInfo, 2> buffer_infos{};
+
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface,
+																 const VkDeviceSize scratch_range,
+																 const VkDeviceSize log_range);
+	};
+	class CellHashBuffer : public CE::BaseDescriptor {
+	public:
+		// Host-visible CellHash results, one CE::StepHashes slot per frame in flight
+		// (binding 17); a few words when CE_VERIFY_HASHES is unset.
+		CE::BaseBuffer log;
+
+		CellHashBuffer(CE::BaseDescriptorInterface &interface,
+									 const uint32_t frames_in_flight,
+									 const bool enabled);
+
+	private:
+		void create_descriptor_write(CE::BaseDescriptorInterface &interface, const VkDeviceSize range);
+	};
 	CE::ShaderAccess::CommandResources
 			commands;
-	CE::BaseCommandInterface command_interface;
+	// Declared before world and the descriptors below, which stage their contents through it.
+	CE::BaseUploader uploader;
 	CE::BasePushConstants push_constant;
 
 	World world;
@@ -94,6 +217,19 @@ public:
 
 	ImageSampler sampler;
 	StorageImage storage_image;
-
+	TerrainFieldBuffer terrain_field;
+	ConwayBitsBuffer conway_bits;
+	VisibleCellsBuffer visible_cells;
+	TerrainSurfaceBuffer terrain_surface;
+	CellDeltaBuffers cell_deltas;
+	CellHashBuffer cell_hashes;
+
+	// Cleared up front when the cells were restored from a checkpoint instead.
 	bool startup_seed_pending = true;
+	bool terrain_bake_pending = true;
+	// Steps the next compute submission records; set by FrameContext from the StepScheduler.
+	StepScheduler::Batch simulation_batch{};
+	// Cell buffer holding the newest state: 0 = buffer_in, 1 = buffer_out. Descriptor set N
+	// reads side N, so stepping with sets[latest_cell_buffer] always advances the newest state.
+	uint32_t latest_cell_buffer = 0;
 };
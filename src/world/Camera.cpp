@@ -320,6 +320,10 @@ void Camera::apply_arcball_mode(const glm::vec2 &previous_cursor,
 }
 
 void Camera::update() {
+  if (Window::get().is_headless()) {
+    return;
+  }
+
   static bool camera_toggle_down = false;
   static bool horizon_toggle_down = false;
   static bool tuning_enabled = CE::Runtime::env_flag_enabled("CE_CAMERA_TUNING");
@@ -0,0 +1,506 @@
+#include "CellStepper.h"
+#include "world/TerrainField.h"
+#include "engine/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+constexpr int32_t kAlive = 1;
+constexpr int32_t kDead = -1;
+constexpr uint32_t kCycleSize = 24;
+constexpr float kSizeDead = 0.0f;
+constexpr float kTransferSizeFraction = 0.10f;
+constexpr float kMinAliveSizeFactor = 0.10f;
+constexpr float kMaxAliveSizeFactor = 4.00f;
+const glm::vec4 kWhite{1.0f, 1.0f, 1.0f, 1.0f};
+const glm::vec4 kGrey{0.5f, 0.5f, 0.5f, 1.0f};
+
+constexpr std::array<glm::ivec2, 8> kDirectNeighbourOffsets{{
+    {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}};
+
+glm::ivec4 set_state(const int32_t alive, const int32_t target_index, const uint32_t passed_hours) {
+  const int32_t cycle = static_cast<int32_t>(passed_hours % kCycleSize + 1u);
+  return {alive, target_index, cycle, static_cast<int32_t>(passed_hours)};
+}
+
+// SeedCells.comp hashing, kept bit-identical so CPU and GPU seed the same cells.
+uint32_t hash_u32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+uint32_t ceil_log2_u32(const uint32_t x) {
+  uint32_t bits = 0u;
+  uint32_t value = std::max(x - 1u, 1u);
+  while (value > 0u) {
+    value >>= 1u;
+    bits += 1u;
+  }
+  return bits;
+}
+
+uint32_t feistel_permute(const uint32_t value, const uint32_t half_bits, const uint32_t key) {
+  const uint32_t mask = (1u << half_bits) - 1u;
+  uint32_t left = value >> half_bits;
+  uint32_t right = value & mask;
+
+  for (uint32_t round = 0u; round < 5u; ++round) {
+    const uint32_t round_key = key + 0x9e3779b9u * (round + 1u);
+    const uint32_t f = hash_u32(right ^ round_key) & mask;
+    const uint32_t new_left = right;
+    const uint32_t new_right = (left ^ f) & mask;
+    left = new_left;
+    right = new_right;
+  }
+
+  return (left << half_bits) | right;
+}
+
+uint32_t permute_to_range(const uint32_t index, const uint32_t total_cells, const uint32_t seed) {
+  if (total_cells <= 1u) {
+    return 0u;
+  }
+
+  const uint32_t half_bits = (ceil_log2_u32(total_cells) + 1u) / 2u;
+  uint32_t value = index;
+  for (uint32_t iter = 0u; iter < 16u; ++iter) {
+    value = feistel_permute(value, half_bits, seed + 0x85ebca6bu * iter);
+    if (value < total_cells) {
+      return value;
+    }
+  }
+
+  return value % total_cells;
+}
+} // namespace
+
+CellStepper::Parameters CellStepper::Parameters::from_ubo(const World::UniformBufferObject &ubo) {
+  return Parameters{.grid_xy = ubo.grid_xy,
+                    .water_threshold = ubo.water_threshold,
+                    .cell_size = ubo.cell_size,
+                    .water_rules = ubo.water_rules};
+}
+
+CellStepper::Parameters
+CellStepper::Parameters::from_runtime(const CE::Runtime::TerrainSettings &terrain_settings,
+                                      const CE::Runtime::WorldSettings &world_settings) {
+  // Same clamping and packing as World::Grid and World::_ubo.
+  return Parameters{.grid_xy = glm::ivec2(std::max(terrain_settings.grid_width, 2),
+                                          std::max(terrain_settings.grid_height, 2)),
+                    .water_threshold = world_settings.water_threshold,
+                    .cell_size = terrain_settings.cell_size,
+                    .water_rules = glm::vec4(world_settings.water_dead_zone_margin,
+                                             world_settings.water_shore_band_width,
+                                             world_settings.water_border_highlight_width,
+                                             terrain_settings.absolute_height)};
+}
+
+CellStepper::CellStepper(const Parameters &parameters, const uint32_t thread_count)
+    : parameters_{parameters},
+      total_cells_{static_cast<uint32_t>(std::max(parameters.grid_xy.x, 1)) *
+                   static_cast<uint32_t>(std::max(parameters.grid_xy.y, 1))} {
+  uint32_t threads = thread_count;
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  const uint32_t grid_height = static_cast<uint32_t>(std::max(parameters_.grid_xy.y, 1));
+  threads = std::min(threads, grid_height);
+
+  // A few tiles per thread keeps the atomic work queue balanced when rows differ in cost.
+  rows_per_tile_ = std::max(1u, grid_height / (threads * 4u));
+
+  bake_terrain();
+
+  workers_.reserve(threads - 1);
+  for (uint32_t i = 1; i < threads; ++i) {
+    workers_.emplace_back([this]() { worker_loop(); });
+  }
+
+  Log::text("{ CPU }",
+            "CellStepper",
+            parameters_.grid_xy.x,
+            "x",
+            parameters_.grid_xy.y,
+            "threads",
+            threads,
+            "rows/tile",
+            rows_per_tile_);
+}
+
+CellStepper::~CellStepper() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+void CellStepper::load(const std::vector<World::Cell> &cells) {
+  if (cells.size() != total_cells_) {
+    throw std::runtime_error("\n!ERROR! CellStepper::load cell count does not match grid.");
+  }
+  buffers_[0] = cells;
+  buffers_[1] = cells;
+  current_ = 0;
+}
+
+void CellStepper::step(const uint32_t passed_hours, const float day_fraction) {
+  const uint32_t next = 1 - current_;
+  dispatch(buffers_[current_].data(), buffers_[next].data(), passed_hours, day_fraction);
+  current_ = next;
+}
+
+void CellStepper::dispatch(const World::Cell *cells_in,
+                           World::Cell *cells_out,
+                           const uint32_t passed_hours,
+                           const float day_fraction) {
+  const auto t_start = std::chrono::steady_clock::now();
+  const uint32_t grid_height = static_cast<uint32_t>(std::max(parameters_.grid_xy.y, 1));
+
+  job_in_ = cells_in;
+  job_out_ = cells_out;
+  job_passed_hours_ = passed_hours;
+  job_day_fraction_ = day_fraction;
+  tile_count_ = (grid_height + rows_per_tile_ - 1) / rows_per_tile_;
+  next_tile_.store(0, std::memory_order_relaxed);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_workers_ = static_cast<uint32_t>(workers_.size());
+    ++generation_;
+  }
+  work_ready_.notify_all();
+
+  run_tiles();
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this]() { return pending_workers_ == 0; });
+  }
+
+  last_step_ms_ = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - t_start)
+                      .count();
+}
+
+void CellStepper::worker_loop() {
+  uint64_t seen_generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_ready_.wait(lock,
+                       [&]() { return stopping_ || generation_ != seen_generation; });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+
+    run_tiles();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_workers_ == 0) {
+        work_done_.notify_one();
+      }
+    }
+  }
+}
+
+void CellStepper::run_tiles() {
+  const uint32_t grid_width = static_cast<uint32_t>(std::max(parameters_.grid_xy.x, 1));
+  const uint32_t grid_height = static_cast<uint32_t>(std::max(parameters_.grid_xy.y, 1));
+
+  for (;;) {
+    const uint32_t tile = next_tile_.fetch_add(1, std::memory_order_relaxed);
+    if (tile >= tile_count_) {
+      return;
+    }
+
+    const uint32_t row_begin = tile * rows_per_tile_;
+    const uint32_t row_end = std::min(row_begin + rows_per_tile_, grid_height);
+    for (uint32_t row = row_begin; row < row_end; ++row) {
+      for (uint32_t column = 0; column < grid_width; ++column) {
+        const uint32_t index = row * grid_width + column;
+        // Cells already stepped this hour are carried over unchanged (Engine.comp main()).
+        if (static_cast<uint32_t>(job_in_[index].states.w) == job_passed_hours_) {
+          job_out_[index] = job_in_[index];
+          continue;
+        }
+        job_out_[index] = simulate(job_in_, index, job_passed_hours_, job_day_fraction_);
+      }
+    }
+  }
+}
+
+World::Cell CellStepper::simulate(const World::Cell *cells_in,
+                                  const uint32_t index,
+                                  const uint32_t passed_hours,
+                                  const float day_fraction) const {
+  const World::Cell &in = cells_in[index];
+  const float size_alive = parameters_.cell_size;
+  const glm::vec4 in_position_off{glm::vec3(in.instance_position), kSizeDead};
+
+  const uint32_t cycle_hour = passed_hours % kCycleSize + 1u;
+  const float cycle_t = std::clamp(day_fraction, 0.0f, 1.0f);
+  const bool cycle_start = cycle_hour == 1u;
+  const bool cycle_end = cycle_hour == kCycleSize;
+  const bool alive_cell = in.states.x == kAlive;
+
+  // The baked shore coordinate only feeds Engine.comp's disabled Conway branch, so it is not kept here.
+  const glm::vec2 base_xy = grid_base_position(index);
+
+  const int32_t stored_target = in.states.y;
+  int32_t target_index = -1;
+  if (alive_cell) {
+    const bool needs_new_target =
+        cycle_start || stored_target < 0 || !neighbour_alive(cells_in, stored_target);
+    target_index =
+        needs_new_target ? closest_alive_neighbour_index(cells_in, index) : stored_target;
+  }
+  const float alive_size = std::max(in.instance_position.w, size_alive);
+  glm::vec4 moved_position_on = move_towards_target(
+      glm::vec4(base_xy, in.instance_position.z, alive_size), index, target_index, cycle_t);
+
+  World::Cell out = in;
+  if (alive_cell && !underwater_[index]) {
+    float grown_size = alive_size;
+    if (cycle_end) {
+      const int32_t inbound_transfers = inbound_transfers_to_self(cells_in, index);
+      if (inbound_transfers > 0) {
+        grown_size *= (1.0f + kTransferSizeFraction * static_cast<float>(inbound_transfers));
+      }
+      if (target_index >= 0) {
+        grown_size *= (1.0f - kTransferSizeFraction);
+      }
+    }
+
+    const float min_alive_size = std::max(size_alive * kMinAliveSizeFactor, 0.01f);
+    const float max_alive_size = std::max(size_alive * kMaxAliveSizeFactor, min_alive_size);
+    moved_position_on.w = std::clamp(grown_size, min_alive_size, max_alive_size);
+
+    out.instance_position = moved_position_on;
+    out.states = set_state(kAlive, target_index, passed_hours);
+  } else {
+    // Drowned alive cells and dead cells collapse to the same dead state.
+    out.instance_position = in_position_off;
+    out.color = kGrey;
+    out.states = set_state(kDead, -1, passed_hours);
+  }
+  return out;
+}
+
+int32_t CellStepper::neighbour_index(const uint32_t index, const glm::ivec2 offset) const {
+  const uint32_t grid_width = static_cast<uint32_t>(parameters_.grid_xy.x);
+  const glm::ivec2 neighbour_position =
+      glm::ivec2(static_cast<int32_t>(index % grid_width),
+                 static_cast<int32_t>(index / grid_width)) +
+      offset;
+  if (neighbour_position.x < 0 || neighbour_position.y < 0 ||
+      neighbour_position.x >= parameters_.grid_xy.x ||
+      neighbour_position.y >= parameters_.grid_xy.y) {
+    return -1;
+  }
+  return neighbour_position.y * parameters_.grid_xy.x + neighbour_position.x;
+}
+
+bool CellStepper::neighbour_alive(const World::Cell *cells_in, const int32_t index) const {
+  if (index < 0 || static_cast<uint32_t>(index) >= total_cells_) {
+    return false;
+  }
+  return cells_in[index].states.x == kAlive;
+}
+
+int32_t CellStepper::inbound_transfers_to_self(const World::Cell *cells_in,
+                                               const uint32_t index) const {
+  int32_t inbound = 0;
+  for (const glm::ivec2 &offset : kDirectNeighbourOffsets) {
+    const int32_t neighbour = neighbour_index(index, offset);
+    if (neighbour < 0 || !neighbour_alive(cells_in, neighbour)) {
+      continue;
+    }
+    if (cells_in[neighbour].states.y == static_cast<int32_t>(index)) {
+      inbound += 1;
+    }
+  }
+  return inbound;
+}
+
+int32_t CellStepper::closest_alive_neighbour_index(const World::Cell *cells_in,
+                                                   const uint32_t index) const {
+  // Same ring walk order as Engine.comp so ties resolve to the same neighbour.
+  const auto alive_at = [&](const glm::ivec2 offset) -> int32_t {
+    const int32_t neighbour = neighbour_index(index, offset);
+    return (neighbour >= 0 && neighbour_alive(cells_in, neighbour)) ? neighbour : -1;
+  };
+
+  constexpr int32_t max_range = 4;
+  for (int32_t radius = 1; radius <= max_range; ++radius) {
+    int32_t found = alive_at({0, -radius});
+    if (found >= 0) {
+      return found;
+    }
+    for (int32_t x = 1; x <= radius; ++x) {
+      if ((found = alive_at({x, -radius})) >= 0) {
+        return found;
+      }
+    }
+    for (int32_t y = -radius + 1; y <= radius; ++y) {
+      if ((found = alive_at({radius, y})) >= 0) {
+        return found;
+      }
+    }
+    for (int32_t x = radius - 1; x >= -radius; --x) {
+      if ((found = alive_at({x, radius})) >= 0) {
+        return found;
+      }
+    }
+    for (int32_t y = radius - 1; y >= -radius; --y) {
+      if ((found = alive_at({-radius, y})) >= 0) {
+        return found;
+      }
+    }
+    for (int32_t x = -radius + 1; x <= -1; ++x) {
+      if ((found = alive_at({x, -radius})) >= 0) {
+        return found;
+      }
+    }
+  }
+  return -1;
+}
+
+glm::vec2 CellStepper::grid_base_position(const uint32_t index) const {
+  const uint32_t grid_width = static_cast<uint32_t>(parameters_.grid_xy.x);
+  const float start_x = (static_cast<float>(parameters_.grid_xy.x) - 1.0f) * -0.5f;
+  const float start_y = (static_cast<float>(parameters_.grid_xy.y) - 1.0f) * -0.5f;
+  return {start_x + static_cast<float>(index % grid_width),
+          start_y + static_cast<float>(index / grid_width)};
+}
+
+bool CellStepper::is_underwater_at(const glm::vec2 xy) const {
+  return CE::TerrainField::height(xy) <=
+         parameters_.water_threshold + parameters_.water_rules.x;
+}
+
+void CellStepper::bake_terrain() {
+  underwater_.resize(total_cells_);
+  for (uint32_t index = 0; index < total_cells_; ++index) {
+    underwater_[index] = is_underwater_at(grid_base_position(index)) ? 1 : 0;
+  }
+}
+
+glm::vec4 CellStepper::move_towards_target(glm::vec4 source_position,
+                                           const uint32_t index,
+                                           const int32_t neighbour,
+                                           const float cycle_t) const {
+  if (neighbour < 0) {
+    return source_position;
+  }
+
+  const glm::vec2 base_xy = grid_base_position(index);
+  const glm::vec2 target_xy = grid_base_position(static_cast<uint32_t>(neighbour));
+  const glm::vec2 delta = target_xy - base_xy;
+  const float dist = glm::length(delta);
+  if (dist <= 1e-6f) {
+    source_position.x = base_xy.x;
+    source_position.y = base_xy.y;
+    return source_position;
+  }
+
+  const glm::vec2 travel_position = glm::mix(base_xy, target_xy, cycle_t);
+  const glm::vec2 dir = delta / dist;
+  const glm::vec2 perp{-dir.y, dir.x};
+
+  const uint32_t target_u = static_cast<uint32_t>(std::max(neighbour, 0));
+  const uint32_t lane_seed = index * 1973u + target_u * 9277u + 0x9e3779b9u;
+  const float lane_jitter =
+      glm::fract(std::sin(static_cast<float>(lane_seed) * 0.0174533f) * 43758.5453f) - 0.5f;
+
+  const float lane_width = std::max(parameters_.cell_size * 0.24f, 0.05f);
+  const float lane_scale = 1.0f - std::abs(2.0f * cycle_t - 1.0f);
+  const glm::vec2 lane_offset = perp * (lane_jitter * lane_width * lane_scale);
+
+  source_position.x = travel_position.x + lane_offset.x;
+  source_position.y = travel_position.y + lane_offset.y;
+  return source_position;
+}
+
+std::vector<World::Cell> CellStepper::seeded_cells(const Parameters &parameters,
+                                                   const uint32_t alive_cells,
+                                                   const float absolute_height) {
+  const uint32_t grid_width = static_cast<uint32_t>(std::max(parameters.grid_xy.x, 1));
+  const uint32_t grid_height = static_cast<uint32_t>(std::max(parameters.grid_xy.y, 1));
+  const uint32_t total_cells = grid_width * grid_height;
+  const float start_x = static_cast<float>(grid_width - 1) / -2.0f;
+  const float start_y = static_cast<float>(grid_height - 1) / -2.0f;
+
+  const uint32_t target_alive = std::min(alive_cells, total_cells);
+  const uint32_t seed = hash_u32(total_cells ^ 0x9e3779b9u);
+
+  std::vector<World::Cell> cells(total_cells);
+  for (uint32_t index = 0; index < total_cells; ++index) {
+    const bool is_alive = permute_to_range(index, total_cells, seed) < target_alive;
+
+    World::Cell &cell = cells[index];
+    cell.instance_position = {start_x + static_cast<float>(index % grid_width),
+                              start_y + static_cast<float>(index / grid_width),
+                              absolute_height,
+                              is_alive ? parameters.cell_size * 1.6f : 0.0f};
+    cell.color = is_alive ? kWhite : kGrey;
+    cell.states = {is_alive ? kAlive : kDead, -1, 0, 0};
+  }
+  return cells;
+}
+
+void CellStepper::run_benchmark() {
+  const CE::Runtime::TerrainSettings &terrain_settings = CE::Runtime::get_terrain_settings();
+  const Parameters parameters =
+      Parameters::from_runtime(terrain_settings, CE::Runtime::get_world_settings());
+  const uint32_t steps = CE::Runtime::env_uint(CE::Runtime::kEnvHeadlessSteps,
+                                               CE::Runtime::kDefaultHeadlessSteps);
+
+  CellStepper stepper(parameters, CE::Runtime::env_uint(CE::Runtime::kEnvCpuStepperThreads, 0));
+  stepper.load(seeded_cells(parameters, terrain_settings.alive_cells,
+                            terrain_settings.absolute_height));
+
+  Timer time(1.0f);
+  double total_ms = 0.0;
+  double max_ms = 0.0;
+  for (uint32_t step = 0; step < steps; ++step) {
+    time.advance_hours(1);
+    stepper.step(static_cast<uint32_t>(time.passed_hours), time.get_day_fraction());
+    total_ms += stepper.last_step_ms();
+    max_ms = std::max(max_ms, stepper.last_step_ms());
+  }
+
+  size_t alive = 0;
+  for (const World::Cell &cell : stepper.cells()) {
+    alive += cell.states.x == kAlive ? 1 : 0;
+  }
+
+  const double avg_ms = steps > 0 ? total_ms / static_cast<double>(steps) : 0.0;
+  Log::text("{ PERF }",
+            "CPU step",
+            parameters.grid_xy.x,
+            "x",
+            parameters.grid_xy.y,
+            "steps",
+            steps,
+            "avg_ms",
+            avg_ms,
+            "max_ms",
+            max_ms,
+            "steps/s",
+            avg_ms > 0.0 ? 1000.0 / avg_ms : 0.0,
+            "alive",
+            alive);
+}
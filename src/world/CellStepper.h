@@ -0,0 +1,107 @@
+#pragma once
+
+// Host-side reference implementation of the Engine.comp cell step.
+// Exists to run without a GPU and benchmark step cost per grid size.
+#include "world/World.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CellStepper {
+public:
+  // Mirrors the ParameterUBO fields Engine.comp reads.
+  struct Parameters {
+    glm::ivec2 grid_xy{2, 2};
+    float water_threshold{0.0f};
+    float cell_size{1.0f};
+    glm::vec4 water_rules{0.0f};
+
+    static Parameters from_ubo(const World::UniformBufferObject &ubo);
+    static Parameters from_runtime(const CE::Runtime::TerrainSettings &terrain_settings,
+                                   const CE::Runtime::WorldSettings &world_settings);
+  };
+
+  // thread_count 0 selects std::thread::hardware_concurrency().
+  explicit CellStepper(const Parameters &parameters, uint32_t thread_count = 0);
+  CellStepper(const CellStepper &) = delete;
+  CellStepper &operator=(const CellStepper &) = delete;
+  CellStepper(CellStepper &&) = delete;
+  CellStepper &operator=(CellStepper &&) = delete;
+  ~CellStepper();
+
+  // Loads the same cells StorageBuffer packs into buffer_in/buffer_out.
+  void load(const std::vector<World::Cell> &cells);
+  // One Engine dispatch: reads the current buffer, writes the other, then swaps.
+  void step(uint32_t passed_hours, float day_fraction);
+
+  const std::vector<World::Cell> &cells() const {
+    return buffers_[current_];
+  }
+  uint32_t thread_count() const {
+    return static_cast<uint32_t>(workers_.size()) + 1;
+  }
+  double last_step_ms() const {
+    return last_step_ms_;
+  }
+
+  // Grid construction plus SeedCells.comp, for runs that never touch Vulkan.
+  static std::vector<World::Cell> seeded_cells(const Parameters &parameters,
+                                               uint32_t alive_cells,
+                                               float absolute_height);
+  // CE_CPU_STEPPER entry point: seeds, steps CE_HEADLESS_STEPS hours, logs throughput.
+  static void run_benchmark();
+
+private:
+  Parameters parameters_;
+  uint32_t total_cells_{0};
+  uint32_t rows_per_tile_{16};
+
+  // Same underwater test TerrainBake.comp bakes for Engine.comp, evaluated once per cell.
+  std::vector<uint8_t> underwater_{};
+  std::array<std::vector<World::Cell>, 2> buffers_{};
+  uint32_t current_{0};
+  double last_step_ms_{0.0};
+
+  std::vector<std::thread> workers_{};
+  std::mutex mutex_{};
+  std::condition_variable work_ready_{};
+  std::condition_variable work_done_{};
+  uint64_t generation_{0};
+  uint32_t pending_workers_{0};
+  bool stopping_{false};
+
+  std::atomic<uint32_t> next_tile_{0};
+  uint32_t tile_count_{0};
+  const World::Cell *job_in_{nullptr};
+  World::Cell *job_out_{nullptr};
+  uint32_t job_passed_hours_{0};
+  float job_day_fraction_{0.0f};
+
+  void worker_loop();
+  void run_tiles();
+  void dispatch(const World::Cell *cells_in,
+                World::Cell *cells_out,
+                uint32_t passed_hours,
+                float day_fraction);
+
+  World::Cell simulate(const World::Cell *cells_in,
+                       uint32_t index,
+                       uint32_t passed_hours,
+                       float day_fraction) const;
+  int32_t neighbour_index(uint32_t index, glm::ivec2 offset) const;
+  bool neighbour_alive(const World::Cell *cells_in, int32_t index) const;
+  int32_t inbound_transfers_to_self(const World::Cell *cells_in, uint32_t index) const;
+  int32_t closest_alive_neighbour_index(const World::Cell *cells_in, uint32_t index) const;
+  glm::vec2 grid_base_position(uint32_t index) const;
+  bool is_underwater_at(glm::vec2 xy) const;
+  void bake_terrain();
+  glm::vec4 move_towards_target(glm::vec4 source_position,
+                                uint32_t index,
+                                int32_t neighbour,
+                                float cycle_t) const;
+};
@@ -0,0 +1,251 @@
+#include "ConwayBits.h"
+#include "engine/Log.h"
+#include "world/RuntimeConfig.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+// The AVX2 kernel is compiled for AVX2 on its own and chosen at run time, so default builds
+// (no -mavx2) still use it on CPUs that have it.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CE_CONWAY_AVX2 1
+#include <immintrin.h>
+#define CE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+// Same carry-save tree as Conway.comp: three row sums, then ones/twos/fours planes.
+inline uint64_t next_word(const uint64_t *above,
+                          const uint64_t *self,
+                          const uint64_t *below,
+                          const uint32_t x) {
+  const uint64_t a = above[x];
+  const uint64_t a_w = (a << 1) | (above[x - 1] >> 63);
+  const uint64_t a_e = (a >> 1) | (above[x + 1] << 63);
+  const uint64_t s = self[x];
+  const uint64_t s_w = (s << 1) | (self[x - 1] >> 63);
+  const uint64_t s_e = (s >> 1) | (self[x + 1] << 63);
+  const uint64_t b = below[x];
+  const uint64_t b_w = (b << 1) | (below[x - 1] >> 63);
+  const uint64_t b_e = (b >> 1) | (below[x + 1] << 63);
+
+  const uint64_t above_sum = a_w ^ a ^ a_e;
+  const uint64_t above_carry = (a_w & a) | (a_e & (a_w ^ a));
+  const uint64_t below_sum = b_w ^ b ^ b_e;
+  const uint64_t below_carry = (b_w & b) | (b_e & (b_w ^ b));
+  const uint64_t side_sum = s_w ^ s_e;
+  const uint64_t side_carry = s_w & s_e;
+
+  const uint64_t bit0 = above_sum ^ below_sum ^ side_sum;
+  const uint64_t ones_carry = (above_sum & below_sum) | (side_sum & (above_sum ^ below_sum));
+
+  const uint64_t twos_sum = above_carry ^ below_carry ^ side_carry;
+  const uint64_t twos_carry =
+      (above_carry & below_carry) | (side_carry & (above_carry ^ below_carry));
+  const uint64_t bit1 = twos_sum ^ ones_carry;
+  const uint64_t twos_carry2 = twos_sum & ones_carry;
+
+  const uint64_t bit2 = twos_carry ^ twos_carry2;
+  const uint64_t bit3 = twos_carry & twos_carry2;
+
+  return bit1 & ~bit2 & ~bit3 & (bit0 | s);
+}
+
+#if defined(CE_CONWAY_AVX2)
+CE_TARGET_AVX2 inline __m256i load4(const uint64_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+CE_TARGET_AVX2 inline __m256i shift_west(const __m256i center, const __m256i left) {
+  return _mm256_or_si256(_mm256_slli_epi64(center, 1), _mm256_srli_epi64(left, 63));
+}
+
+CE_TARGET_AVX2 inline __m256i shift_east(const __m256i center, const __m256i right) {
+  return _mm256_or_si256(_mm256_srli_epi64(center, 1), _mm256_slli_epi64(right, 63));
+}
+
+CE_TARGET_AVX2 inline void full_adder(
+    const __m256i a, const __m256i b, const __m256i c, __m256i &sum, __m256i &carry) {
+  const __m256i ab = _mm256_xor_si256(a, b);
+  sum = _mm256_xor_si256(ab, c);
+  carry = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, ab));
+}
+
+// Four words per iteration; identical to next_word() lane by lane.
+CE_TARGET_AVX2 inline void next_words4(const uint64_t *above,
+                                       const uint64_t *self,
+                                       const uint64_t *below,
+                                       const uint32_t x,
+                                       uint64_t *out) {
+  const __m256i a = load4(above + x);
+  const __m256i a_w = shift_west(a, load4(above + x - 1));
+  const __m256i a_e = shift_east(a, load4(above + x + 1));
+  const __m256i s = load4(self + x);
+  const __m256i s_w = shift_west(s, load4(self + x - 1));
+  const __m256i s_e = shift_east(s, load4(self + x + 1));
+  const __m256i b = load4(below + x);
+  const __m256i b_w = shift_west(b, load4(below + x - 1));
+  const __m256i b_e = shift_east(b, load4(below + x + 1));
+
+  __m256i above_sum, above_carry, below_sum, below_carry;
+  full_adder(a_w, a, a_e, above_sum, above_carry);
+  full_adder(b_w, b, b_e, below_sum, below_carry);
+  const __m256i side_sum = _mm256_xor_si256(s_w, s_e);
+  const __m256i side_carry = _mm256_and_si256(s_w, s_e);
+
+  __m256i bit0, ones_carry, twos_sum, twos_carry;
+  full_adder(above_sum, below_sum, side_sum, bit0, ones_carry);
+  full_adder(above_carry, below_carry, side_carry, twos_sum, twos_carry);
+  const __m256i bit1 = _mm256_xor_si256(twos_sum, ones_carry);
+  const __m256i twos_carry2 = _mm256_and_si256(twos_sum, ones_carry);
+  const __m256i fours = _mm256_or_si256(twos_carry, twos_carry2);
+
+  const __m256i next = _mm256_andnot_si256(fours, _mm256_and_si256(bit1, _mm256_or_si256(bit0, s)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), next);
+}
+
+// Whole words of the row four at a time; returns the first word left for next_word().
+CE_TARGET_AVX2 uint32_t step_row_avx2(const uint64_t *above,
+                                      const uint64_t *self,
+                                      const uint64_t *below,
+                                      const uint32_t row_words,
+                                      uint64_t *out) {
+  uint32_t x = 1;
+  for (; x + 4 <= row_words + 1; x += 4) {
+    next_words4(above, self, below, x, out);
+  }
+  return x;
+}
+#endif
+
+bool cpu_has_avx2() {
+#if defined(CE_CONWAY_AVX2)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+uint32_t hash_u32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+} // namespace
+
+ConwayBits::ConwayBits(const uint32_t width, const uint32_t height)
+    : width_(std::max(width, 1u)), height_(std::max(height, 1u)),
+      row_words_((width_ + word_bits - 1) / word_bits), stride_(row_words_ + 2),
+      current_(static_cast<size_t>(height_ + 2) * stride_, 0),
+      next_(current_.size(), 0), avx2_(cpu_has_avx2()) {
+  const uint32_t tail_bits = width_ % word_bits;
+  if (tail_bits != 0) {
+    tail_mask_ = (uint64_t{1} << tail_bits) - 1;
+  }
+}
+
+void ConwayBits::set(const uint32_t x, const uint32_t y, const bool alive) {
+  if (x >= width_ || y >= height_) {
+    return;
+  }
+  const uint64_t bit = uint64_t{1} << (x % word_bits);
+  uint64_t &word = current_[word_index(x, y)];
+  word = alive ? (word | bit) : (word & ~bit);
+}
+
+bool ConwayBits::get(const uint32_t x, const uint32_t y) const {
+  if (x >= width_ || y >= height_) {
+    return false;
+  }
+  return ((current_[word_index(x, y)] >> (x % word_bits)) & 1u) != 0;
+}
+
+void ConwayBits::step() {
+  const auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t y = 0; y < height_; ++y) {
+    const uint64_t *above = current_.data() + static_cast<size_t>(y) * stride_;
+    const uint64_t *self = above + stride_;
+    const uint64_t *below = self + stride_;
+    uint64_t *out = next_.data() + static_cast<size_t>(y + 1) * stride_;
+
+    uint32_t x = 1;
+#if defined(CE_CONWAY_AVX2)
+    if (avx2_) {
+      x = step_row_avx2(above, self, below, row_words_, out);
+    }
+#endif
+    for (; x <= row_words_; ++x) {
+      out[x] = next_word(above, self, below, x);
+    }
+    // Padding bits past the grid edge must stay dead or they seed the last column.
+    out[row_words_] &= tail_mask_;
+  }
+
+  current_.swap(next_);
+
+  last_step_ms_ =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t ConwayBits::population() const {
+  size_t alive = 0;
+  for (const uint64_t word : current_) {
+    alive += static_cast<size_t>(std::popcount(word));
+  }
+  return alive;
+}
+
+void ConwayBits::run_benchmark() {
+  const CE::Runtime::TerrainSettings &terrain_settings = CE::Runtime::get_terrain_settings();
+  const uint32_t size = CE::Runtime::env_uint(CE::Runtime::kEnvCpuConwaySize, 0);
+  const uint32_t scene_width = static_cast<uint32_t>(std::max(terrain_settings.grid_width, 1));
+  const uint32_t scene_height = static_cast<uint32_t>(std::max(terrain_settings.grid_height, 1));
+  const uint32_t width = size > 0 ? size : scene_width;
+  const uint32_t height = size > 0 ? size : scene_height;
+  const uint32_t steps = CE::Runtime::env_uint(CE::Runtime::kEnvHeadlessSteps,
+                                               CE::Runtime::kDefaultHeadlessSteps);
+
+  // Keep the scene's alive fraction when the grid is resized.
+  const uint64_t scene_cells = static_cast<uint64_t>(scene_width) * scene_height;
+  const uint32_t alive_threshold = static_cast<uint32_t>(
+      std::min<uint64_t>(terrain_settings.alive_cells, scene_cells) * 0xffffffffull / scene_cells);
+
+  ConwayBits grid(width, height);
+  for (uint32_t y = 0; y < grid.height(); ++y) {
+    for (uint32_t x = 0; x < grid.width(); ++x) {
+      grid.set(x, y, hash_u32(y * grid.width() + x) < alive_threshold);
+    }
+  }
+
+  double total_ms = 0.0;
+  double max_ms = 0.0;
+  for (uint32_t step = 0; step < steps; ++step) {
+    grid.step();
+    total_ms += grid.last_step_ms();
+    max_ms = std::max(max_ms, grid.last_step_ms());
+  }
+
+  const double avg_ms = steps > 0 ? total_ms / static_cast<double>(steps) : 0.0;
+  const double cells = static_cast<double>(grid.width()) * grid.height();
+  Log::text("{ PERF }",
+            "CPU conway",
+            grid.uses_avx2() ? "avx2" : "scalar",
+            grid.width(),
+            "x",
+            grid.height(),
+            "steps",
+            steps,
+            "avg_ms",
+            avg_ms,
+            "max_ms",
+            max_ms,
+            "Mcells/s",
+            avg_ms > 0.0 ? cells / (avg_ms * 1000.0) : 0.0,
+            "alive",
+            grid.population());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Bit-packed Game of Life grid, 64 cells per word, stepped with bitwise full-adder sums.
+// Exists as the CPU counterpart of Conway.comp and to measure scaling toward 16k x 16k grids.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ConwayBits {
+public:
+  static constexpr uint32_t word_bits = 64;
+
+  ConwayBits(uint32_t width, uint32_t height);
+
+  void set(uint32_t x, uint32_t y, bool alive);
+  bool get(uint32_t x, uint32_t y) const;
+  // One generation; cells outside the grid count as dead.
+  void step();
+  size_t population() const;
+
+  uint32_t width() const {
+    return width_;
+  }
+  uint32_t height() const {
+    return height_;
+  }
+  double last_step_ms() const {
+    return last_step_ms_;
+  }
+  // Whether step() runs the AVX2 kernel; picked from the CPU at construction.
+  bool uses_avx2() const {
+    return avx2_;
+  }
+
+  // CE_CPU_CONWAY entry point: seeds, steps CE_HEADLESS_STEPS generations, logs throughput.
+  static void run_benchmark();
+
+private:
+  uint32_t width_{0};
+  uint32_t height_{0};
+  uint32_t row_words_{0};
+  // Rows carry one zero word on each side and the grid one zero row above and below,
+  // so the inner loop never bounds-checks its neighbours.
+  uint32_t stride_{0};
+  uint64_t tail_mask_{~uint64_t{0}};
+  std::vector<uint64_t> current_{};
+  std::vector<uint64_t> next_{};
+  bool avx2_{false};
+  double last_step_ms_{0.0};
+
+  size_t word_index(uint32_t x, uint32_t y) const {
+    return static_cast<size_t>(y + 1) * stride_ + 1 + x / word_bits;
+  }
+};
@@ -183,6 +183,17 @@ template <> struct std::hash<Vertex> {
 };
 
 Geometry::Geometry(GEOMETRY_SHAPE shape) {
+  // Built in shader space: no model file and no STANDARD_ORIENTATION, since Cells.vert
+  // expands the billboard along the camera axes from its xy corners.
+  if (shape == CE_BOX) {
+    fillFallbackCube(*this);
+    return;
+  }
+  if (shape == CE_BILLBOARD) {
+    fillFallbackQuad(*this);
+    return;
+  }
+
   const std::string model_name = [&]() -> std::string {
     switch (shape) {
       case CE_RECTANGLE:
@@ -278,118 +289,52 @@ std::vector<uint32_t> Geometry::create_grid_polygons(const std::vector<uint32_t>
   return result;
 }
 
-void Geometry::create_vertex_buffer(VkCommandBuffer &command_buffer,
-                                    const VkCommandPool &command_pool,
-                                  const VkQueue &queue,
-                                  const std::vector<Vertex> &vertices) {
-  create_vertex_buffer(command_buffer, command_pool, queue, vertices, this->vertex_buffer);
+void Geometry::create_vertex_buffer(CE::BaseUploader &uploader,
+                                    const std::vector<Vertex> &vertices) {
+  create_vertex_buffer(uploader, vertices, this->vertex_buffer);
 }
 
-void Geometry::create_vertex_buffer(VkCommandBuffer &command_buffer,
-                                    const VkCommandPool &command_pool,
-                                    const VkQueue &queue,
+void Geometry::create_vertex_buffer(CE::BaseUploader &uploader,
                                     const std::vector<Vertex> &vertices,
                                     CE::BaseBuffer &target_buffer) {
   if (vertices.empty()) {
     return;
   }
 
-  CE::BaseBuffer stagingResources;
   VkDeviceSize bufferSize = sizeof(Vertex) * vertices.size();
-
-  CE::BaseBuffer::create(bufferSize,
-                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     stagingResources);
-
-  void *data;
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ MAP }", "Map staging vertex memory", stagingResources.memory, bufferSize);
-  }
-  vkMapMemory(CE::BaseDevice::base_device->logical_device,
-              stagingResources.memory,
-              0,
-              bufferSize,
-              0,
-              &data);
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ WR }", "Write host->staging vertex bytes", bufferSize);
-  }
-  memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ MAP }", "Unmap staging vertex memory", stagingResources.memory);
-  }
-  vkUnmapMemory(CE::BaseDevice::base_device->logical_device, stagingResources.memory);
-
   CE::BaseBuffer::create(bufferSize,
                      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                      target_buffer);
 
-  CE::BaseBuffer::copy(stagingResources.buffer,
-                   target_buffer.buffer,
-                   bufferSize,
-                   command_buffer,
-                   command_pool,
-                   queue);
+  if (Log::gpu_trace_enabled()) {
+    Log::text("{ WR }", "Stage vertex bytes", bufferSize);
+  }
+  uploader.upload(vertices.data(), bufferSize, target_buffer.buffer);
 }
 
-void Geometry::create_index_buffer(VkCommandBuffer &command_buffer,
-                                   const VkCommandPool &command_pool,
-                                   const VkQueue &queue,
+void Geometry::create_index_buffer(CE::BaseUploader &uploader,
                                    const std::vector<uint32_t> &index_data) {
-  create_index_buffer(command_buffer, command_pool, queue, index_data, this->index_buffer);
+  create_index_buffer(uploader, index_data, this->index_buffer);
 }
 
-void Geometry::create_index_buffer(VkCommandBuffer &command_buffer,
-                                   const VkCommandPool &command_pool,
-                                   const VkQueue &queue,
+void Geometry::create_index_buffer(CE::BaseUploader &uploader,
                                    const std::vector<uint32_t> &index_data,
                                    CE::BaseBuffer &target_buffer) {
   if (index_data.empty()) {
     return;
   }
 
-  CE::BaseBuffer stagingResources;
   VkDeviceSize bufferSize = sizeof(uint32_t) * index_data.size();
-
-  CE::BaseBuffer::create(bufferSize,
-                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     stagingResources);
-
-  void *data;
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ MAP }", "Map staging index memory", stagingResources.memory, bufferSize);
-  }
-  vkMapMemory(CE::BaseDevice::base_device->logical_device,
-              stagingResources.memory,
-              0,
-              bufferSize,
-              0,
-              &data);
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ WR }", "Write host->staging index bytes", bufferSize);
-  }
-  memcpy(data, index_data.data(), static_cast<size_t>(bufferSize));
-  if (Log::gpu_trace_enabled()) {
-    Log::text("{ MAP }", "Unmap staging index memory", stagingResources.memory);
-  }
-  vkUnmapMemory(CE::BaseDevice::base_device->logical_device, stagingResources.memory);
-
   CE::BaseBuffer::create(bufferSize,
                      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                      target_buffer);
 
-  CE::BaseBuffer::copy(stagingResources.buffer,
-                   target_buffer.buffer,
-                   bufferSize,
-                   command_buffer,
-                   command_pool,
-                   queue);
+  if (Log::gpu_trace_enabled()) {
+    Log::text("{ WR }", "Stage index bytes", bufferSize);
+  }
+  uploader.upload(index_data.data(), bufferSize, target_buffer.buffer);
 }
 
 void Geometry::load_model(const std::string &model_name, Geometry &geometry) {
@@ -519,17 +464,13 @@ void Geometry::transform_model(std::vector<Vertex> &vertices,
   return;
 }
 
-Shape::Shape(GEOMETRY_SHAPE shape,
-             bool has_indices,
-             VkCommandBuffer &command_buffer,
-             const VkCommandPool &command_pool,
-             const VkQueue &queue)
+Shape::Shape(GEOMETRY_SHAPE shape, bool has_indices, CE::BaseUploader &uploader)
     : Geometry(shape) {
   if (has_indices) {
-    create_vertex_buffer(command_buffer, command_pool, queue, unique_vertices);
-    create_index_buffer(command_buffer, command_pool, queue, indices);
+    create_vertex_buffer(uploader, unique_vertices);
+    create_index_buffer(uploader, indices);
   }
   if (!has_indices) {
-    create_vertex_buffer(command_buffer, command_pool, queue, all_vertices);
+    create_vertex_buffer(uploader, all_vertices);
   }
 }
@@ -10,6 +10,7 @@
 #include <glm/gtx/hash.hpp>
 
 #include "vulkan_base/VulkanBaseResources.h"
+#include "vulkan_base/VulkanBaseUpload.h"
 
 #include <string>
 #include <vector>
@@ -21,7 +22,10 @@ enum GEOMETRY_SHAPE {
   CE_CUBE = 1,
   CE_SPHERE = 2,
   CE_SPHERE_HR = 3,
-  CE_TORUS = 4
+  CE_TORUS = 4,
+  // Procedural, for the reduced cell detail levels (World::cell_lod_count).
+  CE_BOX = 5,
+  CE_BILLBOARD = 6
 };
 
 class Vertex {
@@ -59,23 +63,14 @@ public:
                                                     uint32_t grid_width);
 
 protected:
-  void create_vertex_buffer(VkCommandBuffer &command_buffer,
-                            const VkCommandPool &command_pool,
-                          const VkQueue &queue,
-                          const std::vector<Vertex> &vertices);
-  void create_vertex_buffer(VkCommandBuffer &command_buffer,
-                            const VkCommandPool &command_pool,
-                            const VkQueue &queue,
+  // Creates the device-local buffer now; its contents arrive with the uploader's next batch.
+  void create_vertex_buffer(CE::BaseUploader &uploader, const std::vector<Vertex> &vertices);
+  void create_vertex_buffer(CE::BaseUploader &uploader,
                             const std::vector<Vertex> &vertices,
                             CE::BaseBuffer &target_buffer);
 
-  void create_index_buffer(VkCommandBuffer &command_buffer,
-                           const VkCommandPool &command_pool,
-                         const VkQueue &queue,
-                         const std::vector<uint32_t> &indices);
-  void create_index_buffer(VkCommandBuffer &command_buffer,
-                           const VkCommandPool &command_pool,
-                           const VkQueue &queue,
+  void create_index_buffer(CE::BaseUploader &uploader, const std::vector<uint32_t> &indices);
+  void create_index_buffer(CE::BaseUploader &uploader,
                            const std::vector<uint32_t> &indices,
                            CE::BaseBuffer &target_buffer);
 
@@ -90,9 +85,5 @@ private:
 
 class Shape : public Geometry {
 public:
-  Shape(GEOMETRY_SHAPE shape,
-  bool has_indices,
-  VkCommandBuffer &command_buffer,
-  const VkCommandPool &command_pool,
-        const VkQueue &queue);
+  Shape(GEOMETRY_SHAPE shape, bool has_indices, CE::BaseUploader &uploader);
 };
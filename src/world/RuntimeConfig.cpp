@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <limits>
 #include <optional>
 
 namespace CE::Runtime {
@@ -17,6 +18,7 @@ std::unordered_map<std::string, std::string> active_graphics_draw_ops{};
 std::unordered_map<std::string, DrawOpId> active_graphics_draw_op_ids{};
 TerrainSettings active_terrain_settings{};
 WorldSettings active_world_settings{};
+uint64_t active_render_graph_revision{0};
 
 } // namespace
 
@@ -40,6 +42,20 @@ bool env_flag_enabled(const char *name) {
   return env_truthy(std::getenv(name));
 }
 
+uint32_t env_uint(const char *name, const uint32_t default_value) {
+  const char *raw = name ? std::getenv(name) : nullptr;
+  if (!raw || *raw == '\0') {
+    return default_value;
+  }
+
+  char *end = nullptr;
+  const unsigned long parsed = std::strtoul(raw, &end, 10);
+  if (end == raw || *end != '\0' || parsed > std::numeric_limits<uint32_t>::max()) {
+    return default_value;
+  }
+  return static_cast<uint32_t>(parsed);
+}
+
 DrawOpId draw_op_from_string(std::string_view draw_op) {
   if (draw_op == "cells_instanced" || draw_op == "instanced:cells") {
     return DrawOpId::InstancedCells;
@@ -85,6 +101,7 @@ const char *to_string(DrawOpId draw_op) {
 
 void set_pipeline_execution_plan(const PipelineExecutionPlan &plan) {
   active_plan = plan;
+  ++active_render_graph_revision;
 }
 
 const PipelineExecutionPlan *get_pipeline_execution_plan() {
@@ -93,12 +110,17 @@ const PipelineExecutionPlan *get_pipeline_execution_plan() {
 
 void set_render_graph(const RenderGraph &graph) {
   active_render_graph = graph;
+  ++active_render_graph_revision;
 }
 
 const RenderGraph *get_render_graph() {
   return active_render_graph ? &(*active_render_graph) : nullptr;
 }
 
+uint64_t render_graph_revision() {
+  return active_render_graph_revision;
+}
+
 void set_pipeline_definitions(
     const std::unordered_map<std::string, PipelineDefinition> &definitions) {
   active_pipeline_definitions = definitions;
@@ -138,6 +160,7 @@ void set_graphics_draw_ops(const std::unordered_map<std::string, std::string> &d
   for (const auto &[pipeline_name, draw_op] : draw_ops) {
     active_graphics_draw_op_ids[pipeline_name] = draw_op_from_string(draw_op);
   }
+  ++active_render_graph_revision;
 }
 
 const std::string *get_graphics_draw_op(const std::string &pipeline_name) {
@@ -151,6 +174,7 @@ void set_graphics_draw_op_ids(const std::unordered_map<std::string, DrawOpId> &d
   for (const auto &[pipeline_name, draw_op] : draw_ops) {
     active_graphics_draw_ops[pipeline_name] = to_string(draw_op);
   }
+  ++active_render_graph_revision;
 }
 
 DrawOpId get_graphics_draw_op_id(const std::string &pipeline_name) {
@@ -174,6 +198,7 @@ void clear_pipeline_execution_plan() {
   active_scene_assembly = SceneAssembly{};
   active_graphics_draw_ops.clear();
   active_graphics_draw_op_ids.clear();
+  ++active_render_graph_revision;
 }
 
 } // namespace CE::Runtime
@@ -18,6 +18,34 @@ constexpr uint32_t kDefaultAliveCells = 100;
 
 constexpr const char *kEnvStartupScreenshot = "CE_STARTUP_SCREENSHOT";
 constexpr const char *kEnvStartupScreenshotCycle = "CE_STARTUP_SCREENSHOT_CYCLE";
+constexpr const char *kEnvHeadless = "CE_HEADLESS";
+constexpr const char *kEnvHeadlessSteps = "CE_HEADLESS_STEPS";
+constexpr uint32_t kDefaultHeadlessSteps = 1000;
+constexpr const char *kEnvCpuStepper = "CE_CPU_STEPPER";
+constexpr const char *kEnvCpuStepperThreads = "CE_CPU_STEPPER_THREADS";
+constexpr const char *kEnvHeadlessStepsPerFrame = "CE_HEADLESS_STEPS_PER_FRAME";
+constexpr const char *kEnvMaxStepsPerFrame = "CE_MAX_STEPS_PER_FRAME";
+constexpr uint32_t kDefaultMaxStepsPerFrame = 8;
+constexpr const char *kEnvFastForward = "CE_FAST_FORWARD";
+constexpr const char *kEnvCpuConway = "CE_CPU_CONWAY";
+constexpr const char *kEnvCpuConwaySize = "CE_CPU_CONWAY_SIZE";
+constexpr const char *kEnvSharedComputeQueue = "CE_SHARED_COMPUTE_QUEUE";
+constexpr const char *kEnvFramesInFlight = "CE_FRAMES_IN_FLIGHT";
+constexpr const char *kEnvGpuProfile = "CE_GPU_PROFILE";
+constexpr const char *kEnvGpuProfileFile = "CE_GPU_PROFILE_FILE";
+constexpr const char *kEnvTraceFile = "CE_TRACE_FILE";
+constexpr const char *kEnvCaptureSequence = "CE_CAPTURE_SEQUENCE";
+constexpr const char *kEnvCaptureEvery = "CE_CAPTURE_EVERY";
+constexpr const char *kEnvCaptureBuffers = "CE_CAPTURE_BUFFERS";
+constexpr uint32_t kDefaultCaptureBuffers = 4;
+constexpr const char *kEnvCheckpoint = "CE_CHECKPOINT";
+constexpr const char *kEnvCheckpointEvery = "CE_CHECKPOINT_EVERY";
+constexpr const char *kEnvCheckpointRestore = "CE_CHECKPOINT_RESTORE";
+constexpr const char *kEnvDeltaStream = "CE_DELTA_STREAM";
+constexpr const char *kEnvDeltaKeyframeEvery = "CE_DELTA_KEYFRAME_EVERY";
+constexpr uint32_t kDefaultDeltaKeyframeEvery = 1024;
+constexpr const char *kEnvDeltaCapacity = "CE_DELTA_CAPACITY";
+constexpr const char *kEnvVerifyHashes = "CE_VERIFY_HASHES";
 
 enum class DrawOpId : uint8_t {
   Unknown = 0,
@@ -45,6 +73,12 @@ bool env_truthy(const char *value);
 // do not drift over time.
 bool env_flag_enabled(const char *name);
 
+// Reads an environment variable by name as an unsigned decimal integer.
+//
+// Returns default_value when the variable is unset, empty, or not a valid
+// 32-bit unsigned number.
+uint32_t env_uint(const char *name, uint32_t default_value);
+
 struct PipelineExecutionPlan {
   std::vector<std::string> pre_graphics_compute{};
   std::vector<std::string> graphics{};
@@ -153,6 +187,9 @@ void set_pipeline_execution_plan(const PipelineExecutionPlan &plan);
 const PipelineExecutionPlan *get_pipeline_execution_plan();
 void set_render_graph(const RenderGraph &graph);
 const RenderGraph *get_render_graph();
+// Bumped by every setter that changes what gets drawn or dispatched, so recorders can keep
+// a compiled copy of the graph until it changes.
+uint64_t render_graph_revision();
 
 void set_pipeline_definitions(
   const std::unordered_map<std::string, PipelineDefinition> &definitions);
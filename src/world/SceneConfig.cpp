@@ -14,6 +14,7 @@ constexpr int kMaxRenderStage = 5;
 constexpr const char *kDefaultPreset = "default";
 constexpr const char *kPresetComputeOnly = "compute_only";
 constexpr const char *kPresetComputeChain = "compute_chain";
+constexpr const char *kPresetConway = "conway";
 constexpr const char *kEnvPreComputePipelines = "CE_SCENE_PRECOMPUTE";
 constexpr const char *kEnvGraphicsPipelines = "CE_SCENE_GRAPHICS";
 constexpr const char *kEnvPostComputePipelines = "CE_SCENE_POSTCOMPUTE";
@@ -31,6 +32,7 @@ const std::vector<std::string> kStage3GraphicsPipelines = {"Sky", "Landscape", "
 const std::vector<std::string> kStage4GraphicsPipelines = {
     "Sky", "Landscape", "TerrainBox", "Cells", "CellsFollower"};
 const std::vector<std::string> kStage4PreComputePipelines = {"Engine"};
+const std::vector<std::string> kConwayPreComputePipelines = {"ConwayPack", "Conway", "ConwayUnpack"};
 
 int parse_render_stage() {
   const char *raw = std::getenv("CE_RENDER_STAGE");
@@ -271,6 +273,51 @@ SceneConfig SceneConfig::defaults() {
       .shaders = {"SeedCellsComp"},
       .work_groups = {0, 0, 0},
   };
+  spec.pipelines["CellCull"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"CellCullComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["CellDelta"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"CellDeltaComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["CellHash"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"CellHashComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["TerrainBake"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"TerrainBakeComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["TerrainJumpFlood"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"TerrainJumpFloodComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["TerrainSurfaceBake"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"TerrainSurfaceBakeComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["ConwayPack"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"ConwayPackComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["Conway"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"ConwayComp"},
+      .work_groups = {0, 0, 0},
+  };
+  spec.pipelines["ConwayUnpack"] = CE::Runtime::PipelineDefinition{
+      .is_compute = true,
+      .shaders = {"ConwayUnpackComp"},
+      .work_groups = {0, 0, 0},
+  };
 
     spec.assembly.resources = {
       CE::Runtime::ResourceDefinition{
@@ -282,14 +329,14 @@ SceneConfig SceneConfig::defaults() {
       CE::Runtime::ResourceDefinition{
         .name = "StorageBufferIn",
         .type = "ssbo",
-        .input = "World::Grid::cells",
-        .output = "DescriptorSet[1]",
+        .input = "World::Grid::cells (position/color/states/alive streams)",
+        .output = "DescriptorSet[1,6,8,10]",
       },
       CE::Runtime::ResourceDefinition{
         .name = "StorageBufferOut",
         .type = "ssbo",
         .input = "Compute pipelines",
-        .output = "DescriptorSet[2]",
+        .output = "DescriptorSet[2,7,9,11]",
       },
       CE::Runtime::ResourceDefinition{
         .name = "StorageImage",
@@ -297,11 +344,56 @@ SceneConfig SceneConfig::defaults() {
         .input = "Swapchain image",
         .output = "DescriptorSet[4]",
       },
+      CE::Runtime::ResourceDefinition{
+        .name = "TerrainField",
+        .type = "ssbo",
+        .input = "TerrainBake/TerrainJumpFlood compute pipelines",
+        .output = "DescriptorSet[5]",
+      },
+      CE::Runtime::ResourceDefinition{
+        .name = "TerrainSurface",
+        .type = "ssbo",
+        .input = "TerrainSurfaceBake compute pipeline",
+        .output = "DescriptorSet[14], Landscape/TerrainBox/Cells vertex shaders",
+      },
+      CE::Runtime::ResourceDefinition{
+        .name = "ConwayBits",
+        .type = "ssbo",
+        .input = "ConwayPack/Conway compute pipelines",
+        .output = "DescriptorSet[12]",
+      },
+      CE::Runtime::ResourceDefinition{
+        .name = "VisibleCells",
+        .type = "ssbo",
+        .input = "CellCull compute pipeline",
+        .output = "DescriptorSet[13], Cells/CellsFollower indirect draw",
+      },
+      CE::Runtime::ResourceDefinition{
+        .name = "CellDelta",
+        .type = "ssbo",
+        .input = "CellDelta compute pipeline",
+        .output = "DescriptorSet[15,16], CE_DELTA_STREAM writer",
+      },
+      CE::Runtime::ResourceDefinition{
+        .name = "CellHash",
+        .type = "ssbo",
+        .input = "CellHash compute pipeline",
+        .output = "DescriptorSet[17], CE_VERIFY_HASHES comparison",
+      },
     };
 
     spec.assembly.shader_binaries = {
       CE::Runtime::ShaderBinaryRoute{.source = "shaders/Engine.comp", .binary = "shaders/EngineComp.spv"},
       CE::Runtime::ShaderBinaryRoute{.source = "shaders/SeedCells.comp", .binary = "shaders/SeedCells.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/CellCull.comp", .binary = "shaders/CellCull.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/CellDelta.comp", .binary = "shaders/CellDelta.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/CellHash.comp", .binary = "shaders/CellHash.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/TerrainBake.comp", .binary = "shaders/TerrainBake.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/TerrainJumpFlood.comp", .binary = "shaders/TerrainJumpFlood.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/TerrainSurfaceBake.comp", .binary = "shaders/TerrainSurfaceBake.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/ConwayPack.comp", .binary = "shaders/ConwayPack.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/Conway.comp", .binary = "shaders/Conway.comp.spv"},
+      CE::Runtime::ShaderBinaryRoute{.source = "shaders/ConwayUnpack.comp", .binary = "shaders/ConwayUnpack.comp.spv"},
       CE::Runtime::ShaderBinaryRoute{.source = "shaders/Landscape.vert", .binary = "shaders/LandscapeVert.spv"},
       CE::Runtime::ShaderBinaryRoute{.source = "shaders/Landscape.frag", .binary = "shaders/LandscapeFrag.spv"},
       CE::Runtime::ShaderBinaryRoute{.source = "shaders/Cells.vert", .binary = "shaders/CellsVert.spv"},
@@ -342,7 +434,8 @@ SceneConfig SceneConfig::defaults() {
       graphics_pipelines = kStage3GraphicsPipelines;
     }
     if (render_stage >= 4) {
-      pre_compute_pipelines = kStage4PreComputePipelines;
+      pre_compute_pipelines =
+          preset == kPresetConway ? kConwayPreComputePipelines : kStage4PreComputePipelines;
       graphics_pipelines = kStage4GraphicsPipelines;
     }
 
@@ -0,0 +1,67 @@
+#include "TerrainField.h"
+
+#include <algorithm>
+#include <cmath>
+
+float CE::TerrainField::hash21(const glm::vec2 p) {
+  return glm::fract(std::sin(glm::dot(p, glm::vec2(127.1f, 311.7f))) * 43758.5453f);
+}
+
+float CE::TerrainField::noise2(const glm::vec2 p) {
+  const glm::vec2 i = glm::floor(p);
+  const glm::vec2 f = glm::fract(p);
+  const float a = hash21(i);
+  const float b = hash21(i + glm::vec2(1.0f, 0.0f));
+  const float c = hash21(i + glm::vec2(0.0f, 1.0f));
+  const float d = hash21(i + glm::vec2(1.0f, 1.0f));
+  const glm::vec2 u = f * f * (3.0f - 2.0f * f);
+  return glm::mix(glm::mix(a, b, u.x), glm::mix(c, d, u.x), u.y);
+}
+
+float CE::TerrainField::fbm(glm::vec2 p) {
+  float value = 0.0f;
+  float amplitude = 0.5f;
+  for (int i = 0; i < 5; ++i) {
+    value += amplitude * noise2(p);
+    p = p * 2.02f + glm::vec2(11.5f, 7.2f);
+    amplitude *= 0.5f;
+  }
+  return value;
+}
+
+float CE::TerrainField::ridged_fbm(glm::vec2 p) {
+  float value = 0.0f;
+  float amplitude = 0.5f;
+  for (int i = 0; i < 5; ++i) {
+    const float n = noise2(p);
+    const float ridge = 1.0f - std::abs(2.0f * n - 1.0f);
+    value += ridge * amplitude;
+    p = p * 2.1f + glm::vec2(9.2f, 3.4f);
+    amplitude *= 0.5f;
+  }
+  return value;
+}
+
+float CE::TerrainField::height(const glm::vec2 p) {
+  // GLSL mat2 constructors are column-major; glm matches that convention.
+  const glm::mat2 rot = glm::mat2(0.866f, -0.5f, 0.5f, 0.866f);
+  const glm::vec2 pr = rot * p;
+  glm::vec2 q = pr * 0.065f;
+  const glm::vec2 warp = glm::vec2(fbm(q * 1.15f + glm::vec2(4.0f, 1.7f)),
+                                   fbm(q * 1.15f + glm::vec2(7.2f, 3.5f)));
+  q += warp * 0.75f;
+
+  const float broad = fbm(q * 0.62f) * 3.6f;
+  const float base = fbm(q * 1.05f) * 2.2f;
+  const float ridge = ridged_fbm(q * 2.0f) * 4.2f;
+  const float crags = std::pow(std::max(ridged_fbm(q * 4.7f), 0.0f), 1.8f) * 1.15f;
+  const float macro = (std::sin(pr.x * 0.028f) + std::sin(pr.y * 0.024f)) * 0.85f;
+  const float detail = fbm(q * 7.6f) * 0.26f;
+
+  const float mountain_mask = glm::smoothstep(0.52f, 0.80f, ridged_fbm(q * 0.95f));
+  const float habitable_lowlands = broad + base + macro;
+  const float mountain_relief = ridge + crags + detail;
+  const float lowland_bias = -0.55f * (1.0f - mountain_mask);
+
+  return habitable_lowlands + mountain_relief * mountain_mask + lowland_bias + 1.35f;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Host-side port of shaders/TerrainField.glsl.
+// Exists so CPU simulation and bake paths sample the same terrain the shaders do.
+#include <glm/glm.hpp>
+
+namespace CE::TerrainField {
+
+float hash21(glm::vec2 p);
+float noise2(glm::vec2 p);
+float fbm(glm::vec2 p);
+float ridged_fbm(glm::vec2 p);
+
+// Mirrors terrain_height() in TerrainField.glsl; keep both in sync.
+float height(glm::vec2 p);
+
+} // namespace CE::TerrainField
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <limits>
 
 namespace {
@@ -37,28 +38,18 @@ uint32_t seeded_alive_count(const uint32_t grid_width,
 }
 } // namespace
 
-World::World(VkCommandBuffer &command_buffer,
-       const VkCommandPool &command_pool,
-       const VkQueue &queue,
-       const CE::Runtime::TerrainSettings &terrain_settings)
-    : _grid(terrain_settings,
-            command_buffer, command_pool, queue),
+World::World(CE::BaseUploader &uploader, const CE::Runtime::TerrainSettings &terrain_settings)
+    : _grid(terrain_settings, uploader),
       _rectangle(resolve_shape(CE::Runtime::get_world_settings().rectangle_shape,
              CE_RECTANGLE),
      true,
-     command_buffer,
-     command_pool,
-     queue),
+     uploader),
       _cube(resolve_shape(CE::Runtime::get_world_settings().cube_shape, CE_CUBE),
       false,
-      command_buffer,
-      command_pool,
-      queue),
-      _sky_dome(CE_SPHERE_HR,
-            false,
-            command_buffer,
-            command_pool,
-            queue),
+      uploader),
+      _sky_dome(CE_SPHERE_HR, false, uploader),
+      _cell_box(CE_BOX, false, uploader),
+      _cell_billboard(CE_BILLBOARD, false, uploader),
       _ubo(glm::vec4(CE::Runtime::get_world_settings().light_pos[0],
          CE::Runtime::get_world_settings().light_pos[1],
          CE::Runtime::get_world_settings().light_pos[2],
@@ -95,6 +86,9 @@ World::World(VkCommandBuffer &command_buffer,
       CE::Runtime::get_world_settings().arcball_distance_zoom_scale);
     _camera.set_preset_view(4);
 
+  if (!cell_box_lod()) {
+    Log::text("{ wWw }", "Cell mesh is no heavier than the box level; drawing two detail levels");
+  }
   Log::text("{ wWw }", "constructing World");
 }
 
@@ -102,19 +96,18 @@ World::~World() {
   Log::text("{ wWw }", "destructing World");
 }
 
+// Binding 0 is the compacted VisibleCell list (CellCull.comp), one entry per instance; 1 is
+// the shape of the detail level being drawn.
 std::vector<VkVertexInputBindingDescription> World::Cell::get_binding_description() {
   std::vector<VkVertexInputBindingDescription> description{
-      {0, sizeof(Cell), VK_VERTEX_INPUT_RATE_INSTANCE},
+      {0, sizeof(VisibleCell), VK_VERTEX_INPUT_RATE_INSTANCE},
       {1, sizeof(Shape::Vertex), VK_VERTEX_INPUT_RATE_VERTEX}};
   return description;
 }
 
 std::vector<VkVertexInputAttributeDescription> World::Cell::get_attribute_description() {
   std::vector<VkVertexInputAttributeDescription> description{
-      {0,
-       0,
-       VK_FORMAT_R32G32B32A32_SFLOAT,
-      static_cast<uint32_t>(offsetof(Cell, instance_position))},
+      {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(VisibleCell, position))},
       {1,
        1,
        VK_FORMAT_R32G32B32A32_SFLOAT,
@@ -123,15 +116,83 @@ std::vector<VkVertexInputAttributeDescription> World::Cell::get_attribute_descri
        1,
        VK_FORMAT_R32G32B32A32_SFLOAT,
        static_cast<uint32_t>(offsetof(Shape::Vertex, normal))},
-      {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(Cell, color))},
-      {4, 0, VK_FORMAT_R32G32B32A32_SINT, static_cast<uint32_t>(offsetof(Cell, states))}};
+      {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(VisibleCell, color))},
+      {4, 0, VK_FORMAT_R32_UINT, static_cast<uint32_t>(offsetof(VisibleCell, cell_index))},
+      {5, 0, VK_FORMAT_R32_UINT, static_cast<uint32_t>(offsetof(VisibleCell, lod))}};
   return description;
 };
 
+World::CellStreams::CellStreams(const size_t cell_count) : cell_count(cell_count) {
+  const auto align = [](const VkDeviceSize value) {
+    return (value + stream_alignment - 1) & ~(stream_alignment - 1);
+  };
+  const VkDeviceSize count = static_cast<VkDeviceSize>(cell_count);
+  position_offset = 0;
+  color_offset = align(position_offset + count * sizeof(glm::vec4));
+  states_offset = align(color_offset + count * sizeof(glm::vec4));
+  alive_offset = align(states_offset + count * sizeof(glm::ivec4));
+  // Rounded to whole words so the stream can also be viewed as uint[] when needed.
+  size = alive_offset + ((count + 3) & ~VkDeviceSize{3});
+}
+
+uint8_t World::CellStreams::encode_alive(const Cell &cell,
+                                         const uint32_t index,
+                                         const uint32_t grid_width) {
+  if (cell.states.x != 1) {
+    return dead;
+  }
+  const int32_t target = cell.states.y;
+  if (target < 0 || grid_width == 0) {
+    return static_cast<uint8_t>(no_target + 1);
+  }
+
+  // Targets are always picked within target_radius, so the offset fits a 9x9 code.
+  const int32_t width = static_cast<int32_t>(grid_width);
+  const int32_t dx = target % width - static_cast<int32_t>(index % grid_width);
+  const int32_t dy = target / width - static_cast<int32_t>(index / grid_width);
+  if (std::abs(dx) > target_radius || std::abs(dy) > target_radius) {
+    return static_cast<uint8_t>(no_target + 1);
+  }
+  const int32_t code = (dy + target_radius) * (2 * target_radius + 1) + (dx + target_radius);
+  return static_cast<uint8_t>(code + 1);
+}
+
+void World::CellStreams::pack(const std::vector<Cell> &cells,
+                              const uint32_t grid_width,
+                              void *destination) const {
+  uint8_t *base = static_cast<uint8_t *>(destination);
+  std::memset(base, 0, static_cast<size_t>(size));
+  glm::vec4 *positions = reinterpret_cast<glm::vec4 *>(base + position_offset);
+  glm::vec4 *colors = reinterpret_cast<glm::vec4 *>(base + color_offset);
+  glm::ivec4 *states = reinterpret_cast<glm::ivec4 *>(base + states_offset);
+  uint8_t *alive = base + alive_offset;
+
+  const size_t count = std::min(cells.size(), cell_count);
+  for (size_t i = 0; i < count; ++i) {
+    positions[i] = cells[i].instance_position;
+    colors[i] = cells[i].color;
+    states[i] = cells[i].states;
+    alive[i] = encode_alive(cells[i], static_cast<uint32_t>(i), grid_width);
+  }
+}
+
+std::vector<World::Cell> World::CellStreams::unpack(const void *source) const {
+  const uint8_t *base = static_cast<const uint8_t *>(source);
+  const glm::vec4 *positions = reinterpret_cast<const glm::vec4 *>(base + position_offset);
+  const glm::vec4 *colors = reinterpret_cast<const glm::vec4 *>(base + color_offset);
+  const glm::ivec4 *states = reinterpret_cast<const glm::ivec4 *>(base + states_offset);
+
+  std::vector<Cell> cells(cell_count);
+  for (size_t i = 0; i < cell_count; ++i) {
+    cells[i].instance_position = positions[i];
+    cells[i].color = colors[i];
+    cells[i].states = states[i];
+  }
+  return cells;
+}
+
 World::Grid::Grid(const CE::Runtime::TerrainSettings &terrain_settings,
-          VkCommandBuffer &command_buffer,
-          const VkCommandPool &command_pool,
-                  const VkQueue &queue)
+                  CE::BaseUploader &uploader)
   : size(glm::ivec2(std::max(terrain_settings.grid_width, 2),
                      std::max(terrain_settings.grid_height, 2))),
     initial_alive_cells(terrain_settings.alive_cells),
@@ -304,10 +365,10 @@ World::Grid::Grid(const CE::Runtime::TerrainSettings &terrain_settings,
   box_indices.push_back(bottom_base + 3);
   box_indices.push_back(bottom_base + 2);
 
-  create_vertex_buffer(command_buffer, command_pool, queue, unique_vertices);
-  create_index_buffer(command_buffer, command_pool, queue, indices);
-  create_vertex_buffer(command_buffer, command_pool, queue, box_vertices, box_vertex_buffer);
-  create_index_buffer(command_buffer, command_pool, queue, box_indices, box_index_buffer);
+  create_vertex_buffer(uploader, unique_vertices);
+  create_index_buffer(uploader, indices);
+  create_vertex_buffer(uploader, box_vertices, box_vertex_buffer);
+  create_index_buffer(uploader, box_indices, box_index_buffer);
 }
 
 std::vector<VkVertexInputAttributeDescription> World::Grid::get_attribute_description() {
@@ -17,16 +17,12 @@
 
 class World {
 public:
-	World(VkCommandBuffer &command_buffer,
-				const VkCommandPool &command_pool,
-				const VkQueue &queue,
-				const CE::Runtime::TerrainSettings &terrain_settings);
+	World(CE::BaseUploader &uploader, const CE::Runtime::TerrainSettings &terrain_settings);
 	~World();
 
+	// Host-side view of one cell. On the GPU the same data lives as separate streams (CellStreams).
 	struct alignas(16) Cell {
 		glm::vec4 instance_position{};
-		glm::vec4 vertex_position{};
-		glm::vec4 normal{};
 		glm::vec4 color{};
 		glm::ivec4 states{};
 
@@ -34,6 +30,52 @@ public:
 		static std::vector<VkVertexInputAttributeDescription> get_attribute_description();
 	};
 
+	// Structure-of-arrays layout of one cell storage buffer; mirrors shaders/CellStreams.glsl.
+	// The alive stream packs alive + target into one byte so neighbour scans stay in cache.
+	struct CellStreams {
+		static constexpr VkDeviceSize stream_alignment = 256;
+		static constexpr uint8_t dead = 0;
+		static constexpr int32_t target_radius = 4;
+		static constexpr uint8_t no_target = 81;
+
+		VkDeviceSize position_offset{};
+		VkDeviceSize color_offset{};
+		VkDeviceSize states_offset{};
+		VkDeviceSize alive_offset{};
+		VkDeviceSize size{};
+		size_t cell_count{};
+
+		explicit CellStreams(size_t cell_count);
+
+		static uint8_t encode_alive(const Cell &cell, uint32_t index, uint32_t grid_width);
+		void pack(const std::vector<Cell> &cells, uint32_t grid_width, void *destination) const;
+		std::vector<Cell> unpack(const void *source) const;
+	};
+
+	// Matches TerrainSample in shaders/TerrainFieldBuffer.glsl (std430, 16 bytes).
+	struct alignas(16) TerrainSample {
+		float height{};
+		uint32_t flags{};
+		int32_t nearest_shore{-1};
+		int32_t nearest_land{-1};
+
+		static constexpr uint32_t underwater = 1u;
+		static constexpr uint32_t shoreline = 2u;
+	};
+
+	// Cell draw detail levels, nearest first: _cube, _cell_box, _cell_billboard. Mirrors
+	// CELL_LOD_COUNT in shaders/CellLod.glsl.
+	static constexpr uint32_t cell_lod_count = 3;
+
+	// One entry of the compacted draw list CellCull.comp writes; matches VisibleCell in
+	// shaders/VisibleCells.glsl (std430, 48 bytes). Only alive, on-screen cells get one.
+	struct alignas(16) VisibleCell {
+		glm::vec4 position{};
+		glm::vec4 color{};
+		uint32_t cell_index{};
+		uint32_t lod{};
+	};
+
 	using UniformBufferObject = CE::ShaderInterface::ParameterUBO;
 
 	struct Grid : public Geometry {
@@ -49,10 +91,7 @@ public:
 		CE::BaseBuffer box_vertex_buffer;
 		CE::BaseBuffer box_index_buffer;
 
-				Grid(const CE::Runtime::TerrainSettings &terrain_settings,
-					VkCommandBuffer &command_buffer,
-					const VkCommandPool &command_pool,
-					const VkQueue &queue);
+				Grid(const CE::Runtime::TerrainSettings &terrain_settings, CE::BaseUploader &uploader);
 		static std::vector<VkVertexInputAttributeDescription> get_attribute_description();
 
 	private:
@@ -62,6 +101,15 @@ public:
 	Shape _rectangle;
 	Shape _cube;
 	Shape _sky_dome;
+	// Cell detail levels below _cube: a 12-triangle box, then a camera-facing quad.
+	Shape _cell_box;
+	Shape _cell_billboard;
+
+	// Whether _cell_box is lighter than _cube. The procedural cube fallback (no Cube.obj)
+	// already is that box, and CellCull then keeps mid-range cells on _cube: two levels.
+	bool cell_box_lod() const {
+		return _cube.all_vertices.size() > _cell_box.all_vertices.size();
+	}
 
 	UniformBufferObject _ubo;
 	Camera _camera;